@@ -0,0 +1,324 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: ascii_chunk.cpp
+//
+// Class definitions:
+//   Ascii_Chunk -- Chunk of an ASCII data block
+//
+// Classes referenced: none
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <ascii_chunk.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "ascii_chunk.h"
+
+// Exact powers of ten for parse_double
+static const double powers_of_ten[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Whitespace as seen by the >> operator
+static inline int is_white( char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' ||
+         c == '\v' || c == '\f';
+}
+
+//***************************************************************************
+// Ascii_Chunk::Ascii_Chunk() -- Default constructor clears everything.
+Ascii_Chunk::Ascii_Chunk() : pBegin( NULL), pEnd( NULL), nvars( 0),
+  hasSelectionInfo( 0), delimiter_char( ' '), bad_value_proxy( 0.0),
+  nLines( 0), nSkipped( 0), nTested( 0), nRows( 0), nRowsMax( 0)
+{}
+
+//***************************************************************************
+// Ascii_Chunk::parse_task( pUser, iTask) -- Static Worker_Pool task.  PUSER
+// points to an array of Ascii_Chunk objects; parse element ITASK.
+void Ascii_Chunk::parse_task( void* pUser, int iTask)
+{
+  ((Ascii_Chunk*) pUser)[ iTask].parse();
+}
+
+//***************************************************************************
+// Ascii_Chunk::parse() -- Count the lines in the chunk to size the output
+// buffers, then parse the chunk line by line.
+void Ascii_Chunk::parse()
+{
+  nLines = nSkipped = nTested = nRows = 0;
+
+  // Count lines.  The last line may lack a newline.
+  nRowsMax = 0;
+  for( const char* p = pBegin; p < pEnd; ) {
+    const char* pNewline = (const char*) memchr( p, '\n', pEnd-p);
+    nRowsMax++;
+    if( pNewline == NULL) break;
+    p = pNewline+1;
+  }
+
+  // Allocate buffers.  NOTE: The value of the last column is always stored
+  // in VALUES, even if it holds selection information, to keep indexing
+  // simple.
+  values.resize( (size_t) nvars * nRowsMax);
+  if( hasSelectionInfo) selection.resize( nRowsMax);
+  ascii_codes.resize( nvars);
+  ascii_tokens.resize( nvars);
+
+  // Loop: Parse successive lines
+  const char* p = pBegin;
+  while( p < pEnd) {
+    const char* pLineEnd = (const char*) memchr( p, '\n', pEnd-p);
+    if( pLineEnd == NULL) pLineEnd = pEnd;
+    if( parse_line( p, pLineEnd) == 0) nRows++;
+    nLines++;
+    p = pLineEnd+1;
+  }
+}
+
+//***************************************************************************
+// Ascii_Chunk::parse_line( pLine, pLineEnd) -- Parse one line and store its
+// values as row nRows.  Returns 0 if the row is good, nonzero if it is to
+// be skipped.  Follows the rules of the stringstream-based reader this
+// replaces: blank lines and lines that start with one of '!#%' are skipped;
+// in whitespace-delimited files, tokens are separated by runs of
+// whitespace; otherwise fields are separated by the delimiter, trimmed of
+// blanks, and empty fields and fields that start with 'NaN' are replaced by
+// the bad value proxy; lines with too few values are skipped; and lines
+// with a value less than -90e99 are skipped.  In addition, lines that
+// contain control characters are taken to be unreadable (binary) data.
+int Ascii_Chunk::parse_line( const char* pLine, const char* pLineEnd)
+{
+  // Skip blank lines and comment lines
+  if( pLine == pLineEnd || *pLine == '!' || *pLine == '#' || *pLine == '%') {
+    nSkipped++;
+    return 1;
+  }
+  nTested++;
+  if( hasSelectionInfo) selection[ nRows] = 0;
+
+  // Check for unreadable (binary) data
+  for( const char* p = pLine; p < pLineEnd; p++) {
+    unsigned char c = (unsigned char) *p;
+    if( c < 0x20 && !is_white( *p)) {
+      unreadable_lines.push_back( nLines);
+      unreadable_tested.push_back( nTested-1);
+      return 1;
+    }
+  }
+
+  // If the delimiter character is not a tab, tabs are treated as blanks
+  char delimiter = delimiter_char;
+  int tabIsBlank = ( delimiter != '\t');
+
+  // Loop: Extract successive values.  IS_EOF mimics the end-of-file flag of
+  // the stringstream used by the original reader.
+  const char* p = pLine;
+  int is_eof = 0;
+  for( int j=0; j<nvars; j++) {
+    const char* pToken = NULL;
+    const char* pTokenEnd = NULL;
+    int failed = 0;
+
+    // Get the next token or field.  NOTE: whitespace-delimited and
+    // character-delimited files must be handled differently.
+    if( delimiter == ' ') {
+      while( p < pLineEnd && is_white( *p)) p++;
+      if( p == pLineEnd) {
+        failed = 1;
+        is_eof = 1;
+      }
+      else {
+        pToken = p;
+        while( p < pLineEnd && !is_white( *p)) p++;
+        pTokenEnd = p;
+        if( p == pLineEnd) is_eof = 1;
+      }
+    }
+    else {
+      if( is_eof || p == pLineEnd) {
+        failed = 1;
+        is_eof = 1;
+      }
+      else {
+        const char* pDelimiter =
+          (const char*) memchr( p, delimiter, pLineEnd-p);
+        if( pDelimiter == NULL) {
+          pToken = p;
+          pTokenEnd = pLineEnd;
+          p = pLineEnd;
+          is_eof = 1;
+        }
+        else {
+          pToken = p;
+          pTokenEnd = pDelimiter;
+          p = pDelimiter+1;
+        }
+
+        // Trim blanks
+        while( pToken < pTokenEnd &&
+               ( *pToken == ' ' || ( tabIsBlank && *pToken == '\t')))
+          pToken++;
+        while( pTokenEnd > pToken &&
+               ( *(pTokenEnd-1) == ' ' ||
+                 ( tabIsBlank && *(pTokenEnd-1) == '\t')))
+          pTokenEnd--;
+      }
+    }
+
+    // Skip lines that don't appear to contain enough data
+    if( is_eof && j<nvars-1) {
+      short_lines.push_back( nLines);
+      return 1;
+    }
+
+    // Missing values become the bad value proxy, except for selection
+    // information, which stays unselected.
+    int isSelection = ( hasSelectionInfo && j == nvars-1);
+    float* pValue = &values[ (size_t) j * nRowsMax + nRows];
+    if( failed) {
+      *pValue = bad_value_proxy;
+      continue;
+    }
+
+    // If this is numerical data, parse it directly, otherwise find the
+    // code for this ASCII value.  In delimited files the ASCII value is the
+    // first word of the field.
+    if( hasASCII[ j] == 0 || isSelection) {
+      double xValue = bad_value_proxy;
+      if( pTokenEnd > pToken &&
+          !( pTokenEnd-pToken >= 3 && strncmp( pToken, "NaN", 3) == 0)) {
+        if( parse_double( pToken, pTokenEnd, xValue) == 0)
+          xValue = bad_value_proxy;
+      }
+      if( isSelection) selection[ nRows] = (int) xValue;
+      *pValue = (float) xValue;
+    }
+    else {
+      if( delimiter != ' ') {
+        while( pToken < pTokenEnd && is_white( *pToken)) pToken++;
+        const char* pWordEnd = pToken;
+        while( pWordEnd < pTokenEnd && !is_white( *pWordEnd)) pWordEnd++;
+        pTokenEnd = pWordEnd;
+      }
+      sToken_.assign( pToken, pTokenEnd-pToken);
+      *pValue = (float) local_code( j, sToken_);
+    }
+  }
+
+  // Check for bad data flags and flag this line to be skipped
+  int nStored = nvars;
+  if( hasSelectionInfo) nStored--;
+  for( int j=0; j<nStored; j++) {
+    if( values[ (size_t) j * nRowsMax + nRows] < -90e99) {
+      flagged_lines.push_back( nLines);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+//***************************************************************************
+// Ascii_Chunk::local_code( j, sToken) -- Return the code of an ASCII value
+// in this chunk's dictionary for column j, adding it if it is new.  Codes
+// are assigned in order of appearance, as in Column_Info::add_value().
+int Ascii_Chunk::local_code( int j, const string &sToken)
+{
+  map<string,int>::iterator iter = ascii_codes[ j].find( sToken);
+  if( iter != ascii_codes[ j].end()) return iter->second;
+  int nValues = ascii_tokens[ j].size();
+  ascii_codes[ j].insert( map<string,int>::value_type( sToken, nValues));
+  ascii_tokens[ j].push_back( sToken);
+  return nValues;
+}
+
+//***************************************************************************
+// Ascii_Chunk::parse_double( p, pEnd, x) -- Parse the number at the start
+// of [p, pEnd) without allocating memory.  Like the >> operator, leading
+// whitespace is skipped and trailing characters are ignored.  Returns 1 and
+// sets X if a number was found, returns 0 otherwise.  Mantissas of up to 19
+// significant digits and exponents of up to 22 are converted exactly;
+// anything else is handed to strtod.
+int Ascii_Chunk::parse_double( const char* p, const char* pEnd, double &x)
+{
+  while( p < pEnd && is_white( *p)) p++;
+  const char* pStart = p;
+
+  // Sign
+  int isNegative = 0;
+  if( p < pEnd && ( *p == '-' || *p == '+')) {
+    isNegative = ( *p == '-');
+    p++;
+  }
+
+  // Mantissa
+  unsigned long long mantissa = 0;
+  int nSignificant = 0, nDigits = 0, exponent = 0;
+  for( ; p < pEnd && *p >= '0' && *p <= '9'; p++) {
+    nDigits++;
+    if( nSignificant < 19) {
+      mantissa = 10*mantissa + (*p - '0');
+      if( mantissa > 0) nSignificant++;
+    }
+    else exponent++;
+  }
+  if( p < pEnd && *p == '.') {
+    for( p++; p < pEnd && *p >= '0' && *p <= '9'; p++) {
+      nDigits++;
+      if( nSignificant < 19) {
+        mantissa = 10*mantissa + (*p - '0');
+        if( mantissa > 0) nSignificant++;
+        exponent--;
+      }
+    }
+  }
+  if( nDigits == 0) return 0;
+
+  // Exponent.  An 'e' that isn't followed by digits isn't part of the
+  // number.
+  if( p < pEnd && ( *p == 'e' || *p == 'E')) {
+    const char* q = p+1;
+    int isNegativeExponent = 0;
+    if( q < pEnd && ( *q == '-' || *q == '+')) {
+      isNegativeExponent = ( *q == '-');
+      q++;
+    }
+    if( q < pEnd && *q >= '0' && *q <= '9') {
+      int e = 0;
+      for( ; q < pEnd && *q >= '0' && *q <= '9'; q++)
+        if( e < 100000) e = 10*e + (*q - '0');
+      exponent += isNegativeExponent ? -e : e;
+      p = q;
+    }
+  }
+
+  // Convert.  Mantissas below 2^53 are exact doubles, as are powers of ten
+  // up to 1e22, so one multiplication or division rounds correctly.
+  if( mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+    x = (double) mantissa;
+    if( exponent >= 0) x *= powers_of_ten[ exponent];
+    else x /= powers_of_ten[ -exponent];
+    if( isNegative) x = -x;
+    return 1;
+  }
+
+  // Otherwise copy the number to a buffer on the stack and use strtod
+  char cBuf[ 128];
+  int nChars = p - pStart;
+  if( nChars > 127) nChars = 127;
+  memcpy( cBuf, pStart, nChars);
+  cBuf[ nChars] = '\0';
+  x = strtod( cBuf, NULL);
+  return 1;
+}
@@ -0,0 +1,108 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: ascii_chunk.h
+//
+// Class definitions:
+//   Ascii_Chunk -- Chunk of an ASCII data block
+//
+// Classes referenced: none
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Parse a newline-aligned chunk of the data block of an ASCII file
+//   into column-major buffers.  Used by Data_File_Manager to parse several
+//   chunks at once on different threads.
+//
+// General design philosophy:
+//   1) A chunk never touches globals or the Column_Info objects, so any
+//      number of chunks can be parsed at the same time.
+//   2) Each chunk keeps its own dictionary of ASCII values, with codes in
+//      order of first appearance in the chunk.  Data_File_Manager merges
+//      these, chunk by chunk, into the dictionary of each Column_Info
+//      object, which reproduces the codes a sequential read would have
+//      produced.
+//   3) The rules for tokens, missing values, NaNs, short lines, and bad
+//      data flags are those of the original stringstream-based reader.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef ASCII_CHUNK_H
+#define ASCII_CHUNK_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+//***************************************************************************
+// Class: Ascii_Chunk
+//
+// Class definitions:
+//   Ascii_Chunk -- Chunk of an ASCII data block
+//
+// Classes referenced: none
+//
+// Purpose: Hold the input, parameters, and results for one chunk of an
+//   ASCII data block.
+//
+// Functions:
+//   Ascii_Chunk() -- Default constructor
+//   parse() -- Parse the chunk
+//   parse_task( pUser, iTask) -- Worker_Pool task to parse chunk iTask
+//   parse_double( p, pEnd, x) -- Parse a number without allocating memory
+//   local_code( j, sToken) -- Local code of an ASCII value in column j
+//***************************************************************************
+class Ascii_Chunk
+{
+  protected:
+    int parse_line( const char* pLine, const char* pLineEnd);
+    int local_code( int j, const string &sToken);
+    string sToken_;   // Reused to avoid allocating memory for every token
+
+  public:
+    Ascii_Chunk();
+    void parse();
+    static void parse_task( void* pUser, int iTask);
+    static int parse_double( const char* p, const char* pEnd, double &x);
+
+    // Text to be parsed, [pBegin, pEnd).  Must start at the beginning of a
+    // line and end at the end of one.
+    const char* pBegin;
+    const char* pEnd;
+
+    // Parameters, copied from the Data_File_Manager.  The last of the NVARS
+    // columns holds selection information if hasSelectionInfo is set.
+    int nvars;
+    int hasSelectionInfo;
+    char delimiter_char;
+    float bad_value_proxy;
+    std::vector<int> hasASCII;
+
+    // Accounting information.  nTested counts lines that were neither
+    // blank nor comments.
+    int nLines, nSkipped, nTested, nRows;
+
+    // Parsed data.  Column j of row i is values[ j*nRowsMax + i].
+    int nRowsMax;
+    std::vector<float> values;
+    std::vector<int> selection;
+
+    // Dictionaries of ASCII values for each column, in order of appearance
+    std::vector< std::map<string,int> > ascii_codes;
+    std::vector< std::vector<string> > ascii_tokens;
+
+    // Lines (counted from the start of the chunk) that had too little data,
+    // a bad data flag, or unreadable (binary) characters, and the index
+    // among tested lines of each unreadable line.
+    std::vector<int> short_lines;
+    std::vector<int> flagged_lines;
+    std::vector<int> unreadable_lines;
+    std::vector<int> unreadable_tested;
+};
+
+#endif   // ASCII_CHUNK_H
@@ -0,0 +1,209 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: auto_binning.cpp
+//
+// Class definitions:
+//   Auto_Binning -- Automatic choice of the number of histogram bins
+//
+// Classes referenced:
+//   Histogram_Kernel -- Threaded binning of the points of one axis
+//   Rank_Engine -- Radix sort ranking engine
+//
+// Required packages
+//    Blitz++ 0.9 -- Various math routines
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <auto_binning.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "auto_binning.h"
+#include "histogram_kernel.h"
+#include "rank_engine.h"
+
+// Number of grid cells per candidate bin at the largest bin count
+static const int CELLS_PER_BIN = 64;
+
+//***************************************************************************
+// Auto_Binning::optimal_bins( method, values, order, n, xmin, range,
+// nbinsMin, nbinsMax) -- Static method to return the best number of bins,
+// between NBINSMIN and NBINSMAX, for the histogram of the first N VALUES,
+// whose sorted order is ORDER, with bins starting at XMIN that cover RANGE,
+// by rule METHOD.  Only finite values count.  Returns 0 if there are no 
+// points or no rule.
+int Auto_Binning::optimal_bins(
+  int method, const blitz::Array<float,1> &values,
+  const blitz::Array<int,1> &order, int n, float xmin, float range,
+  int nbinsMin, int nbinsMax)
+{
+  if( n <= 0 || values.rows() < n || order.rows() < n) return 0;
+  if( nbinsMin < 1) nbinsMin = 1;
+  if( nbinsMax < nbinsMin) nbinsMax = nbinsMin;
+  if( !is_finite( range) || !( range > 0.0)) return nbinsMin;
+
+  // Find the finite values, which lie between -Inf and +Inf or NaN
+  int iBegin, iEnd;
+  Rank_Engine::finite_range(
+    values.data(), values.stride( 0), order.data(), n, iBegin, iEnd);
+  if( iEnd <= iBegin) return nbinsMin;
+
+  // The Freedman-Diaconis rule is undefined if half the points are equal
+  if( method == FREEDMAN_DIACONIS) {
+    int nbins = freedman_diaconis_bins(
+      values, order, iBegin, iEnd, range, nbinsMin, nbinsMax);
+    if( nbins > 0) return nbins;
+    method = KNUTH;
+  }
+  if( method == KNUTH) {
+    return knuth_bins(
+      values, order, iBegin, iEnd, xmin, range, nbinsMin, nbinsMax);
+  }
+  return 0;
+}
+
+//***************************************************************************
+// Auto_Binning::knuth_bins( values, order, iBegin, iEnd, xmin, range,
+// nbinsMin, nbinsMax) -- Static method to return the number of bins 
+// between NBINSMIN and NBINSMAX with the largest posterior probability by 
+// Knuth's rule for the VALUES whose sorted order is ORDER( IBEGIN), ..., 
+// ORDER( IEND-1), which must be finite.
+int Auto_Binning::knuth_bins(
+  const blitz::Array<float,1> &values, const blitz::Array<int,1> &order,
+  int iBegin, int iEnd, float xmin, float range, int nbinsMin, int nbinsMax)
+{
+  int n = iEnd - iBegin;
+
+  // Use a grid with a power of two cells, so the edges of power-of-two bin
+  // counts fall on it
+  int nCells = CELLS_PER_BIN;
+  while( nCells < CELLS_PER_BIN * nbinsMax) nCells *= 2;
+  std::vector<double> cumulative;
+  cumulative_counts(
+    values, order, iBegin, iEnd, xmin, range, nCells, cumulative);
+
+  // Loop: Evaluate the posterior of every candidate
+  int bestBins = nbinsMin;
+  double bestPosterior = 0.0;
+  for( int nbins=nbinsMin; nbins<=nbinsMax; nbins++) {
+    double posterior = knuth_log_posterior( cumulative, nCells, n, nbins);
+    if( nbins == nbinsMin || posterior > bestPosterior) {
+      bestBins = nbins;
+      bestPosterior = posterior;
+    }
+  }
+  return bestBins;
+}
+
+//***************************************************************************
+// Auto_Binning::freedman_diaconis_bins( values, order, iBegin, iEnd, range,
+// nbinsMin, nbinsMax) -- Static method to return the number of bins of 
+// width 2 IQR / N^(1/3) that cover RANGE, clamped to NBINSMIN...NBINSMAX, 
+// or 0 if the interquartile range is zero.  The N points are the VALUES 
+// whose sorted order is ORDER( IBEGIN), ..., ORDER( IEND-1), which must be 
+// finite.
+int Auto_Binning::freedman_diaconis_bins(
+  const blitz::Array<float,1> &values, const blitz::Array<int,1> &order,
+  int iBegin, int iEnd, float range, int nbinsMin, int nbinsMax)
+{
+  int n = iEnd - iBegin;
+  double iqr =
+    values( order( iBegin + (int) ( ( 3 * (long long) n) / 4))) -
+    values( order( iBegin + n / 4));
+  if( n < 4) iqr = values( order( iEnd-1)) - values( order( iBegin));
+  double width = 2.0 * iqr / cbrt( (double) n);
+  if( !( width > 0.0)) return 0;
+
+  // A very narrow IQR can overflow the bin count, so clamp it before it is
+  // converted to int
+  double nbins = ceil( range / width);
+  if( !is_finite( (float) nbins) || nbins > nbinsMax) return nbinsMax;
+  if( nbins < nbinsMin) return nbinsMin;
+  return (int) nbins;
+}
+
+//***************************************************************************
+// Auto_Binning::cumulative_counts( values, order, iBegin, iEnd, xmin, range,
+// nCells, cumulative) -- Static method to set CUMULATIVE[ c], 
+// c = 0...nCells, to the number of the VALUES whose sorted order is 
+// ORDER( IBEGIN), ..., ORDER( IEND-1) that are in the first c of NCELLS
+// equi-width cells starting at XMIN that cover RANGE.  These values must be
+// finite, so their cells never decrease along ORDER.  Large data sets are
+// searched in this order, small ones are binned directly.
+void Auto_Binning::cumulative_counts(
+  const blitz::Array<float,1> &values, const blitz::Array<int,1> &order,
+  int iBegin, int iEnd, float xmin, float range, int nCells,
+  std::vector<double> &cumulative)
+{
+  int n = iEnd - iBegin;
+  float scale = nCells / range;
+  cumulative.assign( nCells+1, 0.0);
+
+  // Small data sets: count the points of each cell and add them up
+  if( n <= 16 * nCells) {
+    for( int i=iBegin; i<iEnd; i++) {
+      int cell = Histogram_Kernel::equi_width_bin(
+        values( order( i)), xmin, scale, nCells);
+      cumulative[ cell+1] += 1.0;
+    }
+    for( int cell=1; cell<=nCells; cell++) {
+      cumulative[ cell] += cumulative[ cell-1];
+    }
+    return;
+  }
+
+  // Large data sets: Loop: Find the first point of each cell after the
+  // first, searching only the points after the first point of the previous
+  // cell
+  int iFirst = iBegin;
+  for( int cell=1; cell<nCells; cell++) {
+    int iLow = iFirst, iHigh = iEnd;
+    while( iLow < iHigh) {
+      int iMid = iLow + ( iHigh-iLow)/2;
+      int midCell = Histogram_Kernel::equi_width_bin(
+        values( order( iMid)), xmin, scale, nCells);
+      if( midCell < cell) iLow = iMid+1;
+      else iHigh = iMid;
+    }
+    cumulative[ cell] = iLow - iBegin;
+    iFirst = iLow;
+  }
+  cumulative[ nCells] = n;
+}
+
+//***************************************************************************
+// Auto_Binning::knuth_log_posterior( cumulative, nCells, n, nbins) --
+// Static method to return the log of the (unnormalized) posterior
+// probability of NBINS equi-width bins for N points with cumulative
+// counts CUMULATIVE on a grid of NCELLS cells.  Edges between the edges of
+// the grid get linearly interpolated counts.
+double Auto_Binning::knuth_log_posterior(
+  const std::vector<double> &cumulative, int nCells, int n, int nbins)
+{
+  double posterior =
+    n * log( (double) nbins) + lgamma( 0.5 * nbins) -
+    nbins * lgamma( 0.5) - lgamma( n + 0.5 * nbins);
+
+  // Loop: Add the term of each bin
+  double below = 0.0;
+  for( int bin=1; bin<=nbins; bin++) {
+    long long numerator = (long long) bin * nCells;
+    int cell = (int) ( numerator / nbins);
+    double fraction = (double) ( numerator % nbins) / nbins;
+    double atEdge = cumulative[ cell];
+    if( fraction > 0.0) {
+      atEdge += fraction * ( cumulative[ cell+1] - cumulative[ cell]);
+    }
+    posterior += lgamma( atEdge - below + 0.5);
+    below = atEdge;
+  }
+  return posterior;
+}
@@ -0,0 +1,114 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: auto_binning.h
+//
+// Class definitions:
+//   Auto_Binning -- Automatic choice of the number of histogram bins
+//
+// Classes referenced:
+//   Histogram_Kernel -- Threaded binning of the points of one axis
+//   Rank_Engine -- Radix sort ranking engine
+//
+// Required packages
+//    Blitz++ 0.9 -- Various math routines
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Choose the number of equi-width bins of a histogram from the
+//   data, using either Knuth's Bayesian rule (K.H. Knuth, "Optimal data-
+//   based binning for histograms", 2006) or the Freedman-Diaconis rule.
+//
+// General design philosophy:
+//   1) Knuth's rule picks the bin count M that maximizes the posterior
+//        N log M + lgamma( M/2) - M lgamma( 1/2) - lgamma( N + M/2)
+//          + sum_k lgamma( n_k + 1/2)
+//      where n_k is the number of points in bin k.  Every candidate M from
+//      nbinsMin to nbinsMax is tried.
+//   2) The counts n_k aren't found by binning the points for every M.
+//      Instead, the cumulative counts at the edges of a fine grid of
+//      equi-width cells are found once, by binary search of the sorted
+//      order of the axis (or, for small data sets, by binning the points
+//      once), and the counts of each candidate are differences of these.
+//      This makes each candidate O(M), so all candidates up to 1024 bins
+//      cost about half a million lgamma() calls, whatever the number of
+//      points.
+//   3) The grid has a power of two times 64 cells, so for bin counts that
+//      are powers of two, as set by the bin count sliders, the edges fall on
+//      the grid and the counts are exact.  Other edges are interpolated,
+//      which is good enough to compare candidates.
+//   4) The Freedman-Diaconis rule uses bins of width 2 IQR / N^(1/3), where
+//      the interquartile range IQR is read off the sorted order.  It is
+//      undefined if IQR is zero, in which case Knuth's rule is used.
+//   5) Points are binned exactly as by the Histogram_Kernel, so the grid
+//      agrees with the histograms that are drawn.  Weights are ignored.
+//   6) Only the finite values count.  They are a contiguous part of the
+//      sorted order, found by Rank_Engine::finite_range(), and N is their
+//      number.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef AUTO_BINNING_H
+#define AUTO_BINNING_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+//***************************************************************************
+// Class: Auto_Binning
+//
+// Class definitions:
+//   Auto_Binning -- Automatic choice of the number of histogram bins
+//
+// Classes referenced:
+//   Histogram_Kernel
+//   Rank_Engine
+//
+// Purpose: Static methods to find the best number of bins for the
+//   histogram of a sorted axis.
+//
+// Functions:
+//   optimal_bins( method, values, order, n, xmin, range, nbinsMin,
+//     nbinsMax) -- Best number of bins by the given rule
+//   knuth_bins( values, order, iBegin, iEnd, xmin, range, nbinsMin,
+//     nbinsMax) -- Best number of bins by Knuth's rule
+//   freedman_diaconis_bins( values, order, iBegin, iEnd, range, nbinsMin,
+//     nbinsMax) -- Number of bins by the Freedman-Diaconis rule
+//   cumulative_counts( values, order, iBegin, iEnd, xmin, range, nCells,
+//     cumulative) -- Number of points below the edges of a grid
+//   knuth_log_posterior( cumulative, nCells, n, nbins) -- Log of the
+//     posterior probability of a bin count
+//***************************************************************************
+class Auto_Binning
+{
+  public:
+    // Rules to choose the number of bins
+    enum methods {
+      NONE = 0,
+      KNUTH,
+      FREEDMAN_DIACONIS
+    };
+
+    static int optimal_bins(
+      int method, const blitz::Array<float,1> &values,
+      const blitz::Array<int,1> &order, int n, float xmin, float range,
+      int nbinsMin, int nbinsMax);
+    static int knuth_bins(
+      const blitz::Array<float,1> &values, const blitz::Array<int,1> &order,
+      int iBegin, int iEnd, float xmin, float range,
+      int nbinsMin, int nbinsMax);
+    static int freedman_diaconis_bins(
+      const blitz::Array<float,1> &values, const blitz::Array<int,1> &order,
+      int iBegin, int iEnd, float range, int nbinsMin, int nbinsMax);
+
+  protected:
+    static void cumulative_counts(
+      const blitz::Array<float,1> &values, const blitz::Array<int,1> &order,
+      int iBegin, int iEnd, float xmin, float range, int nCells,
+      std::vector<double> &cumulative);
+    static double knuth_log_posterior(
+      const std::vector<double> &cumulative, int nCells, int n, int nbins);
+};
+
+#endif   // AUTO_BINNING_H
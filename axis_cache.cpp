@@ -0,0 +1,271 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: axis_cache.cpp
+//
+// Class definitions:
+//   Axis_Cache -- Cache of normalized axes
+//
+// Classes referenced: none
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <axis_cache.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "axis_cache.h"
+#include "rank_engine.h"
+
+// Cached axes and a counter used to find the least recently used one
+static std::vector<Normalized_Axis> cached_axes;
+static unsigned long useCount = 0;
+
+// Shared VBOs, identified by the address and length of the values they 
+// hold, and VBOs waiting to be deleted.  VBO names are never reused, and 
+// they start above the names used for the plot windows' own VBOs and the
+// index VBOs.  NOTE: An address can't be reused while a plot uses its 
+// VBO, because the plot holds a reference to the values.
+struct Axis_Buffer {
+  const float* pValues;
+  int n;
+  unsigned int name;
+  int nUsers;
+};
+static std::vector<Axis_Buffer> axis_buffers;
+static std::vector<GLuint> released_buffers;
+static unsigned int nextBufferName = MAXPLOTS+NBRUSHES+1;
+
+//***************************************************************************
+// Axis_Cache::copy( target, source) -- Copy a normalized axis, with its 
+// values copied by reference.  NOTE: The default assignment operator can't 
+// be used, because blitz arrays are assigned element by element.
+void Axis_Cache::copy( Normalized_Axis &target, const Normalized_Axis &source)
+{
+  target.jvar = source.jvar;
+  target.style = source.style;
+  target.offset = source.offset;
+  target.npoints = source.npoints;
+  target.values.reference( source.values);
+  target.order.reference( source.order);
+  target.amin = source.amin;
+  target.amax = source.amax;
+  target.hasRange = source.hasRange;
+  target.lastUsed = source.lastUsed;
+}
+
+//***************************************************************************
+// Axis_Cache::find( jvar, style, offset, axis) -- Look up the axis for 
+// column JVAR, normalization STYLE, and OFFSET for the current number of 
+// points.  If it is in the cache, copy it (by reference) to AXIS and 
+// return 1, otherwise return 0.
+int Axis_Cache::find( int jvar, int style, int offset, Normalized_Axis &axis)
+{
+  for( unsigned int i=0; i<cached_axes.size(); i++) {
+    Normalized_Axis &cached = cached_axes[ i];
+    if( cached.jvar == jvar && cached.style == style && 
+        cached.offset == offset && cached.npoints == npoints) {
+      cached.lastUsed = ++useCount;
+      copy( axis, cached);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+//***************************************************************************
+// Axis_Cache::store( axis) -- Add AXIS to the cache, replacing the least
+// recently used axis if the cache is full.
+void Axis_Cache::store( const Normalized_Axis &axis)
+{
+  unsigned int iSlot = cached_axes.size();
+  if( cached_axes.size() >= max_axes()) {
+    iSlot = 0;
+    for( unsigned int i=1; i<cached_axes.size(); i++) {
+      if( cached_axes[ i].lastUsed < cached_axes[ iSlot].lastUsed) iSlot = i;
+    }
+  }
+  else cached_axes.push_back( axis);
+
+  copy( cached_axes[ iSlot], axis);
+  cached_axes[ iSlot].lastUsed = ++useCount;
+}
+
+//***************************************************************************
+// Axis_Cache::sort_axis( axis, ranks) -- Make sure AXIS knows the sorted 
+// order of its values.  If another axis with the same values was sorted, 
+// its order is shared.  Otherwise, if the values are in ascending order 
+// along RANKS (usually the ranks of the column, which most normalizations
+// preserve), RANKS is used, and if not, the values are sorted.  The order 
+// is then shared with the cached axis that has the same values, if any.
+void Axis_Cache::sort_axis( 
+  Normalized_Axis &axis, const blitz::Array<int,1> &ranks)
+{
+  int n = axis.values.rows();
+  if( axis.order.rows() == n) return;
+  const float* pValues = axis.values.data();
+  for( unsigned int i=0; i<cached_axes.size(); i++) {
+    Normalized_Axis &cached = cached_axes[ i];
+    if( cached.values.data() == pValues && cached.values.rows() == n &&
+        cached.order.rows() == n) {
+      axis.order.reference( cached.order);
+      return;
+    }
+  }
+
+  // Check whether RANKS sorts the values
+  int isSorted = ( ranks.rows() == n);
+  for( int i=0; i<n && isSorted; i++) {
+    int j = ranks( i);
+    if( j < 0 || j >= n) isSorted = 0;
+    else if( i > 0 && axis.values( j) < axis.values( ranks( i-1))) {
+      isSorted = 0;
+    }
+  }
+  if( isSorted) axis.order.reference( ranks);
+  else {
+    blitz::Array<int,1> order( n);
+    Rank_Engine::rank( pValues, axis.values.stride( 0), n, order.data());
+    axis.order.reference( order);
+  }
+
+  for( unsigned int i=0; i<cached_axes.size(); i++) {
+    Normalized_Axis &cached = cached_axes[ i];
+    if( cached.values.data() == pValues && cached.values.rows() == n)
+      cached.order.reference( axis.order);
+  }
+}
+
+//***************************************************************************
+// Axis_Cache::find_range( axis, lo, hi, iBegin, iEnd) -- Find the points 
+// of AXIS whose values lie in [LO, HI] by binary search of its sorted 
+// order.  They are order( iBegin), ..., order( iEnd-1).  sort_axis() must
+// have been called.  Touches no blitz reference counts, so it can be 
+// called from any thread.
+void Axis_Cache::find_range( 
+  const Normalized_Axis &axis, float lo, float hi, int &iBegin, int &iEnd)
+{
+  const float* pValues = axis.values.data();
+  const int* pOrder = axis.order.data();
+  int stride = axis.values.stride( 0);
+  int n = axis.order.rows();
+
+  // First point with a value >= LO
+  int iLow = 0, iHigh = n;
+  while( iLow < iHigh) {
+    int iMid = iLow + ( iHigh-iLow)/2;
+    if( pValues[ pOrder[ iMid] * stride] < lo) iLow = iMid+1;
+    else iHigh = iMid;
+  }
+  iBegin = iLow;
+
+  // First point after that with a value > HI
+  iHigh = n;
+  while( iLow < iHigh) {
+    int iMid = iLow + ( iHigh-iLow)/2;
+    if( pValues[ pOrder[ iMid] * stride] <= hi) iLow = iMid+1;
+    else iHigh = iMid;
+  }
+  iEnd = iLow;
+}
+
+//***************************************************************************
+// Axis_Cache::clear() -- Discard every normalized axis.  Must be called
+// whenever column data change.
+void Axis_Cache::clear()
+{
+  cached_axes.clear();
+
+  // Old values may be changed in place, so their VBOs can't be shared 
+  // any more.  Plots that still use one will ask for a new one.
+  for( unsigned int i=0; i<axis_buffers.size(); i++)
+    released_buffers.push_back( axis_buffers[ i].name);
+  axis_buffers.clear();
+}
+
+//***************************************************************************
+// Axis_Cache::acquire_buffer( axis) -- Return the name of the shared VBO 
+// that holds the values of AXIS, creating and filling it if no other plot 
+// uses it, and count one more user.  Must be called while an openGL 
+// context is current.
+unsigned int Axis_Cache::acquire_buffer( const Normalized_Axis &axis)
+{
+  const float* pValues = axis.values.data();
+  int n = axis.values.rows();
+  for( unsigned int i=0; i<axis_buffers.size(); i++) {
+    if( axis_buffers[ i].pValues == pValues && axis_buffers[ i].n == n) {
+      axis_buffers[ i].nUsers++;
+      return axis_buffers[ i].name;
+    }
+  }
+
+  // The values of a normalized axis are contiguous, so they can be 
+  // uploaded as they are
+  assert( axis.values.stride( 0) == 1);
+  Axis_Buffer buffer;
+  buffer.pValues = pValues;
+  buffer.n = n;
+  buffer.name = nextBufferName++;
+  buffer.nUsers = 1;
+  glBindBuffer( GL_ARRAY_BUFFER, buffer.name);
+  glBufferData( 
+    GL_ARRAY_BUFFER, (GLsizeiptr) n*sizeof(GLfloat), (void*) pValues,
+    GL_STATIC_DRAW);
+  axis_buffers.push_back( buffer);
+  return buffer.name;
+}
+
+//***************************************************************************
+// Axis_Cache::has_buffer( name) -- Return 1 if NAME is a shared VBO that 
+// is in use, 0 if it was released or discarded by clear().
+int Axis_Cache::has_buffer( unsigned int name)
+{
+  if( name == 0) return 0;
+  for( unsigned int i=0; i<axis_buffers.size(); i++) {
+    if( axis_buffers[ i].name == name) return 1;
+  }
+  return 0;
+}
+
+//***************************************************************************
+// Axis_Cache::release_buffer( name) -- Count one less user of the shared 
+// VBO NAME, and queue it to be deleted if nobody uses it.  Unknown names
+// (including 0) are ignored.
+void Axis_Cache::release_buffer( unsigned int name)
+{
+  for( unsigned int i=0; i<axis_buffers.size(); i++) {
+    if( axis_buffers[ i].name != name) continue;
+    if( --axis_buffers[ i].nUsers <= 0) {
+      released_buffers.push_back( name);
+      axis_buffers.erase( axis_buffers.begin() + i);
+    }
+    return;
+  }
+}
+
+//***************************************************************************
+// Axis_Cache::delete_released_buffers() -- Delete the VBOs that are no 
+// longer used.  Must be called while an openGL context is current.
+void Axis_Cache::delete_released_buffers()
+{
+  if( released_buffers.empty()) return;
+  glDeleteBuffers( (GLsizei) released_buffers.size(), &released_buffers[ 0]);
+  released_buffers.clear();
+}
+
+//***************************************************************************
+// Axis_Cache::max_axes() -- Number of axes the cache will hold: enough for
+// three axes in every plot window.
+unsigned int Axis_Cache::max_axes()
+{
+  return 3 * ( nplots > 0 ? nplots : 1);
+}
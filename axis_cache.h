@@ -0,0 +1,109 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: axis_cache.h
+//
+// Class definitions:
+//   Axis_Cache -- Cache of normalized axes
+//
+// Classes referenced: none
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Share normalized copies of columns between plot windows.  In a
+//   scatterplot matrix the same column is usually shown, with the same 
+//   normalization, in many plots, so it is normalized only once, and it is
+//   uploaded to the graphics card only once.
+//
+// General design philosophy:
+//   1) A normalized axis is identified by the column, the normalization
+//      style, the axis offset, and the number of points.  Its values are 
+//      held in a blitz array, so plot windows share them by reference.
+//   2) Any method that changes, moves, or deletes column data MUST call 
+//      clear().  This is done wherever Rank_Scheduler::stop() is called.
+//   3) The cache holds a few axes per plot window.  The least recently 
+//      used axis is discarded to make room for a new one.
+//   4) Only the main (FLTK) thread may use the cache.
+//   5) The sorted order of an axis, used to find the points in a range of
+//      values, is computed only when it is needed and then shared like 
+//      the values.
+//   6) Each array of normalized values that is shown in a plot gets one 
+//      vertex buffer object (VBO), shared by every plot that shows it and
+//      counted by the number of plots that use it.  A VBO is deleted when 
+//      its last plot lets go of it, or when clear() is called.  VBOs can 
+//      only be created and deleted while an openGL context is current, 
+//      i.e., from a Plot_Window's draw() method.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef AXIS_CACHE_H
+#define AXIS_CACHE_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+//***************************************************************************
+// Normalized_Axis -- Normalized values of a column and the range of the 
+// axis.  If hasRange is zero, the normalization doesn't define a range and 
+// a plot should keep the one it has.  ORDER holds the indices of the points
+// in ascending order of their values, or is empty if it isn't known yet.
+struct Normalized_Axis {
+  int jvar, style, offset, npoints;
+  blitz::Array<float,1> values;
+  blitz::Array<int,1> order;
+  float amin, amax;
+  int hasRange;
+  unsigned long lastUsed;
+};
+
+//***************************************************************************
+// Class: Axis_Cache
+//
+// Class definitions:
+//   Axis_Cache -- Cache of normalized axes
+//
+// Classes referenced: none
+//
+// Purpose: Static methods to look up, store, and discard normalized axes.
+//
+// Functions:
+//   find( jvar, style, offset, axis) -- Look up a normalized axis
+//   store( axis) -- Add a normalized axis to the cache
+//   clear() -- Discard every normalized axis
+//   copy( target, source) -- Copy a normalized axis by reference
+//   sort_axis( axis, ranks) -- Make sure the sorted order of an axis is known
+//   find_range( axis, lo, hi, iBegin, iEnd) -- Find the points with values
+//     in a range
+//   acquire_buffer( axis) -- Get the shared VBO for the values of an axis
+//   has_buffer( name) -- Is this shared VBO still in use?
+//   release_buffer( name) -- Let go of a shared VBO
+//   delete_released_buffers() -- Delete VBOs that are no longer used
+//   max_axes() -- Number of axes the cache will hold
+//***************************************************************************
+class Axis_Cache
+{
+  public:
+    static int find( int jvar, int style, int offset, Normalized_Axis &axis);
+    static void store( const Normalized_Axis &axis);
+    static void clear();
+    static void copy( Normalized_Axis &target, const Normalized_Axis &source);
+    static void sort_axis( 
+      Normalized_Axis &axis, const blitz::Array<int,1> &ranks);
+    static void find_range( 
+      const Normalized_Axis &axis, float lo, float hi, int &iBegin, int &iEnd);
+    static unsigned int acquire_buffer( const Normalized_Axis &axis);
+    static int has_buffer( unsigned int name);
+    static void release_buffer( unsigned int name);
+    static void delete_released_buffers();
+
+  protected:
+    static unsigned int max_axes();
+};
+
+#endif   // AXIS_CACHE_H
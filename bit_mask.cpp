@@ -0,0 +1,125 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: bit_mask.cpp
+//
+// Class definitions:
+//   Bit_Mask -- Array of flags packed into 64-bit words
+//
+// Classes referenced: none
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <bit_mask.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include associated headers and source code
+#include "bit_mask.h"
+
+//***************************************************************************
+// Bit_Mask::resize( n) -- Resize to N flags, all false.
+void Bit_Mask::resize( int n)
+{
+  n_ = n > 0 ? n : 0;
+  words_.assign( ( n_ + WORD_BITS-1) / WORD_BITS, (Word) 0);
+}
+
+//***************************************************************************
+// Bit_Mask::free() -- Release memory.
+void Bit_Mask::free()
+{
+  n_ = 0;
+  std::vector<Word>().swap( words_);
+}
+
+//***************************************************************************
+// Bit_Mask::clear() -- Set all flags false.
+void Bit_Mask::clear()
+{
+  if( !words_.empty()) memset( &words_[ 0], 0, words_.size() * sizeof( Word));
+}
+
+//***************************************************************************
+// Bit_Mask::set_word( iWord, w) -- Set the flags of word IWORD.  Bits of
+// the last word past the last flag are dropped to keep them zero.
+void Bit_Mask::set_word( int iWord, Word w)
+{
+  if( iWord == n_words()-1 && n_ % WORD_BITS != 0)
+    w &= word_bits( n_ % WORD_BITS);
+  words_[ iWord] = w;
+}
+
+//***************************************************************************
+// Bit_Mask::or_with( other) -- Set every flag that is true in OTHER, which
+// must be the same size.
+void Bit_Mask::or_with( const Bit_Mask &other)
+{
+  assert( other.n_ == n_);
+  int nWords = n_words();
+  for( int iWord=0; iWord<nWords; iWord++) words_[ iWord] |= other.words_[ iWord];
+}
+
+//***************************************************************************
+// Bit_Mask::count() -- Number of flags that are true, counted a word at a
+// time.
+int Bit_Mask::count() const
+{
+  int nTrue = 0;
+  int nWords = n_words();
+  for( int iWord=0; iWord<nWords; iWord++) {
+    Word w = words_[ iWord];
+    w = w - ( ( w >> 1) & 0x5555555555555555ULL);
+    w = ( w & 0x3333333333333333ULL) + ( ( w >> 2) & 0x3333333333333333ULL);
+    w = ( w + ( w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    nTrue += (int) ( ( w * 0x0101010101010101ULL) >> 56);
+  }
+  return nTrue;
+}
+
+//***************************************************************************
+// Bit_Mask::word_bits( nBits) -- Static method to return a word with the
+// low NBITS bits set, 0 <= nBits <= WORD_BITS.
+Bit_Mask::Word Bit_Mask::word_bits( int nBits)
+{
+  if( nBits >= WORD_BITS) return ~( (Word) 0);
+  return ( ( (Word) 1) << nBits) - 1;
+}
+
+//***************************************************************************
+// Bit_Mask::nonzero_word( pIds, nBits) -- Static method to return a word
+// whose bit i is set if brush index pIds[ i] is nonzero, for the first
+// NBITS indices.
+Bit_Mask::Word Bit_Mask::nonzero_word( const unsigned char* pIds, int nBits)
+{
+  Word word = 0;
+  for( int i=0; i<nBits; i++) word |= ( (Word) ( pIds[ i] != 0)) << i;
+  return word;
+}
+
+//***************************************************************************
+// Bit_Mask::blend_ids( word, id, pOtherIds, pIds, nBits) -- Static method to
+// set the first NBITS brush indices of PIDS to ID where the corresponding
+// bit of WORD is set, and to the index from POTHERIDS where it isn't.
+// Words that are all clear or all set, which are by far the most common,
+// are copied or filled as blocks.  POTHERIDS may equal PIDS.
+void Bit_Mask::blend_ids(
+  Word word, unsigned char id, const unsigned char* pOtherIds,
+  unsigned char* pIds, int nBits)
+{
+  Word all = word_bits( nBits);
+  word &= all;
+  if( word == 0) {
+    if( pIds != pOtherIds) memcpy( pIds, pOtherIds, nBits);
+  }
+  else if( word == all) memset( pIds, id, nBits);
+  else {
+    for( int i=0; i<nBits; i++)
+      pIds[ i] = ( ( word >> i) & 1) ? id : pOtherIds[ i];
+  }
+}
@@ -0,0 +1,98 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: bit_mask.h
+//
+// Class definitions:
+//   Bit_Mask -- Array of flags packed into 64-bit words
+//
+// Classes referenced: none
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Hold one true/false flag per data point in one bit, so the flags
+//   that describe a selection take 1/32 of the memory of an int array and
+//   can be combined 64 points at a time.
+//
+// General design philosophy:
+//   1) Bits past the last flag in the last word are always zero, so whole
+//      words can be combined, counted, and compared without special cases.
+//   2) Brush indices are kept in arrays of unsigned char, one per point.
+//      blend_ids() and nonzero_word() convert between these and words of
+//      flags, so selections can be updated a word at a time.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef BIT_MASK_H
+#define BIT_MASK_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+//***************************************************************************
+// Class: Bit_Mask
+//
+// Class definitions:
+//   Bit_Mask -- Array of flags packed into 64-bit words
+//
+// Classes referenced: none
+//
+// Purpose: Array of flags with word-wide operations.
+//
+// Functions:
+//   Bit_Mask() -- Default constructor
+//   resize( n) -- Resize to n flags, all false
+//   free() -- Release memory
+//   size() -- Number of flags
+//   n_words() -- Number of words
+//   clear() -- Set all flags false
+//   get( i) -- Get flag i
+//   set( i, value) -- Set flag i
+//   word( iWord) -- Get word iWord
+//   set_word( iWord, w) -- Set word iWord
+//   or_with( other) -- OR another mask into this one
+//   count() -- Number of flags that are true
+//   word_bits( nBits) -- Word with the low nBits bits set
+//   nonzero_word( pIds, nBits) -- Word of flags for nonzero brush indices
+//   blend_ids( word, id, pOtherIds, pIds, nBits) -- Set brush indices from
+//     a word of flags
+//***************************************************************************
+class Bit_Mask
+{
+  public:
+    typedef unsigned long long Word;
+    enum { WORD_BITS = 64};
+
+    Bit_Mask() : n_( 0) {}
+    void resize( int n);
+    void free();
+    int size() const { return n_;}
+    int n_words() const { return (int) words_.size();}
+    void clear();
+    int get( int i) const { return (int) ( ( words_[ i>>6] >> ( i&63)) & 1);}
+    void set( int i, int value)
+    {
+      Word bit = ( (Word) 1) << ( i&63);
+      if( value) words_[ i>>6] |= bit;
+      else words_[ i>>6] &= ~bit;
+    }
+    Word word( int iWord) const { return words_[ iWord];}
+    void set_word( int iWord, Word w);
+    void or_with( const Bit_Mask &other);
+    int count() const;
+
+    static Word word_bits( int nBits);
+    static Word nonzero_word( const unsigned char* pIds, int nBits);
+    static void blend_ids(
+      Word word, unsigned char id, const unsigned char* pOtherIds,
+      unsigned char* pIds, int nBits);
+
+  protected:
+    int n_;
+    std::vector<Word> words_;
+};
+
+#endif   // BIT_MASK_H
@@ -125,7 +125,8 @@ Brush::Brush() : Fl_Group( 10, 10, 10, 10),
   index( 0),
   brush_symbol_save( 0), brush_size_save( 0),
   alpha_save( 1.0), cutoff_save( 0.0), lum1_save( 0.2), lum2_save( 1.0),
-  red_value_save( 1.0), green_value_save( 0), blue_value_save( 0)
+  red_value_save( 1.0), green_value_save( 0), blue_value_save( 0),
+  footprint_save( 0)
 {}
 
 //***************************************************************************
@@ -181,6 +182,7 @@ void Brush::make_state()
   red_value_save = color_chooser->r();
   green_value_save = color_chooser->g();
   blue_value_save = color_chooser->b();
+  footprint_save = footprint->value();
 }
 
 //***************************************************************************
@@ -199,6 +201,7 @@ void Brush::copy_state( Brush* brush_save)
   red_value_save = brush_save->red_value_save;
   green_value_save = brush_save->green_value_save;
   blue_value_save = brush_save->blue_value_save;
+  footprint_save = brush_save->footprint_save;
 }
   
 //***************************************************************************
@@ -214,6 +217,7 @@ void Brush::load_state()
   lum1->value( lum1_save);
   lum2->value( lum2_save);
   color_chooser->rgb( red_value_save, green_value_save, blue_value_save);
+  footprint->value( footprint_save);
 }
 
 //***************************************************************************
@@ -265,6 +269,7 @@ void Brush::reset ()
   alpha->value(1.0);
   lum1->value(0.2);  // !!! 
   lum2->value(1.0);
+  footprint->value(FOOTPRINT_BOX);
 }
 
 //***************************************************************************
@@ -401,6 +406,16 @@ void Brush::make_widgets( Brush *bw)
   paint->selection_color( FL_BLUE); 
   paint->type( FL_TOGGLE_BUTTON);
   paint->tooltip( "dribble paint (do not erase) when dragging or shift-dragging");
+
+  // Footprint menu: the order of the items must match footprint_type
+  footprint = new Fl_Choice( xpos, ypos+=20, 70, 20, "footprint");
+  footprint->align( FL_ALIGN_RIGHT);
+  footprint->textsize( 12);
+  footprint->add( "box");
+  footprint->add( "circle");
+  footprint->add( "lasso");
+  footprint->value( FOOTPRINT_BOX);
+  footprint->tooltip( "select points inside a box, a circle, or a free-form lasso");
 }
 
 //***************************************************************************
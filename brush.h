@@ -88,6 +88,7 @@ class Brush : public Fl_Group
     float brush_size_save;
     float alpha_save, cutoff_save, lum1_save, lum2_save;
     double red_value_save, green_value_save, blue_value_save;
+    int footprint_save;
 
     // When the class Archive corresponds to an output archive, the &
     // operator is defined similar to <<.  Likewise, when the class Archive 
@@ -112,6 +113,7 @@ class Brush : public Fl_Group
         ar & boost::serialization::make_nvp( "red_value", red_value_save);
         ar & boost::serialization::make_nvp( "green_value", green_value_save);
         ar & boost::serialization::make_nvp( "blue_value", blue_value_save);
+        ar & boost::serialization::make_nvp( "footprint", footprint_save);
       }
       catch( exception &e) {}
     }
@@ -159,6 +161,11 @@ class Brush : public Fl_Group
 
     Fl_Button *add_to_selection, *paint;
 
+    // Shape of the region this brush selects: a box, a circle, or a 
+    // free-form lasso
+    enum footprint_type { FOOTPRINT_BOX = 0, FOOTPRINT_CIRCLE, FOOTPRINT_LASSO};
+    Fl_Choice *footprint;
+
     Fl_Button *clear_now_button;
     void clear_now ();
     static void static_clear_now( Fl_Widget *w, Brush *brush)
@@ -32,11 +32,14 @@
 
 // Include associated headers and source code
 #include "column_info.h"
+#include "rank_engine.h"
 
 //***************************************************************************
 // Column_Info::Column_Info() --  Default constructor clears everything.
-Column_Info::Column_Info() : jvar_( 0), label( ""), hasASCII( 0),
-  isVector( 0), vectorLabel( ""), vectorIndex( 0), isRanked( 0)
+Column_Info::Column_Info() : jvar_( 0), pMappedFile_( NULL),
+  ranksAreMapped_( 0), rankState_( UNRANKED), label( ""), hasASCII( 0),
+  isVector( 0), vectorLabel( ""), vectorIndex( 0), minValue( 0.0),
+  maxValue( 0.0)
 {
   ascii_values_.erase( ascii_values_.begin(), ascii_values_.end());
 }
@@ -46,7 +49,9 @@ Column_Info::Column_Info() : jvar_( 0), label( ""), hasASCII( 0),
 // clear everything, then parse header string from binary file to load 
 // column info.
 Column_Info::Column_Info( string sColumnInfo) : 
-  jvar_( 0), label( ""), hasASCII( 0)
+  jvar_( 0), pMappedFile_( NULL), ranksAreMapped_( 0),
+  rankState_( UNRANKED), label( ""), hasASCII( 0), minValue( 0.0),
+  maxValue( 0.0)
 {
   ascii_values_.erase( ascii_values_.begin(), ascii_values_.end());
   // Code to parse string has yet to be written
@@ -61,7 +66,8 @@ Column_Info::~Column_Info()
 
 //*****************************************************************
 // Column_Info::Column_Info( Column_Info&) -- Copy constructor.
-Column_Info::Column_Info( const Column_Info &inputInfo)
+Column_Info::Column_Info( const Column_Info &inputInfo) :
+  pMappedFile_( NULL), ranksAreMapped_( 0), rankState_( UNRANKED)
 {
   this->copy( inputInfo);
 }
@@ -79,9 +85,13 @@ void Column_Info::free()
   vectorLabel = "";
   vectorIndex = 0;
   
-  isRanked = 0;
+  rankState_ = UNRANKED;
+  minValue = maxValue = 0.0;
   points.free();
   ranked_points.free();
+  ranksAreMapped_ = 0;
+  if( pMappedFile_ != NULL) pMappedFile_->release();
+  pMappedFile_ = NULL;
 }
 
 //***************************************************************************
@@ -99,11 +109,36 @@ void Column_Info::copy( const Column_Info &inputInfo)
   vectorLabel = inputInfo.vectorLabel;
   vectorIndex = inputInfo.vectorIndex;
 
-  isRanked = inputInfo.isRanked;
-  points.resize( (inputInfo.points).shape());
-  points = inputInfo.points;
-  ranked_points.resize( (inputInfo.ranked_points).shape());
-  ranked_points = inputInfo.ranked_points;
+  // If the input data are a view into a memory-mapped file, share the view 
+  // rather than copying it.  Otherwise make a copy.
+  // A copy can't be the target of a background job.
+  rankState_ = UNRANKED;
+  if( inputInfo.rankState_ == RANKED) rankState_ = RANKED;
+  minValue = inputInfo.minValue;
+  maxValue = inputInfo.maxValue;
+  if( inputInfo.pMappedFile_ != NULL) {
+    if( pMappedFile_ != inputInfo.pMappedFile_) {
+      if( pMappedFile_ != NULL) pMappedFile_->release();
+      pMappedFile_ = inputInfo.pMappedFile_;
+      pMappedFile_->attach();
+    }
+    points.reference( inputInfo.points);
+  }
+  else {
+    if( pMappedFile_ != NULL) pMappedFile_->release();
+    pMappedFile_ = NULL;
+    points.resize( (inputInfo.points).shape());
+    points = inputInfo.points;
+  }
+  if( inputInfo.ranksAreMapped_) {
+    ranked_points.reference( inputInfo.ranked_points);
+    ranksAreMapped_ = 1;
+  }
+  else {
+    ranksAreMapped_ = 0;
+    ranked_points.resize( (inputInfo.ranked_points).shape());
+    ranked_points = inputInfo.ranked_points;
+  }
 }
 
 //***************************************************************************
@@ -149,6 +184,7 @@ int Column_Info::update_ascii_values_and_data()
 {
   // Make sure we have the right index and look-up table
   if( hasASCII == 0) return -1;
+  materialize();
 
   // Loop: Create and load a map to do the conversion
   map<int,int> conversion;
@@ -183,6 +219,7 @@ Column_Info& Column_Info::add_info_and_update_data( Column_Info &old_info)
 {
   // If this is not an ASCII column then quit
   if( hasASCII == 0 || old_info.hasASCII == 0) return old_info;
+  materialize();
   
   // Define a map to convert values
   map<int,int> conversion_table;
@@ -249,3 +286,234 @@ string Column_Info::ascii_value( int iValue)
   }
   return iter->first;
 }
+
+//***************************************************************************
+// Column_Info::match_ascii_values( sPattern, useRegex, ignoreCase, matches)
+// -- Test each ASCII value once against SPATTERN and set matches[ k] to 1 
+// if the value with code k contains it, 0 otherwise.  If USEREGEX is set, 
+// SPATTERN is a POSIX extended regular expression, which may match anywhere
+// in the value.  If IGNORECASE is set, case is ignored.  Returns 0 if 
+// successful, -1 if the regular expression is bad.
+int Column_Info::match_ascii_values( 
+  const string &sPattern, int useRegex, int ignoreCase,
+  std::vector<unsigned char> &matches)
+{
+  matches.assign( ascii_values_.size(), 0);
+
+#ifndef __WIN32__
+  if( useRegex) {
+    regex_t regex;
+    int flags = REG_EXTENDED | REG_NOSUB;
+    if( ignoreCase) flags |= REG_ICASE;
+    if( regcomp( &regex, sPattern.c_str(), flags) != 0) {
+      cerr << "Column_Info::match_ascii_values: bad regular expression <"
+           << sPattern.c_str() << ">" << endl;
+      return -1;
+    }
+    int k = 0;
+    for( map<string,int>::iterator iter = ascii_values_.begin();
+         iter != ascii_values_.end(); iter++, k++) {
+      matches[ k] = ( regexec( &regex, iter->first.c_str(), 0, NULL, 0) == 0);
+    }
+    regfree( &regex);
+    return 0;
+  }
+#endif // __WIN32__
+
+  // Plain text search, folding case if requested
+  string sKey = sPattern;
+  if( ignoreCase) {
+    for( unsigned int i=0; i<sKey.length(); i++) sKey[ i] = tolower( sKey[ i]);
+  }
+  string sValue;
+  int k = 0;
+  for( map<string,int>::iterator iter = ascii_values_.begin();
+       iter != ascii_values_.end(); iter++, k++) {
+    if( ignoreCase) {
+      sValue = iter->first;
+      for( unsigned int i=0; i<sValue.length(); i++) {
+        sValue[ i] = tolower( sValue[ i]);
+      }
+      matches[ k] = ( sValue.find( sKey) != string::npos);
+    }
+    else matches[ k] = ( iter->first.find( sKey) != string::npos);
+  }
+  return 0;
+}
+
+//***************************************************************************
+// Column_Info::map_points( pMappedFile, pData, n, stride) -- Make points a
+// view of N values, STRIDE floats apart, starting at PDATA in a memory-mapped 
+// file, and hold a reference to the file for as long as the view exists.
+void Column_Info::map_points( 
+  Mapped_File* pMappedFile, float* pData, int n, int stride)
+{
+  if( ranksAreMapped_) unrank();
+  pMappedFile->attach();
+  if( pMappedFile_ != NULL) pMappedFile_->release();
+  pMappedFile_ = pMappedFile;
+  blitz::Array<float,1> view( 
+    pData, blitz::shape( n), blitz::shape( stride), blitz::neverDeleteData);
+  points.reference( view);
+}
+
+//***************************************************************************
+// Column_Info::materialize() -- If points is a view into a memory-mapped 
+// file, replace it with a private, contiguous copy and release the file.  
+// Mapped ranks are copied as well.  Does nothing otherwise.
+void Column_Info::materialize()
+{
+  if( pMappedFile_ == NULL) return;
+  blitz::Array<float,1> buffer( points.shape());
+  buffer = points;
+  points.reference( buffer);
+  if( ranksAreMapped_) {
+    blitz::Array<int,1> rank_buffer( ranked_points.shape());
+    rank_buffer = ranked_points;
+    ranked_points.reference( rank_buffer);
+    ranksAreMapped_ = 0;
+  }
+  pMappedFile_->release();
+  pMappedFile_ = NULL;
+}
+
+//***************************************************************************
+// Column_Info::map_ranks( pMappedFile, pData, n) -- Make ranked_points a 
+// view of N contiguous ranks starting at PDATA.  The ranks must lie in the
+// same memory-mapped file as points, whose reference keeps the file open.  
+// Marks the column as ranked.  Returns 0 if successful, -1 otherwise.
+int Column_Info::map_ranks( Mapped_File* pMappedFile, int* pData, int n)
+{
+  if( pMappedFile == NULL || pMappedFile != pMappedFile_) return -1;
+  blitz::Array<int,1> view( pData, blitz::shape( n), blitz::neverDeleteData);
+  ranked_points.reference( view);
+  ranksAreMapped_ = 1;
+  rankState_ = RANKED;
+  return 0;
+}
+
+//***************************************************************************
+// Column_Info::rank() -- If the column hasn't been ranked, create an array 
+// of indices that rank orders the first npoints values (basically a stable 
+// sort) and record the range of the data.  Uses no globals other than 
+// npoints, so different columns can be ranked at the same time.
+void Column_Info::rank()
+{
+  if( rankState_ == RANKED) return;
+  unrank();
+  if( npoints <= 0) return;
+
+  Rank_Engine::rank( 
+    points.data(), points.stride( 0), npoints, ranked_points.data());
+
+  minValue = points( ranked_points( 0));
+  maxValue = points( ranked_points( npoints-1));
+  rankState_ = RANKED;
+}
+
+//***************************************************************************
+// Column_Info::unrank() -- Mark the column as unranked and make sure 
+// ranked_points is a private array of npoints elements.  The contents of 
+// the array are undefined.
+void Column_Info::unrank()
+{
+  rankState_ = UNRANKED;
+  if( ranksAreMapped_ || ranked_points.rows() != npoints) {
+    blitz::Array<int,1> buffer( npoints);
+    ranked_points.reference( buffer);
+    ranksAreMapped_ = 0;
+  }
+}
+
+//***************************************************************************
+// Column_Info::adopt_ranks( pRanks, n, fMin, fMax) -- Take ownership of N 
+// ranks, allocated with new[], that were computed elsewhere (e.g., on a 
+// background thread) and mark the column as ranked with the range 
+// [FMIN, FMAX].
+void Column_Info::adopt_ranks( int* pRanks, int n, float fMin, float fMax)
+{
+  blitz::Array<int,1> buffer( 
+    pRanks, blitz::shape( n), blitz::deleteDataWhenDone);
+  ranked_points.reference( buffer);
+  ranksAreMapped_ = 0;
+  minValue = fMin;
+  maxValue = fMax;
+  rankState_ = RANKED;
+}
+
+//***************************************************************************
+// Column_Info::remove_rows( pNewIndex, n) -- Delete rows from the first N 
+// rows of this column in place.  PNEWINDEX[ i] is the new number of row i, 
+// or -1 if row i is to be deleted, and rows must keep their order.  The 
+// relative order of the remaining rows doesn't change, so if the column is
+// ranked, its ranks are kept by dropping deleted rows and renumbering the 
+// rest.  Arrays are not resized.  Only raw data are touched, so different 
+// columns can be processed at the same time on different threads.  The 
+// column must not be a view into a memory-mapped file.
+void Column_Info::remove_rows( const int* pNewIndex, int n)
+{
+  // Compact the data
+  float* pPoints = points.data();
+  size_t stride = points.stride( 0);
+  int nKept = 0;
+  for( int i=0; i<n; i++) {
+    if( pNewIndex[ i] >= 0) pPoints[ nKept++ * stride] = pPoints[ i * stride];
+  }
+  if( rankState_ != RANKED) return;
+
+  // Filter and renumber the ranks and update the range
+  int* pRanks = ranked_points.data();
+  int nRanks = 0;
+  for( int k=0; k<n; k++) {
+    int iNew = pNewIndex[ pRanks[ k]];
+    if( iNew >= 0) pRanks[ nRanks++] = iNew;
+  }
+  if( nRanks > 0) {
+    minValue = pPoints[ pRanks[ 0] * stride];
+    maxValue = pPoints[ pRanks[ nRanks-1] * stride];
+  }
+}
+
+//***************************************************************************
+// Column_Info::merge_ranks( appended, nOld, nNew, pMerged) -- Merge the 
+// ranks of NOLD rows of this column with the ranks of the NNEW rows of 
+// APPENDED and store the ranks of all NOLD+NNEW rows in PMERGED.  The 
+// appended rows must already have been copied to rows NOLD...NOLD+NNEW-1 
+// of this column, and both columns must be ranked.  Ties go to the old 
+// rows, which have the lower indices, so the result is the same stable 
+// order that rank() would produce, at the cost of a single linear pass.  
+// Only raw data are touched, so different columns can be merged at the 
+// same time on different threads.
+void Column_Info::merge_ranks( 
+  const Column_Info &appended, int nOld, int nNew, int* pMerged) const
+{
+  const float* pPoints = points.data();
+  size_t stride = points.stride( 0);
+  const int* pOld = ranked_points.data();
+  const int* pNew = appended.ranked_points.data();
+
+  // Merge.  Compare sort keys so -0, +0, and NaN are ordered as in rank().
+  int iOld = 0, iNew = 0, k = 0;
+  if( nOld > 0 && nNew > 0) {
+    unsigned int keyOld = Rank_Engine::sort_key( pPoints[ pOld[ 0] * stride]);
+    unsigned int keyNew = 
+      Rank_Engine::sort_key( pPoints[ ( nOld + pNew[ 0]) * stride]);
+    while( 1) {
+      if( keyNew < keyOld) {
+        pMerged[ k++] = nOld + pNew[ iNew++];
+        if( iNew >= nNew) break;
+        keyNew = 
+          Rank_Engine::sort_key( pPoints[ ( nOld + pNew[ iNew]) * stride]);
+      }
+      else {
+        pMerged[ k++] = pOld[ iOld++];
+        if( iOld >= nOld) break;
+        keyOld = Rank_Engine::sort_key( pPoints[ pOld[ iOld] * stride]);
+      }
+    }
+  }
+
+  // Copy whatever is left
+  while( iOld < nOld) pMerged[ k++] = pOld[ iOld++];
+  while( iNew < nNew) pMerged[ k++] = nOld + pNew[ iNew++];
+}
@@ -39,6 +39,9 @@
 // Include globals
 #include "global_definitions_vp.h"
 
+// Columns may be views into a memory-mapped file
+#include "mapped_file.h"
+
 //***************************************************************************
 // Class: Column_Info
 //
@@ -67,6 +70,26 @@
 //   index() -- Get column index for this column
 //   index( j) -- Set column index for this column
 //   ascii_value( j) -- Get ASCII value for point j
+//   match_ascii_values( sPattern, useRegex, ignoreCase, matches) -- Flag
+//     the ASCII values that match a pattern
+//
+//   map_points( pMappedFile, pData, n, stride) -- Make points a view into a
+//     memory-mapped file
+//   is_mapped() -- Is points a view into a memory-mapped file?
+//   materialize() -- Replace a mapped view with a private copy
+//   map_ranks( pMappedFile, pData, n) -- Make ranked_points a view into a
+//     memory-mapped file
+//
+//   rank() -- Rank order the data, if this hasn't been done already
+//   unrank() -- Discard the rank order
+//   adopt_ranks( pRanks, n, fMin, fMax) -- Take ownership of ranks computed
+//     elsewhere
+//   remove_rows( pNewIndex, n) -- Delete rows in place, preserving ranks
+//   merge_ranks( appended, nOld, nNew, pMerged) -- Merge ranks of appended
+//     rows with the ranks of this column
+//   is_ranked() -- Is the column ranked?
+//   rank_state() -- Get rank state
+//   rank_state( i) -- Set rank state
 //
 // Author: Creon Levit    2005-2006
 // Modified: P. R. Gazis  27-SEP-2008
@@ -76,6 +99,16 @@ class Column_Info
   protected:
     int jvar_;
 
+    // Memory-mapped file that holds the data if points is a view into it,
+    // otherwise NULL.  If ranksAreMapped_ is set, ranked_points is a view
+    // into the same file.
+    Mapped_File* pMappedFile_;
+    int ranksAreMapped_;
+
+    // Rank state: UNRANKED, RANKING (a background job has been queued), or
+    // RANKED.  Only changed by the main (FLTK) thread.
+    int rankState_;
+
   public:
     Column_Info();
     Column_Info( string sColumnInfo);
@@ -96,6 +129,33 @@ class Column_Info
     int index() { return jvar_;}
     void index( int j) { jvar_ = j;}
     string ascii_value( int j);
+    int match_ascii_values( 
+      const string &sPattern, int useRegex, int ignoreCase,
+      std::vector<unsigned char> &matches);
+
+    // Functions to manage data that are views into a memory-mapped file.
+    // Any method that modifies points in place must call materialize() 
+    // first.
+    void map_points( Mapped_File* pMappedFile, float* pData, int n, int stride);
+    int is_mapped() { return pMappedFile_ != NULL;}
+    void materialize();
+    int map_ranks( Mapped_File* pMappedFile, int* pData, int n);
+
+    // Functions to manage the rank order
+    void rank();
+    void unrank();
+    void adopt_ranks( int* pRanks, int n, float fMin, float fMax);
+    void remove_rows( const int* pNewIndex, int n);
+    void merge_ranks( 
+      const Column_Info &appended, int nOld, int nNew, int* pMerged) const;
+    int is_ranked() { return rankState_ == RANKED;}
+    int rank_state() { return rankState_;}
+    void rank_state( int i) { rankState_ = i;}
+
+    // Define statics to hold rank states
+    static const int UNRANKED = 0;
+    static const int RANKING = 1;
+    static const int RANKED = 2;
 
     // Define buffers to hold label and ASCII values    
     string label;
@@ -110,7 +170,7 @@ class Column_Info
     // Define buffers to hold the data
     blitz::Array<float,1> points;  // main data array
     blitz::Array<int,1> ranked_points;   // data, ranked, as needed.
-    int isRanked;    // flag: 1->column is ranked, 0->not
+    float minValue, maxValue;   // data range, valid if is_ranked()
 };
 
 #endif   // COLUMN_INFO_H
@@ -175,7 +175,8 @@ void Control_Panel_Window::restrict_axis_indices(
 // removed!
 int Control_Panel_Window::transform_style_value()
 {
-  if( fluctuation->value() > 0) return 3;
+  if( xy_density->value() > 0) return 4;
+  else if( fluctuation->value() > 0) return 3;
   else if( sum_vs_difference->value(0) > 0) return 2;
   else if( cond_prop->value() > 0) return 1;
   else return 0;
@@ -189,11 +190,13 @@ int Control_Panel_Window::transform_style_value()
 // modified, or removed!
 void Control_Panel_Window::transform_style_value( int transform_style_in)
 {
+  xy_density->value(0);
   fluctuation->value(0);
   sum_vs_difference->value(0);
   cond_prop->value(0);
   no_transform->value(0);
-  if( transform_style_in == 3) fluctuation->value(1);
+  if( transform_style_in == 4) xy_density->value(1);
+  else if( transform_style_in == 3) fluctuation->value(1);
   else if( transform_style_in == 2) sum_vs_difference->value(1);
   else if( transform_style_in == 1) cond_prop->value(1);
   else no_transform->value(1);
@@ -334,6 +337,23 @@ void Control_Panel_Window::extract_and_redraw ()
   pw->extract_data_points();
 }
 
+//***************************************************************************
+// Control_Panel_Window::extract_axis_and_redraw( *w) -- Extract data for 
+// the axis whose variable, normalization, or offset was changed by widget 
+// W, and redraw plot.  The other axes are left alone.  For one local 
+// control panel only.
+void Control_Panel_Window::extract_axis_and_redraw( Fl_Widget *w)
+{
+  int axis_index = -1;
+  if( w == varindex1 || w == x_normalization_style || w == offset[0])
+    axis_index = 0;
+  else if( w == varindex2 || w == y_normalization_style || w == offset[1])
+    axis_index = 1;
+  else if( w == varindex3 || w == z_normalization_style || w == offset[2])
+    axis_index = 2;
+  pw->extract_data_points( axis_index);
+}
+
 //***************************************************************************
 // Control_Panel_Window::make_widgets( cpw) -- Make widgets
 void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
@@ -406,7 +426,7 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   varindex1->copy( varindex_menu_items);
   varindex1->mode( nvars, FL_MENU_INACTIVE);  // disable "--nothing--" as a choice for axis1
   varindex1->clear_visible_focus();
-  varindex1->callback( (Fl_Callback*)static_extract_and_redraw, this);
+  varindex1->callback( (Fl_Callback*)static_extract_axis_and_redraw, this);
   varindex1->tooltip("select variable for this plot's x-axis");
 
   // Y-axis variable selection menu
@@ -415,7 +435,7 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   varindex2->copy( varindex_menu_items);
   varindex2->mode( nvars, FL_MENU_INACTIVE);  // disable "--nothing--" as a choice for axis2
   varindex2->clear_visible_focus();
-  varindex2->callback( (Fl_Callback*)static_extract_and_redraw, this);
+  varindex2->callback( (Fl_Callback*)static_extract_axis_and_redraw, this);
   varindex2->tooltip("select variable for this plot's y-axis");
 
   // Z-axis variable selection menu
@@ -424,7 +444,7 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   varindex3->copy( varindex_menu_items);
   varindex3->value(nvars);  // initially, axis3 == "-nothing-"
   varindex3->clear_visible_focus();
-  varindex3->callback( (Fl_Callback*)static_extract_and_redraw, this);
+  varindex3->callback( (Fl_Callback*)static_extract_axis_and_redraw, this);
   varindex3->tooltip("select variable for this plot's z-axis");
 
   // label for row of normalization menus
@@ -439,7 +459,7 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   c->menu( normalization_style_menu_items);
   c->value( NORMALIZATION_MINMAX);
   c->clear_visible_focus();
-  c->callback( (Fl_Callback*)static_extract_and_redraw, this);
+  c->callback( (Fl_Callback*)static_extract_axis_and_redraw, this);
   c->tooltip("choose normalization and/or scaling for x-axis");
 
   // Y-axis normalization and scaling menu
@@ -448,7 +468,7 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   c->menu(normalization_style_menu_items);
   c->value(NORMALIZATION_MINMAX); 
   c->clear_visible_focus();
-  c->callback( (Fl_Callback*)static_extract_and_redraw, this);
+  c->callback( (Fl_Callback*)static_extract_axis_and_redraw, this);
   c->tooltip("choose normalization and/or scaling for y-axis");
  
   // Z-axis normalization and scaling menu
@@ -457,7 +477,7 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   c->menu(normalization_style_menu_items);
   c->value(NORMALIZATION_MINMAX); 
   c->clear_visible_focus();
-  c->callback( (Fl_Callback*)static_extract_and_redraw, this);
+  c->callback( (Fl_Callback*)static_extract_axis_and_redraw, this);
   c->tooltip("choose normalization and/or scaling for z-axis");
  
   // offset controls for "delay map"-like tricks.
@@ -469,7 +489,7 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
     offset[i]->step(1);
     offset[i]->box(FL_PLASTIC_UP_BOX);
     offset[i]->textsize(11);
-    offset[i]->callback((Fl_Callback*)static_extract_and_redraw, this);
+    offset[i]->callback((Fl_Callback*)static_extract_axis_and_redraw, this);
   }
 
   offset[0]->label("offset");
@@ -491,6 +511,9 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
     {"selection",   0, 0, (void *)HISTOGRAM_SELECTION,   FL_MENU_TOGGLE},
     {"conditional", 0, 0, (void *)HISTOGRAM_CONDITIONAL, FL_MENU_TOGGLE|FL_MENU_DIVIDER},
     {"weighted",    0, 0, (void *)HISTOGRAM_WEIGHTED,    FL_MENU_TOGGLE},
+    {"equi-depth",  0, 0, (void *)HISTOGRAM_EQUI_DEPTH,  FL_MENU_TOGGLE|FL_MENU_DIVIDER},
+    {"auto bins (Knuth)", 0, 0, (void *)HISTOGRAM_AUTO_KNUTH, FL_MENU_TOGGLE},
+    {"auto bins (F-D)", 0, 0, (void *)HISTOGRAM_AUTO_FREEDMAN_DIACONIS, FL_MENU_TOGGLE},
     {0}
   };
   // int n_histogram_pulldown_items = (sizeof(histogram_pulldown) / sizeof(histogram_pulldown[0])) - 1;
@@ -651,6 +674,15 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   dont_clear->callback((Fl_Callback*)static_maybe_redraw, this);
   dont_clear->tooltip("psychedelic fun");
 
+  // Button (1,4): Show smoothed density behind the points
+  show_density = b = new Fl_Button(xpos2, ypos+=25, 20, 20, "density");
+  b->callback((Fl_Callback*)static_maybe_redraw, this);
+  b->align(FL_ALIGN_RIGHT); 
+  b->type(FL_TOGGLE_BUTTON); 
+  b->selection_color(FL_BLUE);
+  b->value(0);
+  b->tooltip("toggle visibility of smoothed density of points");
+
   ypos=ypos2;
   xpos=xpos2+120;
 
@@ -716,7 +748,7 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   // Define Fl_Group to hold plot transform styles
   // XXX - this group should probably be a menu, or at least have a box around it
   // to show that they are radio buttons.
-  transform_style = new Fl_Group (xpos-1, ypos+25-1, 20+2, 4*25+2);
+  transform_style = new Fl_Group (xpos-1, ypos+25-1, 20+2, 5*25+2);
 
   // Button (4,1): No transform
   no_transform = b = new Fl_Button(xpos, ypos+=25, 20, 20, "identity");
@@ -750,6 +782,14 @@ void Control_Panel_Window::make_widgets( Control_Panel_Window *cpw)
   b->selection_color(FL_BLUE);
   b->tooltip("plot (x) vs. (deviation of y given x). i.e. conditional deviation");
   
+  // Button (8,1): smoothed density of (x,y)
+  xy_density = b = new Fl_Button(xpos, ypos+=25, 20, 20, "dens(x,y)");
+  b->callback((Fl_Callback*)static_extract_and_redraw, this);
+  b->align(FL_ALIGN_RIGHT); 
+  b->type(FL_RADIO_BUTTON); 
+  b->selection_color(FL_BLUE);
+  b->tooltip("plot (x) vs. (smoothed density of points at x,y)");
+  
   transform_style->end();
   no_transform->setonly();
 }
@@ -72,6 +72,7 @@
 //   maybe_redraw() -- Set redraw flag nicely
 //   make_widgets( *cpw) -- Make widgets for this tab
 //   extract_and_redraw() -- extract a variable, renormalize it, etc.
+//   extract_axis_and_redraw( *w) -- extract one changed axis, etc.
 //
 //   restrict_axis_indices( ivar_max, jvar_max, kvar_max) -- Restrict indices
 //   transform_style_value() -- Get y-axis transform style
@@ -82,6 +83,7 @@
 // Static functions for access by Fl_Button::callback
 //   choose_color_selected( *w, *cpw) -- Color of selected points
 //   static_extract_and_redraw( *w, *cpw) -- extract a variable, renormalize it, etc.
+//   static_extract_axis_and_redraw( *w, *cpw) -- extract one changed axis
 //   static_maybe_redraw( *w, *cpw) -- Set redraw flag nicely.
 //   replot( *w, *cpw) -- set redraw flag.
 //   reset_view( *w, *cpw) -- Reset one plot's view
@@ -168,6 +170,7 @@ class Control_Panel_Window : public Fl_Group
 
     void make_widgets( Control_Panel_Window *cpw);
     void extract_and_redraw();
+    void extract_axis_and_redraw( Fl_Widget *w);
 
     // Access functions
     void restrict_axis_indices( int ivar_max, int jvar_max, int kvar_max);
@@ -180,6 +183,8 @@ class Control_Panel_Window : public Fl_Group
     static void broadcast_change( Fl_Widget *global_widget);
     static void static_extract_and_redraw( Fl_Widget *w, Control_Panel_Window *cpw)
     { cpw->extract_and_redraw(); }
+    static void static_extract_axis_and_redraw( Fl_Widget *w, Control_Panel_Window *cpw)
+    { cpw->extract_axis_and_redraw( w); }
     static void static_maybe_redraw( Fl_Widget *w, Control_Panel_Window *cpw)
     { cpw->maybe_redraw() ;}
     static void replot( Fl_Widget *w, Control_Panel_Window *cpw)
@@ -202,6 +207,7 @@ class Control_Panel_Window : public Fl_Group
     Fl_Button *reset_view_button;
     Fl_Button *scale_points;
     Fl_Button *spin, *dont_clear, *show_points, *show_deselected_points;
+    Fl_Button *show_density;
     Fl_Button *show_axes, *show_grid, *show_labels;
 
     Fl_Menu_Button *show_histogram[3];
@@ -209,7 +215,10 @@ class Control_Panel_Window : public Fl_Group
         HISTOGRAM_MARGINAL = 0,
         HISTOGRAM_SELECTION,   
         HISTOGRAM_CONDITIONAL,
-        HISTOGRAM_WEIGHTED
+        HISTOGRAM_WEIGHTED,
+        HISTOGRAM_EQUI_DEPTH,
+        HISTOGRAM_AUTO_KNUTH,
+        HISTOGRAM_AUTO_FREEDMAN_DIACONIS
     };
 
     Fl_Button *show_scale;
@@ -217,7 +226,8 @@ class Control_Panel_Window : public Fl_Group
     Fl_Button *z_buffering_button;
     // Fl_Button *x_equals_delta_x, *y_equals_delta_x;
     Fl_Group *transform_style;
-    Fl_Button *sum_vs_difference, *cond_prop, *fluctuation, *no_transform;
+    Fl_Button *sum_vs_difference, *cond_prop, *fluctuation, *xy_density;
+    Fl_Button *no_transform;
 
     Fl_Choice *x_normalization_style, 
               *y_normalization_style, 
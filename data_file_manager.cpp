@@ -32,6 +32,10 @@
 #include "data_file_manager.h"
 #include "column_info.h"
 #include "plot_window.h"
+#include "ascii_chunk.h"
+#include "worker_pool.h"
+#include "rank_scheduler.h"
+#include "axis_cache.h"
 
 // These includes should not be necessary and have been commented out
 // #include "Vp_File_Chooser.H"   // PRG's new file chooser
@@ -44,6 +48,7 @@ std::vector<Column_Info> Data_File_Manager::column_info;
 string Data_File_Manager::SELECTION_LABEL = "SELECTION_BY_VP";
 string Data_File_Manager::BINARY_FILE_WITH_ASCII_VALUES_LABEL = 
   "BINARY_FILE_WITH_ASCII_VP";
+string Data_File_Manager::CACHE_FILE_LABEL = "VIEWPOINTS_CACHE_VP";
 Fl_Window* Data_File_Manager::edit_labels_window = NULL;
 Fl_Check_Browser* Data_File_Manager::edit_labels_widget = NULL;
 int Data_File_Manager::needs_restore_panels_ = 0;
@@ -289,6 +294,27 @@ int Data_File_Manager::load_data_file( string inFileSpec)
   return load_data_file();
 }
 
+//***************************************************************************
+// Rank_Merge -- Columns whose ranks are to be merged after an append, with
+// a buffer for the merged ranks of each, and merge_ranks_task( pUser, 
+// iTask), the Worker_Pool task that merges the ranks of column iTask.
+struct Rank_Merge {
+  std::vector<Column_Info>* pOldInfo;
+  std::vector<Column_Info>* pNewInfo;
+  int nOld, nNew;
+  std::vector<int> columns;
+  std::vector<int*> merged;
+};
+
+static void merge_ranks_task( void* pUser, int iTask)
+{
+  Rank_Merge* pMerge = (Rank_Merge*) pUser;
+  int j = pMerge->columns[ iTask];
+  ((*pMerge->pOldInfo)[ j]).merge_ranks( 
+    (*pMerge->pNewInfo)[ j], pMerge->nOld, pMerge->nNew, 
+    pMerge->merged[ iTask]);
+}
+
 //***************************************************************************
 // Data_File_Manager::load_data_file() -- Read an ASCII or binary data file, 
 // resize arrays to allocate meomory.  Returns 0 if successful.
@@ -302,12 +328,17 @@ int Data_File_Manager::load_data_file()
     return -1;
   }
 
+  // Stop background ranking and discard normalized axes before any column
+  // is changed
+  Rank_Scheduler::stop();
+  Axis_Cache::clear();
+
   // If this is an append or merge operation, save the existing data and 
   // column labels in temporary buffers
   unsigned uHaveOldData = 0;
   int old_npoints=0, old_nvars=0;
   std::vector<Column_Info> old_column_info; 
-  blitz::Array<int,1> old_selected;
+  blitz::Array<unsigned char,1> old_selected;
   if( preserve_old_data_mode || doAppend > 0 || doMerge > 0) {
     uHaveOldData = 1;
     old_column_info = column_info;
@@ -328,8 +359,11 @@ int Data_File_Manager::load_data_file()
   // methods load selection information, but don't resize read_selected;
   cout << "Data_File_Manager::load_data_file: Reading input data from <"
        << inFileSpec.c_str() << ">" << endl;
+  int useCache = cache_mode && memory_map_mode && !read_from_stdin;
+  int isCached = 0;
   int iReadStatus = 0;
-  if( inputFileType_ == 0) iReadStatus = read_ascii_file_with_headers();
+  if( useCache && read_cache_file() == 0) isCached = 1;
+  else if( inputFileType_ == 0) iReadStatus = read_ascii_file_with_headers();
   else if( inputFileType_ == 2) iReadStatus = read_table_from_fits_file();
   else iReadStatus = read_binary_file_with_headers();
   if( iReadStatus != 0) {
@@ -386,6 +420,14 @@ int Data_File_Manager::load_data_file()
     cout << "Data_File_Manager::load_data_file: Loaded " << npoints
          << " samples with " << nvars << " fields" << endl;
   }
+
+  // If this file wasn't read from its cache file, prepare to write one so 
+  // the next read will be faster.  The file is written after the columns
+  // have been ranked in the background.  Appended or merged data aren't 
+  // cached.
+  int doWriteCache = 
+    useCache && !isCached && doAppend == 0 && doMerge == 0 &&
+    prepare_cache_file() == 0;
   
   // MCL XXX Now that we're done reading, we can update nvars to count possible
   // additional program-generated variables (presently only the line number).
@@ -433,14 +475,50 @@ int Data_File_Manager::load_data_file()
       // and make sure current data buffer is the right size
       int all_npoints = npoints + old_npoints;
       for( int j=0; j<nvars; j++) {
+        old_column_info[j].materialize();
         (old_column_info[j].points).resizeAndPreserve(all_npoints);
         (column_info[j].points).resizeAndPreserve(npoints);
       }
 
-      // Append current data to old data and resize the current data buffer
+      // Append current data to old data
       for( int j=0; j<nvars; j++) {
         (old_column_info[j].points(blitz::Range(old_npoints,all_npoints-1))) =
           column_info[j].points;
+      }
+
+      // The old ranks are still valid, so rather than rank the combined 
+      // data from scratch, rank the current data on its own and merge the
+      // two in a single pass.  Columns that weren't ranked are left for the
+      // background ranking.  ASCII values are renumbered below, which
+      // invalidates their ranks.
+      Rank_Merge rank_merge;
+      rank_merge.pOldInfo = &old_column_info;
+      rank_merge.pNewInfo = &column_info;
+      rank_merge.nOld = old_npoints;
+      rank_merge.nNew = npoints;
+      for( int j=0; j<nvars; j++) {
+        if( !old_column_info[j].is_ranked() || 
+            (old_column_info[j].ranked_points).rows() != old_npoints ||
+            old_column_info[j].hasASCII || column_info[j].hasASCII) continue;
+        column_info[j].rank();
+        rank_merge.columns.push_back( j);
+        rank_merge.merged.push_back( new int[ all_npoints]);
+      }
+      Worker_Pool::run_tasks( 
+        merge_ranks_task, (void*) &rank_merge, rank_merge.columns.size());
+      for( unsigned int k=0; k<rank_merge.columns.size(); k++) {
+        Column_Info &merged_info = old_column_info[ rank_merge.columns[ k]];
+        int* pMerged = rank_merge.merged[ k];
+        merged_info.adopt_ranks( 
+          pMerged, all_npoints, (merged_info.points)( pMerged[ 0]),
+          (merged_info.points)( pMerged[ all_npoints-1]));
+      }
+      if( rank_merge.columns.size() > 0)
+        cout << "Merged ranks of " << rank_merge.columns.size()
+             << " appended columns" << endl;
+
+      // Resize the current data buffer
+      for( int j=0; j<nvars; j++) {
         (column_info[j].points).resize( all_npoints-1);
       }
 
@@ -513,8 +591,10 @@ int Data_File_Manager::load_data_file()
              << ") != total(" << npoints << ")" << endl;
     }
        
-    selected( blitz::Range( 0, new_npoints-1)) = read_selected;
-    selected( blitz::Range( new_npoints, npoints-1)) = old_selected;
+    // The current data were appended to the old data, so their selection
+    // information follows the old selection information.
+    selected( blitz::Range( 0, old_npoints-1)) = old_selected;
+    selected( blitz::Range( old_npoints, npoints-1)) = read_selected;
     // selected( blitz::Range( 0, new_npoints-1)) = 
     //   read_selected( blitz::Range( 0, new_npoints-1));
     // selected( blitz::Range( new_npoints, npoints-1)) =
@@ -523,6 +603,7 @@ int Data_File_Manager::load_data_file()
   else selected = read_selected;
   read_selected.free();
   old_selected.free();
+  Plot_Window::selection_generation++;
   
   // Refresh edit window, if it exists.
   refresh_edit_column_info();
@@ -532,6 +613,10 @@ int Data_File_Manager::load_data_file()
   isAsciiData = 1-inputFileType_;   // COnversion needed for legacy reasons
   if( doAppend > 0 | doMerge > 0) isSavedFile_ = 0;
   else isSavedFile_ = 1;
+
+  // Rank columns in the background, then write the cache file, if any
+  if( doWriteCache) Rank_Scheduler::start( cb_write_cache_file, (void*) this);
+  else Rank_Scheduler::start();
   return 0;
 }
 
@@ -940,155 +1025,13 @@ int Data_File_Manager::read_ascii_file_with_headers()
   for( int j=0; j<nDataColumns_; j++)
     (column_info[j].points).resize( npoints);
   
-  // Loop: Read successive lines from the file
+  // Read and parse the data block in newline-aligned chunks, several at a
+  // time.  If the first line of the data block has already been read, it is
+  // parsed first.
   int nSkip = 0;
   nDataRows_ = 0;
-  int nTestCycle = 0, nUnreadableData = 0;
-  while( !inStream->eof() && nDataRows_<npoints) {
-  
-    // Get the next line, check for EOF, and increment accounting information
-    if( uReadNextLine) {
-      (void) getline( *inStream, line, '\n');
-      if( inStream->eof()) break;  // Break here to make accounting work right
-      nRead++;
-    }
-
-    // Skip blank lines and comment lines
-    if( line.length() == 0 || line.find_first_of( "!#%") == 0) {
-      nSkip++;
-      uReadNextLine = 1;
-      continue;
-    }
-    uReadNextLine = 1;
-    nTestCycle++;
-    
-    // Invoke member function to examine the first line of data to identify 
-    // columns that contain ASCII values and load this information into the 
-    // vector of column_info objects
-    if( nDataRows_ == 0) extract_column_types( line);
-    
-    // If the delimiter character is not a tab, replace tabs with spaces
-    if( delimiter_char_ != '\t')
-      replace( line.begin(), line.end(), '\t', ' ');
-
-    // Loop: Insert the string into a stream and read it
-    std::stringstream ss( line); 
-    unsigned isBadData = 0;
-    double xValue;
-    string sToken;
-    for( int j=0; j<nvars; j++) {
-    
-      // Read the next word as double or a string, depending on whether or
-      // not this column contains ASCII values.  NOTE: whitespace-delimited 
-      // and character-delimited files must be handled differently.
-      // PROBLEM: This isn't handling missing values correctly
-      if( delimiter_char_ == ' ') {
-        // if( column_info[j].hasASCII == 0) ss >> xValue;
-        // else ss >> sToken;
-        ss >> sToken;
-        if( column_info[j].hasASCII == 0) {
-          stringstream bufstream;
-          bufstream << sToken;
-          bufstream >> xValue;
-          if( sToken.compare( 0, 3, "NaN") == 0) xValue = bad_value_proxy_;
-        }
-      }
-      else {
-        std::string buf;
-        getline( ss, buf, delimiter_char_);
-        
-        // Check for missing data
-        string::size_type notwhite = buf.find_first_not_of( " ");
-        buf.erase( 0, notwhite);
-        notwhite = buf.find_last_not_of( " ");
-        buf.erase( notwhite+1);
-        if( buf.size() <= 0) xValue = bad_value_proxy_;
-        else {
-          stringstream bufstream;
-          bufstream << buf;
-          if( column_info[j].hasASCII == 0) {
-            bufstream >> xValue;
-            if( buf.compare( 0, 3, "NaN") == 0) xValue = bad_value_proxy_;
-          }
-          else bufstream >> sToken;
-        }
-      }
-
-      // Skip lines that don't appear to contain enough data
-      if( ss.eof() && j<nvars-1) {
-        cerr << " -WARNING, not enough data on line " << nRead
-             << ", skipping this line!" << endl;
-        isBadData = 1;
-        break;
-      }
-
-      // If this was selection information, load it into the READ_SELECTED
-      // vector, otherwise load it into the current data buffer.  In both 
-      // cases inspect the SS stringstream to check for values of NULL that 
-      // imply certain types of bad data and/or missing values and replace 
-      // these with a default value and clear the error flags if necessary.
-      if( !readSelectionInfo_ || j < nvars-1) {
-        if( !ss) {
-          column_info[j].points(nDataRows_) = bad_value_proxy_;
-          ss.clear();
-        }
-        else {
-          
-          // If this is numerical data, load it directly, otherwise invoke
-          // the member function of Column_Info to determine the order in
-          // which ASCII values appeared and load that order as data.
-          if( column_info[j].hasASCII == 0)
-            column_info[j].points(nDataRows_) = (float) xValue;
-          else
-            column_info[j].points(nDataRows_) = column_info[j].add_value( sToken);
-        }
-      }
-      else {
-        if( !ss) ss.clear();
-        else read_selected( nDataRows_) = (int) xValue;
-      }
-      
-      // Check for unreadable data and flag this line to be skipped.  NOTE:
-      // This should never happen, because error flags were cleared above.
-      if( !ss.good() && j<nvars-1) {
-        cerr << " -WARNING, unreadable data "
-             << "(binary or ASCII?) at line " << nRead
-             << " column " << j+1 << "," << endl
-             << "  skipping entire line." << endl;
-        nUnreadableData++;
-        isBadData = 1;
-        break;
-      }
-    }
-
-    // Loop: Check for bad data flags and flag this line to be skipped
-    for( int j=0; j<nDataColumns_; j++) {
-      if( column_info[j].points(nDataRows_) < -90e99) {
-        cerr << " -WARNING, bad data flag (<-90e99) at line " << nRead
-             << ", column " << j << " - skipping entire line\n";
-        isBadData = 1;
-        break;
-      }
-    }
-
-    // Check for too much unreadable data
-    if( nTestCycle >= MAX_NTESTCYCLES) {
-      if( nUnreadableData >= MAX_NUNREADABLELINES) {
-        cerr << " -ERROR: " << nUnreadableData << " out of " << nTestCycle
-             << " lines of unreadable data at line " << nDataRows_+1 << endl;
-        sErrorMessage = "Too much unreadable data in an ASCII file";
-        return 1;
-      }
-      nTestCycle = 0;
-    }
-
-    // If data were good, increment the number of lines
-    if( !isBadData) {
-      nDataRows_++;
-      if( (nDataRows_+1)%10000 == 0)
-        cerr << "  Read " << nDataRows_+1 << " rows of data." << endl;
-    }
-  }
+  if( read_ascii_data_block( inStream, line, !uReadNextLine, nRead, nSkip) != 0)
+    return 1;
 
   // DIAGNOSTIC: Examine column_info
   // cout << "data_file_manager::read_ascii_data: Column Information" << endl;
@@ -1183,6 +1126,255 @@ int Data_File_Manager::read_ascii_file_with_headers()
   return 0;
 }
 
+//***************************************************************************
+// Ascii_Copy -- Offsets and lookup tables used to copy parsed chunks into
+// the current data buffer, and copy_ascii_chunk( pUser, iTask), the 
+// Worker_Pool task that copies chunk iTask.  Each chunk goes to its own 
+// rows, so chunks can be copied at the same time.
+struct Ascii_Copy {
+  Ascii_Chunk* chunks;
+  int nStored;
+  int* pSelected;
+  std::vector<int> row_offset, n_copy;
+  std::vector< std::vector< std::vector<int> > > ascii_remap;
+};
+
+static void copy_ascii_chunk( void* pUser, int iTask)
+{
+  Ascii_Copy* pCopy = (Ascii_Copy*) pUser;
+  Ascii_Chunk &chunk = pCopy->chunks[ iTask];
+  int offset = pCopy->row_offset[ iTask];
+  int nCopy = pCopy->n_copy[ iTask];
+  if( nCopy <= 0) return;
+  for( int j=0; j<pCopy->nStored; j++) {
+    float* pTarget = 
+      (Data_File_Manager::column_info[ j].points).data() + offset;
+    const float* pSource = &chunk.values[ (size_t) j * chunk.nRowsMax];
+    if( chunk.hasASCII[ j] == 0)
+      memcpy( pTarget, pSource, nCopy * sizeof( float));
+    else {
+      const std::vector<int> &remap = pCopy->ascii_remap[ iTask][ j];
+      for( int i=0; i<nCopy; i++) pTarget[ i] = remap[ (int) pSource[ i]];
+    }
+  }
+  if( chunk.hasSelectionInfo)
+    memcpy( pCopy->pSelected + offset, &chunk.selection[ 0], nCopy * sizeof( int));
+}
+
+//***************************************************************************
+// Data_File_Manager::read_ascii_data_block( inStream, firstLine, 
+// uUseFirstLine, nRead, nSkip) -- Read the data block of an ASCII file into 
+// the current data buffer, which must already have been sized to hold 
+// NPOINTS rows.  The stream is read in large blocks, each block is split 
+// into newline-aligned chunks, and the chunks are parsed on several threads 
+// by Ascii_Chunk objects.  The results are then merged in order: ASCII 
+// values are added to the lookup table of each column in the order a 
+// sequential read would have found them, warnings are issued, the test for 
+// too much unreadable data is applied as if lines had been read one at a 
+// time, and the chunks are copied into their rows of the data buffer.  If 
+// UUSEFIRSTLINE is set, FIRSTLINE holds the first line of the data block, 
+// which has already been read from the stream.  NREAD and NSKIP are 
+// incremented by the number of lines read and skipped.  Sets nDataRows_.  
+// Returns 0 if successful.
+int Data_File_Manager::read_ascii_data_block( 
+  istream* inStream, string &firstLine, unsigned uUseFirstLine,
+  int &nRead, int &nSkip)
+{
+  // Size each read to give every thread several chunks to work on
+  int nThreads = Worker_Pool::n_threads();
+  size_t block_size = (size_t) ASCII_CHUNK_SIZE * ASCII_CHUNKS_PER_THREAD * nThreads;
+
+  // Number of columns stored in the data buffer
+  int nStored = nvars;
+  if( readSelectionInfo_) nStored--;
+
+  // Define buffer.  NCARRY characters at the start of the buffer are left 
+  // over from the last read.
+  std::vector<char> buffer;
+  size_t nCarry = 0;
+  if( uUseFirstLine) {
+    buffer.resize( firstLine.size()+1);
+    memcpy( &buffer[ 0], firstLine.data(), firstLine.size());
+    buffer[ firstLine.size()] = '\n';
+    nCarry = buffer.size();
+  }
+
+  // Loop: Read successive blocks until the file or the buffer is exhausted
+  int nTestCycle = 0, nUnreadableData = 0;
+  int hasColumnTypes = 0;
+  int isEOF = 0;
+  nDataRows_ = 0;
+  while( !isEOF && nDataRows_ < npoints) {
+
+    // Read the next block after any carried-over characters
+    if( buffer.size() < nCarry + block_size) buffer.resize( nCarry + block_size);
+    inStream->read( &buffer[ nCarry], block_size);
+    size_t nBytes = nCarry + (size_t) inStream->gcount();
+    if( !inStream->good()) isEOF = 1;
+
+    // Parse everything up to the last newline, and carry the rest over to
+    // the next block.  If the block doesn't contain a newline, the line is 
+    // longer than the block, so make the block bigger and try again.  At 
+    // EOF, parse everything.
+    size_t nParse = nBytes;
+    if( !isEOF) {
+      while( nParse > 0 && buffer[ nParse-1] != '\n') nParse--;
+      if( nParse == 0) {
+        nCarry = nBytes;
+        block_size *= 2;
+        continue;
+      }
+    }
+    if( nParse == 0) break;
+    const char* pBuffer = &buffer[ 0];
+
+    // Invoke member function to examine lines of data to identify columns 
+    // that contain ASCII values and load this information into the vector 
+    // of column_info objects.  As when lines were read one at a time, this
+    // is repeated until a line can be parsed into a row with the types it 
+    // gives.  NOTE: strchr() also finds the terminating '\0'.
+    for( size_t i=0; !hasColumnTypes && i<nParse; ) {
+      const char* pLineEnd = 
+        (const char*) memchr( pBuffer+i, '\n', nParse-i);
+      size_t iEnd = pLineEnd == NULL ? nParse : pLineEnd-pBuffer;
+      int isComment = 
+        pBuffer[ i] != '\0' && strchr( "!#%", pBuffer[ i]) != NULL;
+      if( iEnd > i && !isComment) {
+        extract_column_types( string( pBuffer+i, iEnd-i));
+        Ascii_Chunk probe;
+        probe.pBegin = pBuffer + i;
+        probe.pEnd = pBuffer + iEnd;
+        probe.nvars = nvars;
+        probe.hasSelectionInfo = readSelectionInfo_;
+        probe.delimiter_char = delimiter_char_;
+        probe.bad_value_proxy = bad_value_proxy_;
+        probe.hasASCII.resize( nvars);
+        for( int j=0; j<nvars; j++) 
+          probe.hasASCII[ j] = column_info[ j].hasASCII;
+        probe.parse();
+        hasColumnTypes = ( probe.nRows > 0);
+      }
+      i = iEnd+1;
+    }
+
+    // Divide the text into newline-aligned chunks, then parse them
+    int nChunks = 1 + (int) ( (nParse-1) / ASCII_CHUNK_SIZE);
+    std::vector<Ascii_Chunk> chunks( nChunks);
+    size_t iBegin = 0;
+    for( int k=0; k<nChunks; k++) {
+      size_t iEnd = nParse;
+      if( k < nChunks-1) {
+        iEnd = ( nParse * (k+1)) / nChunks;
+        if( iEnd < iBegin) iEnd = iBegin;
+        while( iEnd < nParse && pBuffer[ iEnd-1] != '\n') iEnd++;
+      }
+      chunks[ k].pBegin = pBuffer + iBegin;
+      chunks[ k].pEnd = pBuffer + iEnd;
+      chunks[ k].nvars = nvars;
+      chunks[ k].hasSelectionInfo = readSelectionInfo_;
+      chunks[ k].delimiter_char = delimiter_char_;
+      chunks[ k].bad_value_proxy = bad_value_proxy_;
+      chunks[ k].hasASCII.resize( nvars);
+      for( int j=0; j<nvars; j++) 
+        chunks[ k].hasASCII[ j] = column_info[ j].hasASCII;
+      iBegin = iEnd;
+    }
+    Worker_Pool::run_tasks( Ascii_Chunk::parse_task, (void*) &chunks[ 0], nChunks);
+
+    // Loop: Merge the chunks in order
+    Ascii_Copy ascii_copy;
+    ascii_copy.chunks = &chunks[ 0];
+    ascii_copy.nStored = nStored;
+    ascii_copy.pSelected = read_selected.data();
+    ascii_copy.row_offset.resize( nChunks, 0);
+    ascii_copy.n_copy.resize( nChunks, 0);
+    ascii_copy.ascii_remap.resize( nChunks);
+    for( int k=0; k<nChunks && nDataRows_ < npoints; k++) {
+      Ascii_Chunk &chunk = chunks[ k];
+
+      // Report lines that were skipped
+      for( unsigned int i=0; i<chunk.short_lines.size(); i++)
+        cerr << " -WARNING, not enough data on line " 
+             << nRead + chunk.short_lines[ i] + 1
+             << ", skipping this line!" << endl;
+      for( unsigned int i=0; i<chunk.flagged_lines.size(); i++)
+        cerr << " -WARNING, bad data flag (<-90e99) at line " 
+             << nRead + chunk.flagged_lines[ i] + 1
+             << " - skipping entire line\n";
+      for( unsigned int i=0; i<chunk.unreadable_lines.size(); i++)
+        cerr << " -WARNING, unreadable data "
+             << "(binary or ASCII?) at line " 
+             << nRead + chunk.unreadable_lines[ i] + 1 << "," << endl
+             << "  skipping entire line." << endl;
+
+      // Check for too much unreadable data every MAX_NTESTCYCLES tested 
+      // lines, just as if the lines had been read one at a time
+      unsigned int iUnreadable = 0;
+      int iTested = 0;
+      while( nTestCycle + (chunk.nTested - iTested) >= MAX_NTESTCYCLES) {
+        iTested += MAX_NTESTCYCLES - nTestCycle;
+        while( iUnreadable < chunk.unreadable_tested.size() &&
+               chunk.unreadable_tested[ iUnreadable] < iTested) {
+          nUnreadableData++;
+          iUnreadable++;
+        }
+        if( nUnreadableData >= MAX_NUNREADABLELINES) {
+          cerr << " -ERROR: " << nUnreadableData << " out of " 
+               << MAX_NTESTCYCLES << " lines of unreadable data at line " 
+               << nDataRows_+1 << endl;
+          sErrorMessage = "Too much unreadable data in an ASCII file";
+          return 1;
+        }
+        nTestCycle = 0;
+      }
+      nTestCycle += chunk.nTested - iTested;
+      nUnreadableData += chunk.unreadable_tested.size() - iUnreadable;
+
+      // Decide where this chunk's rows go and how many of them fit
+      int nCopy = chunk.nRows;
+      if( nCopy > npoints - nDataRows_) nCopy = npoints - nDataRows_;
+      ascii_copy.row_offset[ k] = nDataRows_;
+      ascii_copy.n_copy[ k] = nCopy;
+
+      // Loop: Add this chunk's ASCII values to the lookup table of each 
+      // column, in order of appearance, and record their codes.  If only 
+      // some of the rows fit, only add values that appear in those rows.
+      ascii_copy.ascii_remap[ k].resize( nvars);
+      for( int j=0; j<nStored; j++) {
+        if( column_info[ j].hasASCII == 0) continue;
+        std::vector<int> &remap = ascii_copy.ascii_remap[ k][ j];
+        int nTokens = chunk.ascii_tokens[ j].size();
+        remap.resize( nTokens, 0);
+        std::vector<int> isUsed( nTokens, 1);
+        if( nCopy < chunk.nRows) {
+          isUsed.assign( nTokens, 0);
+          for( int i=0; i<nCopy; i++) 
+            isUsed[ (int) chunk.values[ (size_t) j * chunk.nRowsMax + i]] = 1;
+        }
+        for( int i=0; i<nTokens; i++)
+          if( isUsed[ i]) 
+            remap[ i] = column_info[ j].add_value( chunk.ascii_tokens[ j][ i]);
+      }
+
+      // Update accounting information and report progress
+      nRead += chunk.nLines;
+      nSkip += chunk.nSkipped;
+      if( nDataRows_/100000 != (nDataRows_+nCopy)/100000)
+        cerr << "  Read " << nDataRows_+nCopy << " rows of data." << endl;
+      nDataRows_ += nCopy;
+    }
+
+    // Copy the chunks into the data buffer
+    Worker_Pool::run_tasks( copy_ascii_chunk, (void*) &ascii_copy, nChunks);
+
+    // Move the characters left over to the start of the buffer
+    nCarry = nBytes - nParse;
+    if( nCarry > 0) memmove( &buffer[ 0], &buffer[ nParse], nCarry);
+  }
+
+  return 0;
+}
+
 //***************************************************************************
 // Data_File_Manager::read_binary_file_with_headers() -- Open and read a 
 // binary file.  The file is asssumed to consist of a single header line of 
@@ -1373,6 +1565,18 @@ int Data_File_Manager::read_binary_file_with_headers()
          << endl;
     return 1;
   }
+
+  // If possible, map the data block into memory and use views of the 
+  // mapped file rather than reading and copying it.  If this fails for any 
+  // reason, fall back to conventional reads.
+  if( memory_map_mode && !include_line_number) {
+    if( map_binary_file( ftell( pInFile)) == 0) {
+      fclose( pInFile);
+      return 0;
+    }
+    cout << " -Couldn't memory-map binary file, reading it instead" << endl;
+  }
+
   for( int j=0; j<nDataColumns_; j++)
     (column_info[j].points).resize( npoints);
     
@@ -1536,6 +1740,530 @@ int Data_File_Manager::read_binary_file_with_headers()
   return 0;
 }
 
+//***************************************************************************
+// Data_File_Manager::map_binary_file( data_offset) -- Memory-map the binary
+// file whose header has just been read by read_binary_file_with_headers() 
+// and make the points array of each column a view into the data block, 
+// which starts DATA_OFFSET bytes into the file.  For the default (column
+// major) ordering each view is strided by NVARS, otherwise each column is 
+// a contiguous block of NPOINTS values.  Nothing is copied except the 
+// selection information, if any.  Columns that must be modified are 
+// copied as needed by Column_Info::materialize().  Returns 0 if successful,
+// or nonzero if the file couldn't be mapped and must be read conventionally,
+// in which case column_info and the global arrays are left as they were.
+int Data_File_Manager::map_binary_file( long data_offset)
+{
+  // The data block must be aligned for floats to be read in place
+  if( data_offset <= 0 || data_offset % sizeof( float) != 0) {
+    cout << " -Data block isn't aligned on a " << sizeof( float)
+         << "-byte boundary" << endl;
+    return 1;
+  }
+
+  // Map the file.  Hold a reference while the views are being set up.
+  Mapped_File* pMappedFile = Mapped_File::open( inFileSpec);
+  if( pMappedFile == NULL) return 1;
+  pMappedFile->attach();
+  if( pMappedFile->length() <= (size_t) data_offset) {
+    pMappedFile->release();
+    return 1;
+  }
+  size_t data_length = pMappedFile->length() - data_offset;
+  float* pData = (float*) (pMappedFile->data() + data_offset);
+
+  // Determine the number of rows and the spacing between successive values
+  // of each column.
+  int nrows = 0, stride = 1;
+  if( isColumnMajor == 1) {
+    cout << " -Memory-mapping binary file in column-major order" << endl;
+    size_t file_rows = data_length / ( nvars*sizeof( float));
+    nrows = maxpoints_;
+    if( npoints_cmd_line > 0) nrows = npoints_cmd_line;
+    if( file_rows < (size_t) nrows) nrows = (int) file_rows;
+    stride = nvars;
+    if( data_length % ( nvars*sizeof( float)) != 0)
+      cerr << " -WARNING: file ends with a partial row, which is ignored"
+           << endl;
+  }
+  else {
+    cout << " -Memory-mapping binary file in row-major order "
+         << "with nvars=" << nvars
+         << ", npoints=" << npoints_cmd_line << endl;
+    nrows = npoints_cmd_line;
+    stride = 1;
+    if( nrows > 0 && 
+        data_length < (size_t) nvars * nrows * sizeof( float)) nrows = 0;
+  }
+  if( nrows <= 0 || nrows > maxpoints_) {
+    pMappedFile->release();
+    return 1;
+  }
+
+  // Loop: Make each column a view of the mapped data and copy the column of
+  // selection information, if any, to the read_selected array.  
+  for( int j=0; j<nvars; j++) {
+    float* pColumn = pData + j;
+    if( isColumnMajor != 1) pColumn = pData + (size_t) j * nrows;
+    if( readSelectionInfo_ && j == nvars-1) {
+      for( int i=0; i<nrows; i++) 
+        read_selected( i) = (int) pColumn[ (size_t) i * stride];
+    }
+    else column_info[j].map_points( pMappedFile, pColumn, nrows, stride);
+  }
+
+  // The views now hold their own references to the file
+  pMappedFile->release();
+
+  // Update number of rows, then check for and remove the column of 
+  // selection information
+  npoints = nrows;
+  nDataRows_ = nrows;
+  cout << " -Finished mapping " << npoints << " rows of data." << endl;
+  nDataColumns_ = remove_column_of_selection_info()-1;
+  nvars = nDataColumns_;
+  return 0;
+}
+
+//***************************************************************************
+// Helper functions for cache files.  cache_aligned( n) rounds N up to the 
+// alignment of the blocks of a cache file, cache_checksum( p, n, stride) 
+// returns a Fletcher checksum of the N 4-byte items P[ 0], P[ stride], ..., 
+// and split_cache_line( p, pEnd, fields) splits the tab-separated header 
+// line that starts at P into FIELDS and advances P to the start of the next
+// line.  split_cache_line() returns 0 if there is no complete line.
+static size_t cache_aligned( size_t n)
+{
+  size_t alignment = Data_File_Manager::CACHE_ALIGNMENT;
+  return alignment * ( ( n + alignment - 1) / alignment);
+}
+
+static unsigned long long cache_checksum( const void* p, int n, int stride)
+{
+  const char* pItem = (const char*) p;
+  unsigned long long sum1 = 0, sum2 = 0;
+  for( int i=0; i<n; i++, pItem += (size_t) stride * 4) {
+    unsigned int item;
+    memcpy( &item, pItem, 4);
+    sum1 = ( sum1 + item) % 0xffffffffULL;
+    sum2 = ( sum2 + sum1) % 0xffffffffULL;
+  }
+  return ( sum2 << 32) | sum1;
+}
+
+static int split_cache_line( 
+  const char* &p, const char* pEnd, std::vector<string> &fields)
+{
+  fields.erase( fields.begin(), fields.end());
+  const char* pLineEnd = (const char*) memchr( p, '\n', pEnd-p);
+  if( pLineEnd == NULL) return 0;
+  while( 1) {
+    const char* pTab = (const char*) memchr( p, '\t', pLineEnd-p);
+    if( pTab == NULL) pTab = pLineEnd;
+    fields.push_back( string( p, pTab-p));
+    if( pTab == pLineEnd) break;
+    p = pTab+1;
+  }
+  p = pLineEnd+1;
+  return 1;
+}
+
+//***************************************************************************
+// Data_File_Manager::cache_filespec() -- Filespec of the cache file for 
+// the current input file.
+string Data_File_Manager::cache_filespec()
+{
+  return inFileSpec + ".vpc";
+}
+
+//***************************************************************************
+// Data_File_Manager::cache_key() -- Generate the string that identifies the 
+// input file and the read parameters that affect its contents.  A cache 
+// file may be used only if its key matches.  Returns an empty string if the 
+// input file doesn't exist.
+string Data_File_Manager::cache_key()
+{
+  struct stat file_stat;
+  if( stat( inFileSpec.c_str(), &file_stat) != 0) return string( "");
+  ostringstream oss;
+  oss << "size " << (long long) file_stat.st_size
+      << " mtime " << (long long) file_stat.st_mtime
+      << " format " << inputFileType_
+      << " delimiter " << (int) delimiter_char_
+      << " bad_value " << bad_value_proxy_
+      << " skip_lines " << nSkipHeaderLines
+      << " commented_labels " << doCommentedLabels_
+      << " column_major " << isColumnMajor
+      << " npoints " << npoints_cmd_line
+      << " nvars " << nvars_cmd_line
+      << " maxpoints " << maxpoints_
+      << " maxvars " << maxvars_
+      << " trivial_columns " << ( trivial_columns_mode ? 1 : 0);
+  return oss.str();
+}
+
+//***************************************************************************
+// Data_File_Manager::prepare_cache_file() -- Save the key, filespec, and 
+// selection information of the file that was just read for use by 
+// write_cache_file(), which may be called much later.  Returns 0 if 
+// successful.
+int Data_File_Manager::prepare_cache_file()
+{
+  sCacheKey_ = cache_key();
+  sCacheSpec_ = cache_filespec();
+  cache_selected_.free();
+  if( sCacheKey_.length() <= 0 || npoints <= 0) return -1;
+  blitz::Range NPTS( 0, npoints-1);
+  if( blitz::any( read_selected( NPTS) != 0)) {
+    cache_selected_.resize( npoints);
+    cache_selected_ = read_selected( NPTS);
+  }
+  return 0;
+}
+
+//***************************************************************************
+// Data_File_Manager::cb_write_cache_file( pUser) -- Static callback for 
+// Rank_Scheduler::start() to write the cache file once every column has 
+// been ranked.  PUSER points to the Data_File_Manager.
+void Data_File_Manager::cb_write_cache_file( void* pUser)
+{
+  ((Data_File_Manager*) pUser)->write_cache_file();
+}
+
+//***************************************************************************
+// Data_File_Manager::write_cache_file() -- Rank every column that isn't
+// already ranked and write the data, ranks, ASCII values, data ranges, and 
+// selection information saved by prepare_cache_file() to the cache file.  
+// The file is written under a temporary name and renamed when it is 
+// complete, so a partial file is never used.  Returns 0 if successful.
+//
+// The cache file begins with a text header of tab-separated lines:
+//   CACHE_FILE_LABEL <version>
+//   key <cache key>
+//   byte_order <little|big>
+//   npoints <npoints>
+//   nvars <nvars>
+//   selection <offset of selection block, or -1> <checksum>
+//   column <label> <hasASCII> <min> <max> <data offset> <rank offset>
+//     <data checksum> <rank checksum> <nValues> <value 1> <code 1> ... 
+//     <value nValues> <code nValues>
+//   ...
+//   end_of_header
+// padded with zeros to a multiple of CACHE_ALIGNMENT bytes.  The data 
+// section follows.  It holds a block of NPOINTS floats and a block of 
+// NPOINTS integer ranks for each column, and an optional block of NPOINTS 
+// integer selection flags.  Each block starts on a CACHE_ALIGNMENT-byte 
+// boundary, and its offset is measured from the start of the data section.
+// The checksums are those of cache_checksum().
+int Data_File_Manager::write_cache_file()
+{
+#ifdef __WIN32__
+  return -1;
+#else
+  string sKey = sCacheKey_;
+  string sCacheSpec = sCacheSpec_;
+  sCacheKey_ = "";
+  if( sKey.length() <= 0 || npoints <= 0 || nvars <= 0) return -1;
+
+  // Labels and ASCII values must not contain the characters used to
+  // separate fields and lines of the header
+  for( int j=0; j<nvars; j++) {
+    int isBad = 
+      ( column_info[j].label).find_first_of( "\t\n") != string::npos;
+    for(
+      map<string,int>::iterator iter = (column_info[j].ascii_values_).begin();
+      iter != (column_info[j].ascii_values_).end(); iter++)
+      if( (iter->first).find_first_of( "\t\n") != string::npos) isBad = 1;
+    if( isBad) {
+      cout << " -Column <" << column_info[j].label.c_str()
+           << "> can't be stored in a cache file" << endl;
+      return -1;
+    }
+  }
+
+  // Rank every column so that the ranks can be stored
+  for( int j=0; j<nvars; j++) column_info[j].rank();
+
+  // Determine the layout of the data section
+  blitz::Range NPTS( 0, npoints-1);
+  size_t block_length = cache_aligned( (size_t) npoints * sizeof( float));
+  int hasSelection = ( cache_selected_.rows() == npoints);
+  long selection_offset = -1;
+  if( hasSelection) selection_offset = 2 * nvars * block_length;
+  unsigned long long selection_checksum = 0;
+  if( hasSelection) 
+    selection_checksum = cache_checksum( cache_selected_.data(), npoints, 1);
+
+  // Generate the header
+  int one = 1;
+  ostringstream header;
+  header << CACHE_FILE_LABEL << "\t" << CACHE_FILE_VERSION << "\n"
+         << "key\t" << sKey << "\n"
+         << "byte_order\t" << ( *((char*) &one) == 1 ? "little" : "big")
+         << "\n"
+         << "npoints\t" << npoints << "\n"
+         << "nvars\t" << nvars << "\n"
+         << "selection\t" << selection_offset 
+         << "\t" << selection_checksum << "\n";
+  header.precision( 9);
+  for( int j=0; j<nvars; j++) {
+    header << "column\t" << column_info[j].label
+           << "\t" << column_info[j].hasASCII
+           << "\t" << column_info[j].minValue
+           << "\t" << column_info[j].maxValue
+           << "\t" << 2*j*block_length
+           << "\t" << (2*j+1)*block_length
+           << "\t" << cache_checksum( 
+                         (column_info[j].points).data(), npoints,
+                         (column_info[j].points).stride( 0))
+           << "\t" << cache_checksum( 
+                         (column_info[j].ranked_points).data(), npoints, 1)
+           << "\t" << (column_info[j].ascii_values_).size();
+    for(
+      map<string,int>::iterator iter = 
+        (column_info[j].ascii_values_).begin();
+      iter != (column_info[j].ascii_values_).end(); iter++)
+      header << "\t" << iter->first << "\t" << iter->second;
+    header << "\n";
+  }
+  header << "end_of_header\n";
+  string sHeader = header.str();
+
+  // Open a temporary file
+  string sTempSpec = sCacheSpec + ".tmp";
+  FILE* pOutFile = fopen( sTempSpec.c_str(), "wb");
+  if( pOutFile == NULL) {
+    cout << " -Couldn't open cache file <" << sTempSpec.c_str() 
+         << ">" << endl;
+    return -1;
+  }
+
+  // Write the header and the blocks of the data section, each padded to
+  // the alignment
+  std::vector<char> padding( CACHE_ALIGNMENT, 0);
+  size_t data_length = (size_t) npoints * sizeof( float);
+  size_t pad_length = block_length - data_length;
+  int isBad = 0;
+  if( fwrite( sHeader.c_str(), 1, sHeader.length(), pOutFile) != 
+      sHeader.length()) isBad = 1;
+  size_t header_pad = cache_aligned( sHeader.length()) - sHeader.length();
+  if( header_pad > 0 && 
+      fwrite( &padding[ 0], 1, header_pad, pOutFile) != header_pad) isBad = 1;
+  for( int j=0; j<nvars && !isBad; j++) {
+    
+    // Views into memory-mapped files may not be contiguous
+    blitz::Array<float,1> buffer;
+    if( (column_info[j].points).stride( 0) == 1)
+      buffer.reference( column_info[j].points);
+    else {
+      buffer.resize( npoints);
+      buffer = column_info[j].points( NPTS);
+    }
+    if( fwrite( buffer.data(), 1, data_length, pOutFile) != data_length ||
+        fwrite( (column_info[j].ranked_points).data(), 1, data_length,
+                pOutFile) != data_length) isBad = 1;
+    if( pad_length > 0 && 
+        ( fwrite( &padding[ 0], 1, pad_length, pOutFile) != pad_length ||
+          fwrite( &padding[ 0], 1, pad_length, pOutFile) != pad_length))
+      isBad = 1;
+  }
+  if( hasSelection && !isBad &&
+      fwrite( cache_selected_.data(), 1, data_length, pOutFile) != data_length)
+    isBad = 1;
+  cache_selected_.free();
+  if( fclose( pOutFile) != 0) isBad = 1;
+
+  // If something went wrong, remove the temporary file, otherwise give it
+  // its final name
+  if( isBad || rename( sTempSpec.c_str(), sCacheSpec.c_str()) != 0) {
+    cout << " -Couldn't write cache file <" << sCacheSpec.c_str() 
+         << ">" << endl;
+    unlink( sTempSpec.c_str());
+    return -1;
+  }
+  cout << "Data_File_Manager::write_cache_file: Wrote cache file <"
+       << sCacheSpec.c_str() << ">" << endl;
+  return 0;
+#endif // __WIN32__
+}
+
+//***************************************************************************
+// Data_File_Manager::read_cache_file() -- If the current input file has a 
+// cache file whose key matches, memory-map it and make the data and ranks 
+// of each column views into it.  Nothing is parsed or ranked.  Sets nvars,
+// npoints, the column information, and read_selected.  Every block is 
+// checked against its checksum before it is used, and the ranks must be a 
+// permutation of the rows.  Columns whose ranks fail these checks are 
+// ranked again in the background.  Returns 0 if successful, nonzero if 
+// there is no usable cache file, in which case the column information is 
+// unchanged.
+int Data_File_Manager::read_cache_file()
+{
+  string sCacheSpec = cache_filespec();
+  struct stat cache_stat;
+  if( stat( sCacheSpec.c_str(), &cache_stat) != 0) return 1;
+  string sKey = cache_key();
+  if( sKey.length() <= 0) return 1;
+  
+  Mapped_File* pMappedFile = Mapped_File::open( sCacheSpec);
+  if( pMappedFile == NULL) return 1;
+  pMappedFile->attach();
+  const char* pBegin = pMappedFile->data();
+  const char* pEnd = pBegin + pMappedFile->length();
+
+  // Loop: Read and check the lines of the header.  Any problem means the
+  // cache can't be used.
+  int one = 1;
+  string sByteOrder = ( *((char*) &one) == 1) ? "little" : "big";
+  int cache_npoints = 0, cache_nvars = 0, isBad = 0, isDone = 0;
+  long selection_offset = -1;
+  unsigned long long selection_checksum = 0;
+  std::vector<Column_Info> cache_column_info;
+  std::vector<long> data_offsets, rank_offsets;
+  std::vector<unsigned long long> data_checksums, rank_checksums;
+  std::vector<string> fields;
+  const char* p = pBegin;
+  for( int iLine = 0; !isDone && !isBad; iLine++) {
+    if( split_cache_line( p, pEnd, fields) == 0) {
+      isBad = 1;
+      break;
+    }
+    if( iLine == 0) {
+      if( fields.size() != 2 || fields[ 0] != CACHE_FILE_LABEL ||
+          atoi( fields[ 1].c_str()) != CACHE_FILE_VERSION) isBad = 1;
+    }
+    else if( fields[ 0] == "key") {
+      if( fields.size() != 2 || fields[ 1] != sKey) isBad = 1;
+    }
+    else if( fields[ 0] == "byte_order") {
+      if( fields.size() != 2 || fields[ 1] != sByteOrder) isBad = 1;
+    }
+    else if( fields[ 0] == "npoints" && fields.size() == 2)
+      cache_npoints = atoi( fields[ 1].c_str());
+    else if( fields[ 0] == "nvars" && fields.size() == 2)
+      cache_nvars = atoi( fields[ 1].c_str());
+    else if( fields[ 0] == "selection" && fields.size() == 3) {
+      selection_offset = atol( fields[ 1].c_str());
+      selection_checksum = strtoull( fields[ 2].c_str(), NULL, 10);
+    }
+    else if( fields[ 0] == "column" && fields.size() >= 10) {
+      Column_Info column_info_buf;
+      column_info_buf.label = fields[ 1];
+      column_info_buf.hasASCII = atoi( fields[ 2].c_str());
+      column_info_buf.minValue = strtod( fields[ 3].c_str(), NULL);
+      column_info_buf.maxValue = strtod( fields[ 4].c_str(), NULL);
+      data_offsets.push_back( atol( fields[ 5].c_str()));
+      rank_offsets.push_back( atol( fields[ 6].c_str()));
+      data_checksums.push_back( strtoull( fields[ 7].c_str(), NULL, 10));
+      rank_checksums.push_back( strtoull( fields[ 8].c_str(), NULL, 10));
+      unsigned int nValues = atoi( fields[ 9].c_str());
+      if( fields.size() != 10 + 2*nValues) isBad = 1;
+      for( unsigned int k=0; k<nValues && !isBad; k++)
+        (column_info_buf.ascii_values_).insert(
+          map<string,int>::value_type( 
+            fields[ 10+2*k], atoi( fields[ 11+2*k].c_str())));
+      cache_column_info.push_back( column_info_buf);
+    }
+    else if( fields[ 0] == "end_of_header") isDone = 1;
+    else isBad = 1;
+  }
+
+  // Check sizes, then make sure every block lies inside the file and is 
+  // aligned
+  size_t data_start = cache_aligned( p - pBegin);
+  size_t data_length = (size_t) cache_npoints * sizeof( float);
+  if( cache_npoints <= 0 || cache_npoints > maxpoints_ ||
+      cache_nvars <= 0 || cache_nvars > maxvars_ ||
+      (int) cache_column_info.size() != cache_nvars) isBad = 1;
+  for( int j=0; j<cache_nvars && !isBad; j++) {
+    long offsets[ 2] = { data_offsets[ j], rank_offsets[ j]};
+    for( int k=0; k<2; k++)
+      if( offsets[ k] < 0 || offsets[ k] % CACHE_ALIGNMENT != 0 ||
+          data_start + offsets[ k] + data_length > pMappedFile->length())
+        isBad = 1;
+  }
+  if( selection_offset >= 0 &&
+      ( selection_offset % CACHE_ALIGNMENT != 0 ||
+        data_start + selection_offset + data_length > pMappedFile->length()))
+    isBad = 1;
+
+  // Check the data and the selection against their checksums, and the 
+  // selection for valid brush indices
+  const char* pData = pBegin + data_start;
+  for( int j=0; j<cache_nvars && !isBad; j++) {
+    if( cache_checksum( pData + data_offsets[ j], cache_npoints, 1) != 
+        data_checksums[ j]) isBad = 1;
+  }
+  if( selection_offset >= 0 && !isBad) {
+    const int* pSelection = (const int*) ( pData + selection_offset);
+    if( cache_checksum( pSelection, cache_npoints, 1) != selection_checksum)
+      isBad = 1;
+    for( int i=0; i<cache_npoints && !isBad; i++) {
+      if( pSelection[ i] < 0 || pSelection[ i] >= NBRUSHES) isBad = 1;
+    }
+  }
+  if( isBad) {
+    cout << " -Cache file <" << sCacheSpec.c_str()
+         << "> is out of date or unreadable, ignoring it" << endl;
+    pMappedFile->release();
+    return 1;
+  }
+
+  // Loop: Load the column information and make the data and ranks of each 
+  // column views into the mapped file
+  cout << " -Memory-mapping cache file <" << sCacheSpec.c_str() << ">" 
+       << endl;
+  npoints = cache_npoints;
+  nvars = cache_nvars;
+  column_info.erase( column_info.begin(), column_info.end());
+  std::vector<unsigned char> isRanked;
+  int nUnranked = 0;
+  for( int j=0; j<nvars; j++) {
+    column_info.push_back( cache_column_info[ j]);
+    column_info[j].map_points( 
+      pMappedFile, (float*) ( pData + data_offsets[ j]), npoints, 1);
+
+    // Use the ranks only if they match their checksum and hold every row 
+    // exactly once
+    const int* pRanks = (const int*) ( pData + rank_offsets[ j]);
+    int isGood = 
+      cache_checksum( pRanks, npoints, 1) == rank_checksums[ j];
+    if( isGood) {
+      isRanked.assign( npoints, 0);
+      for( int i=0; i<npoints && isGood; i++) {
+        int rank = pRanks[ i];
+        if( rank < 0 || rank >= npoints || isRanked[ rank]) isGood = 0;
+        else isRanked[ rank] = 1;
+      }
+    }
+    if( isGood) 
+      column_info[j].map_ranks( pMappedFile, (int*) pRanks, npoints);
+    else nUnranked++;
+  }
+  if( nUnranked > 0) {
+    cout << " -" << nUnranked << " columns of cache file <" 
+         << sCacheSpec.c_str() << "> have bad ranks, re-ranking them" 
+         << endl;
+  }
+  Column_Info column_info_buf;
+  column_info_buf.label = string( "-nothing-");
+  column_info.push_back( column_info_buf);
+
+  // Copy selection information, if any
+  readSelectionInfo_ = ( selection_offset >= 0);
+  if( readSelectionInfo_) {
+    const int* pSelection = (const int*) ( pData + selection_offset);
+    for( int i=0; i<npoints; i++) read_selected( i) = pSelection[ i];
+  }
+
+  // The views now hold their own references to the file
+  pMappedFile->release();
+  nDataRows_ = npoints;
+  nDataColumns_ = nvars;
+  cout << " -Finished mapping " << npoints << " rows of cached data." 
+       << endl;
+  return 0;
+}
+
 //***************************************************************************
 // Data_File_Manager::read_table_from_fits_file() -- Open a FITS file and 
 // read a table extension.  Note that unlike ASCII and binary file reads,
@@ -2191,7 +2919,7 @@ int Data_File_Manager::write_ascii_file_with_headers()
           else
             os << column_info[jcol].ascii_value( (int) column_info[jcol].points(irow));
         }
-        if( writeSelectionInfo_ != 0) os << delimiter_char_ << " " << selected( irow);
+        if( writeSelectionInfo_ != 0) os << delimiter_char_ << " " << (int) selected( irow);
         os << endl;
         rows_written++;
       }
@@ -2674,6 +3402,11 @@ void Data_File_Manager::delete_labels( Fl_Widget *o, void* user_data)
           << ") but only " << nvars << " attributes" << endl;
   }
   
+  // Stop background ranking and discard normalized axes before any column
+  // is moved
+  Rank_Scheduler::stop();
+  Axis_Cache::clear();
+
   // Move and resize data and column labels.  Do this inside the same loop 
   // to reduce the chance of doing it wrong.  NOTE: What should be done with
   // the array of ranked points used to perform scaling and normalization?
@@ -2681,7 +3414,7 @@ void Data_File_Manager::delete_labels( Fl_Widget *o, void* user_data)
   int ivar = 0;
   for( int i=0; i<nvars; i++) {
     if( edit_labels_widget->checked(i+1) <= 0) {
-      column_info[ivar].isRanked = 0;
+      column_info[ivar].unrank();
 
       Column_Info column_info_buf;  // Why is this necessary?
       column_info_buf = column_info[i];
@@ -2747,7 +3480,7 @@ void Data_File_Manager::close_edit_labels_window( Fl_Widget *o, void* user_data)
 //***************************************************************************
 // Data_File_Manager::remove_trivial_columns -- Examine an array of data and 
 // remove columns for which all values are identical.  Part of the read 
-// process.
+// process.  Columns that are already ranked are tested using their range.
 void Data_File_Manager::remove_trivial_columns()
 {
   blitz::Range NPTS( 0, npoints-1);
@@ -2761,7 +3494,12 @@ void Data_File_Manager::remove_trivial_columns()
   // Loop: Examine the data array column by colums and remove any columns for 
   // which all values are identical.
   while( current < nvars-1) {
-    if( blitz::all( column_info[current].points(NPTS) == column_info[current].points(0))) {
+    int isTrivial = 0;
+    if( column_info[current].is_ranked())
+      isTrivial = ( column_info[current].minValue == column_info[current].maxValue);
+    else
+      isTrivial = blitz::all( column_info[current].points(NPTS) == column_info[current].points(0));
+    if( isTrivial) {
       cout << "skipping trivial column " 
            << column_info[ current].label << endl;
       for( int j=current; j<nvars-1; j++) column_info[ j] = column_info[ j+1];
@@ -2817,19 +3555,30 @@ void Data_File_Manager::resize_global_arrays()
   }
   
   // Resize and reinitialize list of ranked points to reflect the fact that 
-  // no ranking has been done.
+  // no ranking has been done.  Ranks that are still valid, e.g., because 
+  // they were read from a cache file, are kept.
   for( int i=0; i<nvars; i++) {
-    (column_info[i].ranked_points).resize(npoints);
-    column_info[i].isRanked = 0;
+    if( !column_info[i].is_ranked() ||
+        (column_info[i].ranked_points).rows() != npoints)
+      column_info[i].unrank();
   }
   
   // Resize and reinitialize selection related arrays and flags.
+  resize_selection_arrays();
+}
+
+//***************************************************************************
+// Data_File_Manager::resize_selection_arrays -- STATIC method to resize and
+// reinitialize the selection related arrays and flags for NPOINTS points.
+// Also used when points are deleted.
+void Data_File_Manager::resize_selection_arrays()
+{
   inside_footprint.resize( npoints);
   newly_selected.resize( npoints);
   selected.resize( npoints);
   previously_selected.resize( npoints);
   saved_selection.resize(npoints);
-  Plot_Window::indices_selected.resize(NBRUSHES,npoints);
+  Plot_Window::indices_selected.resize(npoints);
   reset_selection_arrays();
 }
 
@@ -2840,6 +3589,8 @@ void Data_File_Manager::create_default_data( int nvars_in)
 {
   // Protect against screwy values of nvars_in
   if( nvars_in < 2) return;
+  Rank_Scheduler::stop();
+  Axis_Cache::clear();
   nvars = nvars_in;
   // if( nvars > MAXVARS) nvars = MAXVARS;
   if( nvars > maxvars_) nvars = maxvars_;
@@ -2983,9 +3734,14 @@ void Data_File_Manager::maxpoints( int i)
 
   // If necessary, shrink the current buffer  
   if( npoints > maxpoints_) {
+    Rank_Scheduler::stop();
+    Axis_Cache::clear();
     npoints = maxpoints_;
-    for( int i=0; i<nvars; i++)
+    for( int i=0; i<nvars; i++) {
+      column_info[i].materialize();
       (column_info[i].points).resizeAndPreserve(npoints);
+      column_info[i].unrank();
+    }
       
     // Selection arrays should be resized as well
   }
@@ -71,6 +71,7 @@
 //   serialize( &ar, iFileVersion) -- Perform serialization
 //   remove_trivial_columns() -- Remove identical data
 //   resize_global_arrays() -- Resize global arrays
+//   resize_selection_arrays() -- Resize global selection arrays
 //
 //   findInputFile() -- Query user to find input file
 //   load_data_file( inFileSpec) -- Load and initialize data
@@ -80,7 +81,16 @@
 //   remove_column_of_selection_info() -- Remove column of selection info
 //   reorder_ascii_values() -- Alphabetize ascii values
 //   read_ascii_file_with_headers() -- Read ASCII
+//   read_ascii_data_block( inStream, firstLine, uUseFirstLine, nRead, 
+//     nSkip) -- Read and parse data block of ASCII file in parallel
 //   read_binary_file_with_headers() -- Read binary
+//   map_binary_file( data_offset) -- Memory-map data block of binary file
+//   cache_filespec() -- Filespec of cache file for the input file
+//   cache_key() -- String that identifies input file and read parameters
+//   read_cache_file() -- Memory-map cache file of the input file
+//   prepare_cache_file() -- Save information for write_cache_file
+//   cb_write_cache_file( pUser) -- Static callback to write cache file
+//   write_cache_file() -- Write cache file for the input file
 //   read_table_from_fits_file() -- Read FITS table extension
 //   create_default_data( nvars_in) -- Create default data
 //
@@ -186,6 +196,7 @@ class Data_File_Manager
 
     void remove_trivial_columns();
     void resize_global_arrays();
+    static void resize_selection_arrays();
 
     // Buffers to hold filespec, pathname, and selection information
     string sDirectory_, inFileSpec, outFileSpec, dataFileSpec;
@@ -218,6 +229,11 @@ class Data_File_Manager
     int maxpoints_, maxvars_;
     int nDataRows_, nDataColumns_;
 
+    // Key, filespec, and selection information of a cache file that is 
+    // waiting to be written
+    string sCacheKey_, sCacheSpec_;
+    blitz::Array<int,1> cache_selected_;
+
   public:
     // Member variable to hold column information must be declared static
     // for use with static member functions
@@ -235,7 +251,17 @@ class Data_File_Manager
     void extract_column_types( string sLine);
     int remove_column_of_selection_info();
     int read_ascii_file_with_headers();
+    int read_ascii_data_block( 
+      istream* inStream, string &firstLine, unsigned uUseFirstLine,
+      int &nRead, int &nSkip);
     int read_binary_file_with_headers();
+    int map_binary_file( long data_offset);
+    string cache_filespec();
+    string cache_key();
+    int read_cache_file();
+    int prepare_cache_file();
+    static void cb_write_cache_file( void* pUser);
+    int write_cache_file();
     int read_table_from_fits_file();
     void create_default_data( int nvars_in);
 
@@ -315,6 +341,17 @@ class Data_File_Manager
     // Define statics to hold tests for bad lines of ASCII data
     static const int MAX_NTESTCYCLES = 1000;
     static const int MAX_NUNREADABLELINES = 200;
+
+    // Define statics to hold the size of the chunks in which the data 
+    // block of an ASCII file is parsed, and the number of chunks read for 
+    // each thread at a time
+    static const int ASCII_CHUNK_SIZE = 2*1024*1024;
+    static const int ASCII_CHUNKS_PER_THREAD = 4;
+
+    // Define statics to hold the format of cache files
+    static string CACHE_FILE_LABEL;
+    static const int CACHE_FILE_VERSION = 2;
+    static const int CACHE_ALIGNMENT = 64;
 };
 
 #endif   // DATA_FILE_MANAGER_H
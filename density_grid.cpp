@@ -0,0 +1,286 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: density_grid.cpp
+//
+// Class definitions:
+//   Density_Grid -- Binned Gaussian kernel density estimate
+//
+// Classes referenced:
+//   Worker_Pool -- Pool of worker threads
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <density_grid.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "density_grid.h"
+#include "worker_pool.h"
+
+// Number of bandwidths at which the kernel is truncated, and by which the
+// grid extends beyond the points
+static const float KERNEL_WIDTH = 4.0;
+
+//***************************************************************************
+// Density_Grid::Density_Grid() -- Default constructor makes an empty grid.
+Density_Grid::Density_Grid() : nx_( 0), ny_( 0), x0_( 0.0), y0_( 0.0),
+  dx_( 1.0), dy_( 1.0), maxDensity_( 0.0), px_( NULL), py_( NULL),
+  xstride_( 1), ystride_( 1), n_( 0), nTasks_( 0), smoothRows_( 0),
+  pDensity_( NULL)
+{}
+
+//***************************************************************************
+// Density_Grid::compute( px, xstride, py, ystride, n, xmin, xmax, ymin,
+// ymax, hx, hy, nx, ny, nTasks) -- Compute the density of the N points
+// (PX[ i*xstride], PY[ i*ystride]), which lie in [XMIN,XMAX]x[YMIN,YMAX],
+// on a grid of NX by NY nodes, with a Gaussian kernel of bandwidths HX and
+// HY, using NTASKS Worker_Pool tasks (zero for as many as are worth it).
+// Points with NaN or infinite coordinates are left out.
+void Density_Grid::compute(
+  const float* px, int xstride, const float* py, int ystride, int n,
+  float xmin, float xmax, float ymin, float ymax, float hx, float hy,
+  int nx, int ny, int nTasks)
+{
+  free();
+  if( n <= 0 || px == NULL || py == NULL) return;
+  if( nx < 2) nx = 2;
+  if( ny < 2) ny = 2;
+
+  // Lay out the grid, guarding against empty ranges and bandwidths
+  if( !( xmax > xmin)) { xmin -= 0.5; xmax += 0.5;}
+  if( !( hx > 0.0)) hx = ( xmax - xmin) / nx;
+  nx_ = nx;
+  x0_ = xmin - KERNEL_WIDTH * hx;
+  dx_ = ( xmax + KERNEL_WIDTH * hx - x0_) / ( nx-1);
+  if( !( ymax > ymin)) { ymin -= 0.5; ymax += 0.5;}
+  if( !( hy > 0.0)) hy = ( ymax - ymin) / ny;
+  ny_ = ny;
+  y0_ = ymin - KERNEL_WIDTH * hy;
+  dy_ = ( ymax + KERNEL_WIDTH * hy - y0_) / ( ny-1);
+
+  if( nTasks <= 0) nTasks = Worker_Pool::n_tasks_for( n);
+
+  // Bin the points into the private grids of the tasks, and add these up
+  px_ = px;
+  py_ = py;
+  xstride_ = xstride;
+  ystride_ = ystride;
+  n_ = n;
+  nTasks_ = nTasks;
+  size_t nNodes = (size_t) nx_ * ny_;
+  taskGrids_.assign( nTasks * nNodes, 0.0);
+  Worker_Pool::run_tasks( bin_task, (void*) this, nTasks);
+  work_.assign( nNodes, 0.0);
+  for( int iTask=0; iTask<nTasks; iTask++) {
+    const double* pTask = &taskGrids_[ iTask * nNodes];
+    for( size_t k=0; k<nNodes; k++) work_[ k] += pTask[ k];
+  }
+  std::vector<double>().swap( taskGrids_);
+  double total = 0.0;
+  for( size_t k=0; k<nNodes; k++) total += work_[ k];
+  if( total <= 0.0) {
+    free();
+    return;
+  }
+
+  // Smooth the rows, then the columns
+  gaussian_kernel( hx, dx_, xKernel_);
+  smoothRows_ = 1;
+  Worker_Pool::run_tasks( smooth_task, (void*) this, min( nTasks, ny_));
+  gaussian_kernel( hy, dy_, yKernel_);
+  smoothRows_ = 0;
+  Worker_Pool::run_tasks( smooth_task, (void*) this, min( nTasks, nx_));
+
+  // Normalize the density to integrate to one
+  double scale = 1.0 / ( total * dx_ * dy_);
+  density_.resize( nNodes);
+  maxDensity_ = 0.0;
+  for( size_t k=0; k<nNodes; k++) {
+    density_[ k] = (float) ( scale * work_[ k]);
+    if( density_[ k] > maxDensity_) maxDensity_ = density_[ k];
+  }
+  std::vector<double>().swap( work_);
+}
+
+//***************************************************************************
+// Density_Grid::free() -- Release memory.
+void Density_Grid::free()
+{
+  nx_ = ny_ = 0;
+  maxDensity_ = 0.0;
+  std::vector<float>().swap( density_);
+  std::vector<double>().swap( taskGrids_);
+  std::vector<double>().swap( work_);
+}
+
+//***************************************************************************
+// Density_Grid::value( x, y) -- Density at (X,Y), interpolated from the 
+// nearest nodes.  Zero off the grid, and for NaN or infinite coordinates.
+float Density_Grid::value( float x, float y) const
+{
+  if( density_.empty() || !is_finite( x) || !is_finite( y)) return 0.0;
+  float tx = ( x - x0_) / dx_;
+  if( !( tx >= 0.0 && tx <= nx_-1)) return 0.0;
+  int i = (int) tx;
+  if( i > nx_-2) i = nx_-2;
+  float fx = tx - i;
+  float ty = ( y - y0_) / dy_;
+  if( !( ty >= 0.0 && ty <= ny_-1)) return 0.0;
+  int j = (int) ty;
+  if( j > ny_-2) j = ny_-2;
+  float fy = ty - j;
+  const float* p = &density_[ i + (size_t) nx_ * j];
+  return
+    ( 1.0f - fy) * ( ( 1.0f - fx) * p[ 0] + fx * p[ 1]) +
+    fy * ( ( 1.0f - fx) * p[ nx_] + fx * p[ nx_+1]);
+}
+
+//***************************************************************************
+// Density_Grid::interpolate( px, xstride, py, ystride, n, pDensity, nTasks)
+// -- Set PDENSITY[ i] to the density at each of the N points (PX[ i*xstride],
+// PY[ i*ystride]), using NTASKS Worker_Pool tasks (zero for as many as are
+// worth it).
+void Density_Grid::interpolate(
+  const float* px, int xstride, const float* py, int ystride, int n,
+  float* pDensity, int nTasks)
+{
+  if( n <= 0) return;
+  if( nTasks <= 0) nTasks = Worker_Pool::n_tasks_for( n);
+  px_ = px;
+  py_ = py;
+  xstride_ = xstride;
+  ystride_ = ystride;
+  n_ = n;
+  nTasks_ = nTasks;
+  pDensity_ = pDensity;
+  Worker_Pool::run_tasks( interpolate_task, (void*) this, nTasks);
+}
+
+//***************************************************************************
+// Density_Grid::gaussian_kernel( h, spacing, kernel) -- Static method to
+// set KERNEL[ k], k = 0...r, to the weights of a Gaussian of bandwidth H at
+// nodes k*SPACING from its center, truncated at KERNEL_WIDTH bandwidths and
+// normalized so the weights of all 2r+1 nodes add up to one.
+void Density_Grid::gaussian_kernel(
+  float h, float spacing, std::vector<double> &kernel)
+{
+  int r = (int) ceil( KERNEL_WIDTH * h / spacing);
+  if( r < 0) r = 0;
+  kernel.resize( r+1);
+  double sum = 0.0;
+  for( int k=0; k<=r; k++) {
+    double u = k * spacing / h;
+    kernel[ k] = exp( -0.5 * u * u);
+    sum += ( k == 0) ? kernel[ k] : 2.0 * kernel[ k];
+  }
+  for( int k=0; k<=r; k++) kernel[ k] /= sum;
+}
+
+//***************************************************************************
+// Density_Grid::bin_task( pUser, iTask) -- STATIC Worker_Pool task for
+// compute() that spreads slice ITASK of the points over the nodes around
+// them in the private grid of the task.  PUSER points to the Density_Grid.
+void Density_Grid::bin_task( void* pUser, int iTask)
+{
+  Density_Grid* pGrid = (Density_Grid*) pUser;
+  int nx = pGrid->nx_, ny = pGrid->ny_;
+  float x0 = pGrid->x0_, y0 = pGrid->y0_;
+  float xscale = 1.0f / pGrid->dx_, yscale = 1.0f / pGrid->dy_;
+  const float* px = pGrid->px_;
+  const float* py = pGrid->py_;
+  int xstride = pGrid->xstride_, ystride = pGrid->ystride_;
+  double* pNodes = &pGrid->taskGrids_[ (size_t) iTask * nx * ny];
+
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, pGrid->nTasks_, pGrid->n_, iBegin, iEnd);
+
+  // Loop: Spread each point over the four nodes around it
+  for( int i=iBegin; i<iEnd; i++) {
+    float x = px[ (size_t) i * xstride], y = py[ (size_t) i * ystride];
+    if( !is_finite( x) || !is_finite( y)) continue;
+    float tx = ( x - x0) * xscale;
+    if( !( tx >= 0.0 && tx <= nx-1)) continue;
+    int ix = (int) tx;
+    if( ix > nx-2) ix = nx-2;
+    double fx = tx - ix;
+    float ty = ( y - y0) * yscale;
+    if( !( ty >= 0.0 && ty <= ny-1)) continue;
+    int iy = (int) ty;
+    if( iy > ny-2) iy = ny-2;
+    double fy = ty - iy;
+    double* p = pNodes + ix + (size_t) nx * iy;
+    p[ 0] += ( 1.0 - fx) * ( 1.0 - fy);
+    p[ 1] += fx * ( 1.0 - fy);
+    p[ nx] += ( 1.0 - fx) * fy;
+    p[ nx+1] += fx * fy;
+  }
+}
+
+//***************************************************************************
+// Density_Grid::smooth_task( pUser, iTask) -- STATIC Worker_Pool task for
+// compute() that convolves slice ITASK of the rows (or, if smoothRows_ is
+// clear, of the columns) of the binned counts with the Gaussian kernel for
+// that direction.  Nodes off the grid count as zero.  PUSER points to the
+// Density_Grid.
+void Density_Grid::smooth_task( void* pUser, int iTask)
+{
+  Density_Grid* pGrid = (Density_Grid*) pUser;
+  int nx = pGrid->nx_, ny = pGrid->ny_;
+  int smoothRows = pGrid->smoothRows_;
+  const std::vector<double> &kernel =
+    smoothRows ? pGrid->xKernel_ : pGrid->yKernel_;
+  int r = (int) kernel.size() - 1;
+
+  // Rows have NX nodes one apart, columns have NY nodes NX apart
+  int nLines = smoothRows ? ny : nx;
+  int length = smoothRows ? nx : ny;
+  size_t step = smoothRows ? 1 : nx;
+  size_t lineStep = smoothRows ? nx : 1;
+  int nTasks = min( pGrid->nTasks_, nLines);
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, nTasks, nLines, iBegin, iEnd);
+
+  // Loop: Copy each line, then replace it by its convolution
+  std::vector<double> line( length);
+  for( int iLine=iBegin; iLine<iEnd; iLine++) {
+    double* p = &pGrid->work_[ iLine * lineStep];
+    for( int k=0; k<length; k++) line[ k] = p[ k * step];
+    for( int k=0; k<length; k++) {
+      double sum = kernel[ 0] * line[ k];
+      int mMax = min( r, max( k, length-1-k));
+      for( int m=1; m<=mMax; m++) {
+        if( k-m >= 0) sum += kernel[ m] * line[ k-m];
+        if( k+m < length) sum += kernel[ m] * line[ k+m];
+      }
+      p[ k * step] = sum;
+    }
+  }
+}
+
+//***************************************************************************
+// Density_Grid::interpolate_task( pUser, iTask) -- STATIC Worker_Pool task
+// for interpolate() that finds the density at slice ITASK of the points.
+// PUSER points to the Density_Grid.
+void Density_Grid::interpolate_task( void* pUser, int iTask)
+{
+  Density_Grid* pGrid = (Density_Grid*) pUser;
+  const float* px = pGrid->px_;
+  const float* py = pGrid->py_;
+  int xstride = pGrid->xstride_, ystride = pGrid->ystride_;
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, pGrid->nTasks_, pGrid->n_, iBegin, iEnd);
+  for( int i=iBegin; i<iEnd; i++) {
+    pGrid->pDensity_[ i] = pGrid->value( 
+      px[ (size_t) i * xstride], py[ (size_t) i * ystride]);
+  }
+}
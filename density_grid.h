@@ -0,0 +1,125 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: density_grid.h
+//
+// Class definitions:
+//   Density_Grid -- Binned Gaussian kernel density estimate
+//
+// Classes referenced:
+//   Worker_Pool -- Pool of worker threads
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Smooth 2D density estimates of the points of a plot,
+//   computed in O(N + G) time for N points and G grid nodes instead of
+//   comparing every pair of points.
+//
+// General design philosophy:
+//   1) The points are spread onto a regular grid of nodes by linear
+//      binning: each point adds weights to the four nodes around it in
+//      proportion to how close it is to them.  Each task bins a slice of
+//      the points into a private grid, and the grids are added together,
+//      as in the Histogram_Kernel.
+//   2) The binned counts are convolved with a Gaussian of bandwidths hx
+//      and hy, truncated at four bandwidths.  The Gaussian is separable,
+//      so this is a convolution of each row followed by one of each
+//      column, split over the tasks.  For the bandwidths used here the
+//      kernels are a few dozen nodes wide, so this is about as fast as an
+//      FFT and needs no FFT library.
+//   3) The grid extends four bandwidths beyond the range of the points, so
+//      no mass is lost off its edges.
+//   4) The density at any point is bilinearly interpolated from the grid.
+//      It is normalized to integrate to one over the plane, in the units of
+//      the coordinates.
+//   5) The grid touches nothing but its arguments, so the caller decides
+//      what to cache.  Plot_Window keeps one per plot, for one bandwidth.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef DENSITY_GRID_H
+#define DENSITY_GRID_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+//***************************************************************************
+// Class: Density_Grid
+//
+// Class definitions:
+//   Density_Grid -- Binned Gaussian kernel density estimate
+//
+// Classes referenced:
+//   Worker_Pool
+//
+// Purpose: Bin points onto a grid, smooth them, and interpolate the density
+//   back to the points.
+//
+// Functions:
+//   Density_Grid() -- Default constructor
+//   compute( px, xstride, py, ystride, n, xmin, xmax, ymin, ymax, hx, hy,
+//     nx, ny, nTasks) -- Compute the density of a set of points
+//   free() -- Release memory
+//   is_computed() -- Has the density been computed?
+//   value( x, y) -- Density at a point
+//   interpolate( px, xstride, py, ystride, n, pDensity, nTasks) -- Density
+//     at each of a set of points
+//   nx(), ny(), x0(), y0(), dx(), dy() -- Size and placement of the grid
+//   data() -- Density at the nodes of the grid
+//   max_value() -- Largest density at a node
+//   gaussian_kernel( h, spacing, kernel) -- Weights of a truncated Gaussian
+//   bin_task( pUser, iTask) -- Bin one slice of the points
+//   smooth_task( pUser, iTask) -- Smooth some rows or columns of the grid
+//   interpolate_task( pUser, iTask) -- Interpolate one slice of the points
+//***************************************************************************
+class Density_Grid
+{
+  public:
+    Density_Grid();
+    void compute(
+      const float* px, int xstride, const float* py, int ystride, int n,
+      float xmin, float xmax, float ymin, float ymax, float hx, float hy,
+      int nx, int ny, int nTasks);
+    void free();
+    int is_computed() const { return !density_.empty();}
+    float value( float x, float y) const;
+    void interpolate(
+      const float* px, int xstride, const float* py, int ystride, int n,
+      float* pDensity, int nTasks);
+    int nx() const { return nx_;}
+    int ny() const { return ny_;}
+    float x0() const { return x0_;}
+    float y0() const { return y0_;}
+    float dx() const { return dx_;}
+    float dy() const { return dy_;}
+    const float* data() const { return density_.empty() ? NULL : &density_[ 0];}
+    float max_value() const { return maxDensity_;}
+
+  protected:
+    // Number of nodes, position of node (0,0), and spacing of the nodes.
+    // Node (i,j) is at (x0_ + i*dx_, y0_ + j*dy_), and its density is
+    // density_[ i + nx_*j].
+    int nx_, ny_;
+    float x0_, y0_, dx_, dy_;
+    std::vector<float> density_;
+    float maxDensity_;
+
+    // Points, kernels, and private grids of the tasks during compute() and
+    // interpolate()
+    const float* px_;
+    const float* py_;
+    int xstride_, ystride_, n_, nTasks_, smoothRows_;
+    float* pDensity_;
+    std::vector<double> taskGrids_, work_;
+    std::vector<double> xKernel_, yKernel_;
+
+    static void gaussian_kernel( float h, float spacing, std::vector<double> &kernel);
+    static void bin_task( void* pUser, int iTask);
+    static void smooth_task( void* pUser, int iTask);
+    static void interpolate_task( void* pUser, int iTask);
+};
+
+#endif   // DENSITY_GRID_H
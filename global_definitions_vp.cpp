@@ -22,6 +22,8 @@
 // Functions:
 //   make_confirmation_window( text) -- Make confirmation window
 //   pow2 ( x) -- x*x
+//   is_finite( x), is_nan( x) -- Inline tests of the bits of a float, 
+//     defined in <global_definitions_vp.h>
 //
 // Author: Creon Levit    2005-2006
 // Modified: P. R. Gazis  02-OCT-2008
@@ -133,9 +135,12 @@ float pow2( float x)
 }
 
 //***************************************************************************
-// make_find_window( text, result) -- Make and manage the text search 
-// window.  Ignore return value, use non-empty res parameter as outcome.
-int make_find_window( const char* text, char *res)
+// make_find_window( text, result, useRegex, ignoreCase) -- Make and manage
+// the text search window.  Ignore return value, use non-empty res parameter
+// as outcome.  USEREGEX and IGNORECASE return the state of the search 
+// option buttons, and set their initial state.
+int make_find_window(
+  const char* text, char *res, int &useRegex, int &ignoreCase)
 {
   // Destroy any existing window
   if( find_window != NULL) find_window->hide();
@@ -168,6 +173,23 @@ int make_find_window( const char* text, char *res)
   Fl_Button* cancel_button = new Fl_Button( 150, nHeight-20, 60, 25, "&Cancel");
   Fl_Input* inp = new Fl_Input(60, 30, 140, 30, "Text:");
 
+  // Define search option buttons
+  Fl_Button* regex_button = new Fl_Button( 215, 35, 20, 20, "regex");
+  regex_button->align( FL_ALIGN_RIGHT);
+  regex_button->type( FL_TOGGLE_BUTTON);
+  regex_button->selection_color( FL_BLUE);
+  regex_button->value( useRegex);
+  regex_button->tooltip( "treat text as a POSIX extended regular expression");
+#ifdef __WIN32__
+  regex_button->deactivate();
+#endif // __WIN32__
+  Fl_Button* case_button = new Fl_Button( 290, 35, 20, 20, "ignore case");
+  case_button->align( FL_ALIGN_RIGHT);
+  case_button->type( FL_TOGGLE_BUTTON);
+  case_button->selection_color( FL_BLUE);
+  case_button->value( ignoreCase);
+  case_button->tooltip( "match upper and lower case letters alike");
+
   Fl::focus(inp);
 
   // 'modal' to prevent events from being delivered to the other windows.
@@ -183,6 +205,8 @@ int make_find_window( const char* text, char *res)
     if(Fl::event_key(FL_Enter)) {
       find_window->hide();
       strcpy(res,inp->value());
+      useRegex = regex_button->value();
+      ignoreCase = case_button->value();
       return 1;    
     }
 
@@ -195,6 +219,8 @@ int make_find_window( const char* text, char *res)
       if( o == yes_button) {
         find_window->hide();
         strcpy(res,inp->value());
+        useRegex = regex_button->value();
+        ignoreCase = case_button->value();
         return 1;
       }
       else if( o == cancel_button) {
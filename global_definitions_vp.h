@@ -76,6 +76,10 @@ GLOBAL int nvars INIT(MAXVARS);    // number of columns in data file
 // use openGL vertex buffer objects (VBOs).  
 GLOBAL bool use_VBOs INIT(true);
 
+// Number of worker threads for parallel operations.  0 means use one per
+// processor.
+GLOBAL int nworker_threads INIT(0);
+
 // Define various operating mode flags
 GLOBAL bool expert_mode INIT(false);
 GLOBAL bool read_from_stdin INIT(false);
@@ -84,6 +88,8 @@ GLOBAL bool preserve_old_data_mode INIT(true);
 GLOBAL bool laptop_mode INIT(false);
 GLOBAL bool be_verbose INIT(false);
 GLOBAL bool update_on_mouse_up INIT(true);
+GLOBAL bool memory_map_mode INIT(true);
+GLOBAL bool cache_mode INIT(false);
 
 // Define blitz::Arrays to hold raw and ranked (sorted) data arrays.  Used 
 // extensively in many classes, so for reasons of simplicity and clarity, 
@@ -100,17 +106,17 @@ GLOBAL bool update_on_mouse_up INIT(true);
 // previously_selected -- index of the brush that previously selected the point
 // nselected -- number of points currently selected
 // saved_selection -- saves the old selection when "inverting", so we can go back.
-GLOBAL blitz::Array<int,1> inside_footprint;
-GLOBAL blitz::Array<int,1> newly_selected;
-GLOBAL blitz::Array<int,1> selected;
-GLOBAL blitz::Array<int,1> previously_selected;
-GLOBAL blitz::Array<int,1> saved_selection;
+// The true/false flags are packed one bit per point, and the brush indices
+// are stored one byte per point.
+#include "bit_mask.h"
+GLOBAL Bit_Mask inside_footprint;
+GLOBAL Bit_Mask newly_selected;
+GLOBAL blitz::Array<unsigned char,1> selected;
+GLOBAL blitz::Array<unsigned char,1> previously_selected;
+GLOBAL blitz::Array<unsigned char,1> saved_selection;
 GLOBAL int nselected;  
 GLOBAL bool selection_is_inverted INIT(false);
 
-// Temporary array (reference) for use with qsort
-GLOBAL blitz::Array<float,1> tmp_points;
-
 // Need to include class definitions for Column_Info so we can define a vector
 // of Column_Info objects to hold column labels and associated info.  This is
 // used extensively by the data_file_manager, comntrol_panel_window, and
@@ -208,37 +214,29 @@ GLOBAL gsl_rng *vp_gsl_rng;
 
 // Global function definitions
 GLOBAL int make_confirmation_window( const char* text, int nButtons = 3, int nLines = 2);
-GLOBAL int make_find_window( const char* text, char *res);
+GLOBAL int make_find_window(
+  const char* text, char *res, int &useRegex, int &ignoreCase);
 GLOBAL void shrink_widget_fonts( Fl_Widget* target_widget, float rScale);
 GLOBAL void reset_selection_arrays();
 
-//***************************************************************************
-// Class: MyCompare
-//
-// Class definitions:
-//   MyCompare -- Member class to maintain a comparison operator
-//
-// Classes referenced: none
-//
-// Purpose: Member class to maintain a comparison operator for use by 
-//   std::stable_sort
-//
-// Functions:
-//   comparison operator
-//
-// Author: Creon Levit     unknown
-// Modified: P. R. Gazis   25-MAR-2006
-//***************************************************************************
-class MyCompare
+float pow2(float x);
+
+// is_finite( x) -- Is X neither NaN nor infinite?  is_nan( x) -- Is X NaN?
+// Both test the bits of X, because -ffast-math lets the compiler assume
+// that no value is NaN or infinite and fold tests such as x != x away.
+inline int is_finite( float x)
 {
-public:
-  bool operator()( const int i, const int j) {  
-    return tmp_points(i) < tmp_points(j);
-    // return (tpoints[i]<tpoints[j]);
-  }
-};
+  unsigned int u;
+  memcpy( &u, &x, sizeof( u));
+  return ( u & 0x7F800000u) != 0x7F800000u;
+}
 
-float pow2(float x);
+inline int is_nan( float x)
+{
+  unsigned int u;
+  memcpy( &u, &x, sizeof( u));
+  return ( u & 0x7F800000u) == 0x7F800000u && ( u & 0x007FFFFFu) != 0;
+}
 
 #endif   // VP_GLOBAL_DEFINITIONS_VP_H
 
@@ -0,0 +1,176 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: histogram_kernel.cpp
+//
+// Class definitions:
+//   Histogram_Kernel -- Threaded binning of the points of one axis
+//
+// Classes referenced:
+//   Worker_Pool -- Pool of worker threads
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <histogram_kernel.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include associated headers and source code
+#include "histogram_kernel.h"
+#include "worker_pool.h"
+
+// Number of points whose bins are computed at a time
+static const int BLOCK_SIZE = 1024;
+
+//***************************************************************************
+// Histogram_Kernel::Histogram_Kernel() -- Default constructor describes no
+// points, one bin, and one set, with unit weights.
+Histogram_Kernel::Histogram_Kernel() : nbins_( 1), xmin_( 0.0), scale_( 1.0),
+  pEdges_( NULL), pValues_( NULL), stride_( 1), n_( 0), pWeights_( NULL),
+  weightStride_( 1), weight_( 1.0), pSets_( NULL), nSets_( 1), nTasks_( 0)
+{}
+
+//***************************************************************************
+// Histogram_Kernel::set_equi_width_bins( nbins, xmin, scale) -- Use NBINS
+// bins of width 1/SCALE starting at XMIN.
+void Histogram_Kernel::set_equi_width_bins( int nbins, float xmin, float scale)
+{
+  nbins_ = nbins;
+  xmin_ = xmin;
+  scale_ = scale;
+  pEdges_ = NULL;
+}
+
+//***************************************************************************
+// Histogram_Kernel::set_equi_depth_bins( nbins, pEdges) -- Use the NBINS
+// bins whose edges are PEDGES[ 0], ..., PEDGES[ nbins].
+void Histogram_Kernel::set_equi_depth_bins( int nbins, const float* pEdges)
+{
+  nbins_ = nbins;
+  pEdges_ = pEdges;
+}
+
+//***************************************************************************
+// Histogram_Kernel::set_points( pValues, stride, n) -- Bin the N values
+// PVALUES[ 0], PVALUES[ stride], ...
+void Histogram_Kernel::set_points( const float* pValues, int stride, int n)
+{
+  pValues_ = pValues;
+  stride_ = stride;
+  n_ = n;
+}
+
+//***************************************************************************
+// Histogram_Kernel::set_weights( pWeights, stride, weight) -- Weight point
+// i by PWEIGHTS[ i*stride], or, if PWEIGHTS is NULL, by WEIGHT.
+void Histogram_Kernel::set_weights(
+  const float* pWeights, int stride, float weight)
+{
+  pWeights_ = pWeights;
+  weightStride_ = stride;
+  weight_ = weight;
+}
+
+//***************************************************************************
+// Histogram_Kernel::set_sets( pSets, nSets) -- Count point i in set
+// PSETS[ i], which must be less than NSETS, or, if PSETS is NULL, in set 0.
+void Histogram_Kernel::set_sets( const unsigned char* pSets, int nSets)
+{
+  pSets_ = pSets;
+  nSets_ = nSets;
+}
+
+//***************************************************************************
+// Histogram_Kernel::run( nTasks, pCounts) -- Count the points of each set
+// in each bin, using NTASKS Worker_Pool tasks, and store the (weighted)
+// count of set s in bin b in PCOUNTS[ s*nbins + b].  If NTASKS is zero, as
+// many tasks are used as are worth it.
+void Histogram_Kernel::run( int nTasks, double* pCounts)
+{
+  int nCounts = nSets_ * nbins_;
+  for( int i=0; i<nCounts; i++) pCounts[ i] = 0.0;
+  if( n_ <= 0) return;
+
+  if( nTasks <= 0) nTasks = Worker_Pool::n_tasks_for( n_);
+  nTasks_ = nTasks;
+  taskCounts_.assign( (size_t) nTasks * nCounts, 0.0);
+  Worker_Pool::run_tasks( count_task, (void*) this, nTasks);
+
+  // Add up the private counts of the tasks
+  for( int iTask=0; iTask<nTasks; iTask++) {
+    const double* pTask = &taskCounts_[ (size_t) iTask * nCounts];
+    for( int i=0; i<nCounts; i++) pCounts[ i] += pTask[ i];
+  }
+  std::vector<double>().swap( taskCounts_);
+}
+
+//***************************************************************************
+// Histogram_Kernel::count_task( pUser, iTask) -- STATIC Worker_Pool task
+// for run() that counts slice ITASK of the points into the private counts
+// of the task.  PUSER points to the Histogram_Kernel.
+void Histogram_Kernel::count_task( void* pUser, int iTask)
+{
+  Histogram_Kernel* pKernel = (Histogram_Kernel*) pUser;
+  int nbins = pKernel->nbins_;
+  float xmin = pKernel->xmin_, scale = pKernel->scale_;
+  const float* pEdges = pKernel->pEdges_;
+  const float* pValues = pKernel->pValues_;
+  int stride = pKernel->stride_;
+  const float* pWeights = pKernel->pWeights_;
+  int weightStride = pKernel->weightStride_;
+  float weight = pKernel->weight_;
+  const unsigned char* pSets = pKernel->pSets_;
+  double* pCounts =
+    &pKernel->taskCounts_[ (size_t) iTask * pKernel->nSets_ * nbins];
+
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, pKernel->nTasks_, pKernel->n_, iBegin, iEnd);
+
+  // Loop: Find the bins of a block of points, then count them
+  int bins[ BLOCK_SIZE];
+  for( int iBlock=iBegin; iBlock<iEnd; iBlock+=BLOCK_SIZE) {
+    int n = min( BLOCK_SIZE, iEnd-iBlock);
+    if( pEdges) {
+      for( int i=0; i<n; i++) {
+        bins[ i] = equi_depth_bin(
+          pValues[ (size_t) ( iBlock+i) * stride], pEdges, nbins);
+      }
+    }
+    else if( stride == 1) {
+      const float* p = pValues + iBlock;
+      for( int i=0; i<n; i++) bins[ i] = equi_width_bin( p[ i], xmin, scale, nbins);
+    }
+    else {
+      for( int i=0; i<n; i++) {
+        bins[ i] = equi_width_bin(
+          pValues[ (size_t) ( iBlock+i) * stride], xmin, scale, nbins);
+      }
+    }
+
+    // Count the block
+    const unsigned char* pSet = pSets ? pSets + iBlock : NULL;
+    if( pWeights) {
+      const float* pWeight = pWeights + (size_t) iBlock * weightStride;
+      if( pSet) {
+        for( int i=0; i<n; i++)
+          pCounts[ pSet[ i]*nbins + bins[ i]] += pWeight[ i*weightStride];
+      }
+      else {
+        for( int i=0; i<n; i++) pCounts[ bins[ i]] += pWeight[ i*weightStride];
+      }
+    }
+    else {
+      if( pSet) {
+        for( int i=0; i<n; i++) pCounts[ pSet[ i]*nbins + bins[ i]] += weight;
+      }
+      else {
+        for( int i=0; i<n; i++) pCounts[ bins[ i]] += weight;
+      }
+    }
+  }
+}
@@ -0,0 +1,123 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: histogram_kernel.h
+//
+// Class definitions:
+//   Histogram_Kernel -- Threaded binning of the points of one axis
+//
+// Classes referenced:
+//   Worker_Pool -- Pool of worker threads
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Compute the histograms of all points and of the points of each
+//   brush for one axis in a single pass over the data.
+//
+// General design philosophy:
+//   1) The points are divided into contiguous slices, one per Worker_Pool
+//      task.  Each task sums into its own private bins, which are added
+//      together when all tasks are done, so no locking is needed.
+//   2) Each point is counted in the bin of its brush (or other set).  The
+//      marginal histogram is the sum of these over all sets, so it costs
+//      nothing extra.  Weights, if any, are applied in the same pass.
+//   3) Bin indices are computed a block at a time in a separate, branch-free
+//      loop over the values, which the compiler can vectorize, and then
+//      used to increment the counts.
+//   4) equi_width_bin() and equi_depth_bin() are the only definitions of
+//      the bins, and must be used by any code that has to agree with them.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef HISTOGRAM_KERNEL_H
+#define HISTOGRAM_KERNEL_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+//***************************************************************************
+// Class: Histogram_Kernel
+//
+// Class definitions:
+//   Histogram_Kernel -- Threaded binning of the points of one axis
+//
+// Classes referenced:
+//   Worker_Pool
+//
+// Purpose: Describe the bins, the points, their weights and sets, and then
+//   count them with run().
+//
+// Functions:
+//   Histogram_Kernel() -- Default constructor
+//   set_equi_width_bins( nbins, xmin, scale) -- Use bins of equal width
+//   set_equi_depth_bins( nbins, pEdges) -- Use bins with given edges
+//   set_points( pValues, stride, n) -- Values to be binned
+//   set_weights( pWeights, stride, weight) -- Weight of each point
+//   set_sets( pSets, nSets) -- Set (brush) of each point
+//   run( nTasks, pCounts) -- Count the points of each set in each bin
+//   equi_width_bin( x, xmin, scale, nbins) -- Bin of a value
+//   equi_depth_bin( x, pEdges, nbins) -- Bin of a value
+//   count_task( pUser, iTask) -- Count one slice of the points
+//***************************************************************************
+class Histogram_Kernel
+{
+  public:
+    Histogram_Kernel();
+    void set_equi_width_bins( int nbins, float xmin, float scale);
+    void set_equi_depth_bins( int nbins, const float* pEdges);
+    void set_points( const float* pValues, int stride, int n);
+    void set_weights( const float* pWeights, int stride, float weight);
+    void set_sets( const unsigned char* pSets, int nSets);
+    void run( int nTasks, double* pCounts);
+
+    // Bin of value X among NBINS bins of width 1/SCALE starting at XMIN.
+    // Values outside the bins go into the first or last bin, and NaN into
+    // the first.  NaN is found with is_nan(), since -ffast-math can fold 
+    // comparisons that would catch it, and (int) NaN is out of range.
+    static inline int equi_width_bin( float x, float xmin, float scale, int nbins)
+    {
+      float f = floorf( ( x - xmin) * scale);
+      if( is_nan( f)) return 0;
+      if( f < 0.0) f = 0.0;
+      if( f > nbins-1) f = nbins-1;
+      return (int) f;
+    }
+
+    // Bin of value X among NBINS bins whose edges are PEDGES[ 0], ...,
+    // PEDGES[ nbins].  Bin i holds the values in [pEdges[ i], pEdges[ i+1]).
+    // NaN goes into the first bin, as for equi_width_bin().
+    static inline int equi_depth_bin( float x, const float* pEdges, int nbins)
+    {
+      if( is_nan( x)) return 0;
+      return std::upper_bound( pEdges+1, pEdges+nbins, x) - (pEdges+1);
+    }
+
+  protected:
+    // Bins
+    int nbins_;
+    float xmin_, scale_;
+    const float* pEdges_;
+
+    // Points, weights, and sets
+    const float* pValues_;
+    int stride_, n_;
+    const float* pWeights_;
+    int weightStride_;
+    float weight_;
+    const unsigned char* pSets_;
+    int nSets_;
+
+    // Private counts of each task during run()
+    int nTasks_;
+    std::vector<double> taskCounts_;
+
+    static void count_task( void* pUser, int iTask);
+};
+
+#endif   // HISTOGRAM_KERNEL_H
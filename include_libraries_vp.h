@@ -74,14 +74,32 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <fcntl.h>
 #include <assert.h>
 #include <math.h>
+#include <ctype.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 
+// POSIX threads are used to parse, sort, and histogram data in parallel.
+// Under Windows this requires pthreads-win32.
+#include <pthread.h>
+
+// Memory-mapped file access is used to read binary files without copying
+// them.  This isn't available under Windows.
+#ifndef __WIN32__
+  #include <sys/mman.h>
+#endif // __WIN32__
+
+// POSIX regular expressions are used to search ASCII values.  These aren't
+// available under Windows, where only plain text searches are done.
+#ifndef __WIN32__
+  #include <regex.h>
+#endif // __WIN32__
+
 // For Windows, it is necessary to use the right version of getopt.h to obtain
 // access to getopt_long_only().
 // #include <getopt.h>
@@ -106,6 +124,7 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <deque>
 #include <map>
 #include <string>
 #include <algorithm>
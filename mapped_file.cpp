@@ -0,0 +1,95 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: mapped_file.cpp
+//
+// Class definitions:
+//   Mapped_File -- Memory-mapped file
+//
+// Classes referenced: none
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <mapped_file.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "mapped_file.h"
+
+//***************************************************************************
+// Mapped_File::Mapped_File( pData, length) -- Constructor.  The new object
+// has no references until someone attaches to it.
+Mapped_File::Mapped_File( char* pData, size_t length) :
+  pData_( pData), length_( length), nReferences_( 0)
+{}
+
+//***************************************************************************
+// Mapped_File::~Mapped_File() -- Destructor unmaps the file.
+Mapped_File::~Mapped_File()
+{
+#ifndef __WIN32__
+  if( pData_ != NULL) munmap( (void*) pData_, length_);
+#endif // __WIN32__
+  pData_ = NULL;
+  length_ = 0;
+}
+
+//***************************************************************************
+// Mapped_File::open( sFileSpec) -- Map an entire file into memory and
+// return a new Mapped_File object, or NULL if the file could not be mapped.
+// The mapping is private and writable, so stray writes through a view
+// produce private copies of the affected pages rather than a crash or a
+// change to the file.
+Mapped_File* Mapped_File::open( string sFileSpec)
+{
+#ifdef __WIN32__
+  return NULL;
+#else
+  int fd = ::open( sFileSpec.c_str(), O_RDONLY);
+  if( fd < 0) {
+    cerr << "Mapped_File::open: couldn't open <" << sFileSpec.c_str()
+         << ">" << endl;
+    return NULL;
+  }
+
+  // Get the length of the file.  Empty files can't be mapped.
+  struct stat file_stat;
+  if( fstat( fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+    close( fd);
+    return NULL;
+  }
+  size_t length = (size_t) file_stat.st_size;
+
+  // Map the file, then close the descriptor, which is no longer needed
+  void* pData =
+    mmap( NULL, length, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close( fd);
+  if( pData == MAP_FAILED) {
+    cerr << "Mapped_File::open: couldn't map <" << sFileSpec.c_str()
+         << ">: " << strerror( errno) << endl;
+    return NULL;
+  }
+
+  // Data are (mostly) read sequentially
+  madvise( pData, length, MADV_SEQUENTIAL);
+  return new Mapped_File( (char*) pData, length);
+#endif // __WIN32__
+}
+
+//***************************************************************************
+// Mapped_File::release() -- Remove a reference.  If this was the last one,
+// unmap the file and delete this object.
+void Mapped_File::release()
+{
+  nReferences_--;
+  if( nReferences_ <= 0) delete this;
+}
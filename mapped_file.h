@@ -0,0 +1,81 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: mapped_file.h
+//
+// Class definitions:
+//   Mapped_File -- Memory-mapped file
+//
+// Classes referenced: none
+//
+// Required packages: none
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Reference-counted, memory-mapped view of a data file.  Used by
+//   Data_File_Manager and Column_Info to expose columns of a binary file
+//   as blitz::Array views without copying them into memory.
+//
+// General design philosophy:
+//   1) Every Column_Info object whose points array is a view into the
+//      mapping holds one reference.  The file is unmapped when the last
+//      reference is released.
+//   2) The mapping is private, so nothing written through a view can ever
+//      reach the file on disk.
+//   3) Memory mapping is not available under Windows, so open() always
+//      fails there and the caller falls back to conventional reads.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+//***************************************************************************
+// Class: Mapped_File
+//
+// Class definitions:
+//   Mapped_File -- Memory-mapped file
+//
+// Classes referenced: none
+//
+// Purpose: Map a file into memory and keep track of how many objects are
+//   using it.
+//
+// Functions:
+//   open( sFileSpec) -- Map a file, return NULL if this fails
+//   attach() -- Add a reference
+//   release() -- Remove a reference, unmap file if this was the last one
+//   data() -- Get pointer to start of file
+//   length() -- Get length of file in bytes
+//   n_references() -- Get number of references
+//***************************************************************************
+class Mapped_File
+{
+  protected:
+    char* pData_;
+    size_t length_;
+    int nReferences_;
+
+    // Construction and destruction are handled by open() and release()
+    Mapped_File( char* pData, size_t length);
+    ~Mapped_File();
+
+  public:
+    static Mapped_File* open( string sFileSpec);
+    void attach() { nReferences_++;}
+    void release();
+
+    // Access functions
+    char* data() { return pData_;}
+    size_t length() { return length_;}
+    int n_references() { return nReferences_;}
+};
+
+#endif   // MAPPED_FILE_H
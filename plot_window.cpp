@@ -39,6 +39,10 @@
 #include "sprite_textures.h"
 #include "brush.h"
 #include "column_info.h"
+#include "rank_scheduler.h"
+#include "rank_engine.h"
+#include "worker_pool.h"
+#include "axis_cache.h"
 
 // experimental
 #define ALPHA_TEXTURE
@@ -65,8 +69,11 @@ float const Plot_Window::initial_pscale = 0.8;
 
 //GLfloat Plot_Window::texenvcolor[ 4] = { 1, 1, 1, 1};
 
-// 2D array that holds indices of vertices for each brush
-blitz::Array<unsigned int,2> Plot_Window::indices_selected(NBRUSHES,1); 
+// Indices of vertices sorted by brush, and the start of each brush's range
+blitz::Array<unsigned int,1> Plot_Window::indices_selected(1); 
+unsigned int Plot_Window::indices_start[ NBRUSHES];
+unsigned int Plot_Window::selection_generation = 0;
+unsigned int Plot_Window::indices_generation = 0;
 
 GLuint Plot_Window::spriteTextureID[NSYMBOLS];
 GLubyte* Plot_Window::spriteData[NSYMBOLS];
@@ -75,6 +82,10 @@ int Plot_Window::sprites_initialized = 0;
 void *Plot_Window::global_GLContext = NULL;
 int Plot_Window::indexVBOsinitialized = 0;
 int Plot_Window::indexVBOsfilled = 0;
+unsigned int Plot_Window::indices_changed_begin = 0;
+unsigned int Plot_Window::indices_changed_end = 0;
+GLuint Plot_Window::axis_program = 0;
+int Plot_Window::axis_program_initialized = 0;
 #define BUFFER_OFFSET(vbo_offset) ((char *)NULL + (vbo_offset))
 
 // Declarations for global methods defined and used by class Plot_Window.
@@ -98,7 +109,7 @@ double nicenum( const double xx, const double round);
 Plot_Window::Plot_Window() : Fl_Gl_Window( 10, 10),
   index( 0),
   x_save( 0), y_save( 0), w_save( 0), h_save( 0),
-  do_reset_view_with_show( 0)
+  densityTexture_( 0), do_reset_view_with_show( 0)
 {}
 
 //***************************************************************************
@@ -106,7 +117,7 @@ Plot_Window::Plot_Window() : Fl_Gl_Window( 10, 10),
 // windows, resize arrays, and set mode.  This constructor sets a flag to
 // tell the package to show the windows as part on a RESET_VIEW operation.
 Plot_Window::Plot_Window( int w, int h, int new_index) : 
-  Fl_Gl_Window( w, h), do_reset_view_with_show( 0)
+  Fl_Gl_Window( w, h), densityTexture_( 0), do_reset_view_with_show( 0)
 {
   // Set flag, update count, and invoke initialzation method
   count++;
@@ -122,12 +133,31 @@ void Plot_Window::initialize()
   do_reset_view_with_show = 0;
   show_center_glyph = 0;
   selection_changed = 0;
+  footprintValid_ = 0;
+  gridValid_ = 0;
+  histValid_[ 0] = histValid_[ 1] = 0;
+  histEquiDepth_[ 0] = histEquiDepth_[ 1] = 0;
+  autoBins_[ 0] = autoBins_[ 1] = 0;
+  densityValid_ = 0;
+  densityTextureValid_ = 0;
+
+  // Release the density texture made for earlier data, if any.  It can 
+  // only be deleted while the window's context is current.
+  if( densityTexture_ != 0 && shown()) {
+    make_current();
+    glDeleteTextures( 1, &densityTexture_);
+  }
+  densityTexture_ = 0;
 
   VBOinitialized = 0;
   VBOfilled = false;
+  for( int i=0; i<3; i++) axisBuffers_[ i] = 0;
 
-  // Resize arrays
-  vertices.resize( npoints, 3);
+  // Resize arrays.  Most plots are 2D, so start with (x,y) vertices, 
+  // which are only allocated if they are needed.
+  nComponents_ = 2;
+  verticesFilled = false;
+  nExtracted_ = 0;
   nbins[0] = nbins[1] = nbins[2] = nbins_default;
   counts.resize( nbins_max+2, 3);
   counts_selected.resize( nbins_max+2, 3);
@@ -159,6 +189,8 @@ void Plot_Window::initialize()
     exit (-1);
   }
     
+  // Set up the index VBOs and sprites again.  The shader for shared axes 
+  // doesn't depend on the data, so it is kept rather than rebuilt.
   indexVBOsinitialized=0;
   sprites_initialized=0;
 
@@ -203,9 +235,11 @@ void Plot_Window::load_state()
 }
 
 //***************************************************************************
-// Plot_Window::change_axes() -- Change axes for a plot to new axes which are 
-// (probably) not duplicates.
-void Plot_Window::change_axes( int nchange)
+// Plot_Window::change_axes( nchange, doExtract) -- Change axes for a plot to
+// new axes which are (probably) not duplicates.  If doExtract is zero, the 
+// data are not extracted, so the caller can extract the data for several 
+// plots at once with extract_all_data_points().
+void Plot_Window::change_axes( int nchange, int doExtract)
 {
   nchange = 0;
 
@@ -243,7 +277,7 @@ void Plot_Window::change_axes( int nchange)
   }
 
   // Extract, renormalize, and draw variables
-  cp->extract_and_redraw();
+  if( doExtract) cp->extract_and_redraw();
 }
 
 //***************************************************************************
@@ -309,6 +343,8 @@ int Plot_Window::handle( int event)
 {
   // Current plot window (button pushes, mouse drags, etc) must get redrawn 
   // before others so that selections get colored correctly.  Ugh.
+  // Only successive drag events can update the last footprint.
+  if( event != FL_DRAG) footprintValid_ = 0;
   switch( event) {
     active_plot = index;
 
@@ -362,7 +398,7 @@ int Plot_Window::handle( int event)
         current_brush =  dynamic_cast <Brush*> (brushes_tab->value());
         assert (current_brush);
 
-        newly_selected(blitz::Range(0,npoints-1)) = 0;
+        newly_selected.clear();
         // extend the selection under the following circumstances, otherwise replace.
         if (current_brush->add_to_selection->value() || // current_brush->paint->value() || ???
             current_brush != previous_brush ||
@@ -382,6 +418,9 @@ int Plot_Window::handle( int event)
 
         xtracked = xdown;
         ytracked = ydown;
+        lasso_.clear();
+        lasso_.push_back( xdown);
+        lasso_.push_back( ydown);
         selection_changed = 1;
         handle_selection ();
         redraw_all_plots (index);
@@ -441,6 +480,10 @@ int Plot_Window::handle( int event)
           ydown += ydragged*(1/yscale)*(2.0/h());
           xtracked += xdragged*(1/xscale)*(2.0/w());
           ytracked += ydragged*(1/yscale)*(2.0/h());
+          for( unsigned int k=0; k+1<lasso_.size(); k+=2) {
+            lasso_[ k] += xdragged*(1/xscale)*(2.0/w());
+            lasso_[ k+1] += ydragged*(1/yscale)*(2.0/h());
+          }
         }
 
         // no shift key => move corner of selection
@@ -452,6 +495,12 @@ int Plot_Window::handle( int event)
           ytracked = - (2.0*(ycur/(float)h()) -1.0) ; // window -> [-1,1]
           ytracked = ytracked/yscale;
           ytracked = ytracked + ycenter;
+
+          // the lasso follows the pointer
+          if( ( fabs(xdragged)+fabs(ydragged))>0) {
+            lasso_.push_back( xtracked);
+            lasso_.push_back( ytracked);
+          }
         }
         
         // printf ("FL_DRAG & FL_BUTTON1, event_state: %x  isdrag = %d  xdragged=%f  ydragged=%f\n", Fl::event_state(), isdrag, xdragged, ydragged);
@@ -557,9 +606,10 @@ int Plot_Window::handle( int event)
             label,
             "Search for a string in the %s-axis variable, '%s'",
             cAxis, Data_File_Manager::column_info[col].label.c_str());
-          make_find_window( label, buf);
+          static int useRegex = 0, ignoreCase = 0;
+          make_find_window( label, buf, useRegex, ignoreCase);
           if( buf[0]) {
-            select_on_string( buf, col);
+            select_on_string( buf, col, useRegex, ignoreCase);
           }
           return 1;
         }
@@ -755,14 +805,22 @@ void Plot_Window::draw()
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
   }
 
+  // Build the shader for shared axes, and delete shared VBOs that plots 
+  // have let go of since the last redraw.  Only windows that can't use 
+  // the shader need VBOs of their own.
+  if( !axis_program_initialized) initialize_axis_program();
+  Axis_Cache::delete_released_buffers();
   if( use_VBOs) {
-    if( !VBOinitialized) initialize_VBO();
-    if( !VBOfilled) fill_VBO();
+    if( axis_program == 0) {
+      if( !VBOinitialized) initialize_VBO();
+      if( !VBOfilled) fill_VBO();
+    }
     if( !indexVBOsinitialized) initialize_indexVBOs();
     if( !indexVBOsfilled) fill_indexVBOs();
   }
 
   draw_background ();
+  draw_density ();
   draw_data_points();
   if( selection_changed) {
     draw_selection_information();
@@ -1193,105 +1251,401 @@ void Plot_Window::print_selection_stats ()
 // calling draw_selection_information().
 void Plot_Window::handle_selection ()
 {
-  blitz::Range NPTS( 0, npoints-1);  
-
-  if (xdown==xtracked && ydown==ytracked) return;
+  if (nExtracted_ != npoints) return;
 
-  // Identify newly-selected points.
-  // XXX could be a bool array?  faster?
-  // XXX could use binary search on sorted values.  Much faster?
+  // Identify newly-selected points.  Selection works with the normalized
+  // axes shown in this plot.
   Brush  *current_brush = (Brush *)NULL;
   current_brush =  dynamic_cast <Brush*> (brushes_tab->value());
   assert (current_brush);
 
-  // switch (current_brush->footprint->value()) {
-
-  enum footprint {BRUSH_BOX, BRUSH_CIRCLE};
-  footprint xxx = BRUSH_BOX;
-  switch (xxx) {
-  case BRUSH_BOX:
-    inside_footprint(NPTS) =
-      where( ( vertices( NPTS, 0)>fmaxf( xdown, xtracked) || 
-               vertices( NPTS, 0)<fminf( xdown, xtracked) ||
-               vertices( NPTS, 1)>fmaxf( ydown, ytracked) || 
-               vertices( NPTS, 1)<fminf( ydown, ytracked)),
-             0, 1);
-    break;
-  case BRUSH_CIRCLE:
+  // A lasso needs at least three vertices, the other footprints need the
+  // pointer to have moved
+  int footprint = current_brush->footprint->value();
+  if (footprint == Brush::FOOTPRINT_LASSO) {
+    if (lasso_.size() < 6) return;
+  }
+  else if (xdown==xtracked && ydown==ytracked) return;
+
+  // Circles and lassos are found with the spatial grid, which is normally
+  // built when the data are extracted
+  if (footprint != Brush::FOOTPRINT_BOX && !gridValid_) build_grid();
+
+  switch (footprint) {
+  case Brush::FOOTPRINT_BOX:
+    {
+      float box_min[2] = { fminf( xdown, xtracked), fminf( ydown, ytracked)};
+      float box_max[2] = { fmaxf( xdown, xtracked), fmaxf( ydown, ytracked)};
+      Axis_Cache::sort_axis( axes_[0], x_rank);
+      Axis_Cache::sort_axis( axes_[1], y_rank);
+
+      // If this box is a moved version of the last one, with the same 
+      // brush, only the points between the two can change.  NOTE: Masking
+      // with a brush other than brush zero combines the new selection with
+      // the current one, so repeating it isn't idempotent and it is always
+      // done in full.
+      int brush_index = current_brush->index;
+      int paint = current_brush->paint->value();
+      int mask = mask_out_deselected->value();
+      if( footprintValid_ && footprintBrush_ == brush_index &&
+          footprintPaint_ == paint && footprintMask_ == mask &&
+          !( mask && brush_index > 0)) {
+        update_box_footprint( box_min, box_max);
+        return;
+      }
+
+      // Otherwise find the points whose x and y values are within the box
+      // by binary search of the sorted x- and y-axes, then test only the 
+      // points of the narrower slice against the other axis.
+      int iBegin[2], iEnd[2];
+      for( int k=0; k<2; k++) {
+        Axis_Cache::find_range( 
+          axes_[k], box_min[k], box_max[k], iBegin[k], iEnd[k]);
+      }
+      int k = ( iEnd[0]-iBegin[0] <= iEnd[1]-iBegin[1]) ? 0 : 1;
+      const blitz::Array<int,1> &order = axes_[k].order;
+      const blitz::Array<float,1> &other = axes_[1-k].values;
+      inside_footprint.clear();
+      for( int i=iBegin[k]; i<iEnd[k]; i++) {
+        int j = order(i);
+        if( other(j) >= box_min[1-k] && other(j) <= box_max[1-k]) {
+          inside_footprint.set( j, 1);
+        }
+      }
+      update_selection_from_footprint();
+
+      // Remember the footprint for the next drag event
+      footprintValid_ = 1;
+      footprintBrush_ = brush_index;
+      footprintPaint_ = paint;
+      footprintMask_ = mask;
+      for( int k=0; k<2; k++) {
+        footprintMin_[k] = box_min[k];
+        footprintMax_[k] = box_max[k];
+      }
+    }
+    return;
+  case Brush::FOOTPRINT_CIRCLE:
     {
       float xs = xscale*w(), ys=yscale*h();
       float dist2 = pow2((xtracked-xdown)*xs) + pow2((ytracked-ydown)*ys);
-      inside_footprint(NPTS) =
-        where( ( (pow2((vertices(NPTS,0)-xdown)*xs) + pow2((vertices(NPTS,1)-ydown)*ys)) > dist2),
-               0, 1);
+      inside_footprint.clear();
+      grid_.select_ellipse( 
+        xdown, ydown, xs, ys, dist2, axes_[0].values, axes_[1].values, 
+        inside_footprint);
     }
     break;
+  case Brush::FOOTPRINT_LASSO:
+    inside_footprint.clear();
+    grid_.select_polygon( 
+      &lasso_[0], lasso_.size()/2, axes_[0].values, axes_[1].values, 
+      inside_footprint);
+    break;
   default:
     assert(!"Impossible brush footprint");
   }
+  footprintValid_ = 0;
   update_selection_from_footprint();
 }
 
+//***************************************************************************
+// Plot_Window::build_grid() -- Build the spatial grid of the (x,y) points of
+// this plot.  Touches nothing but this plot's axes and grid, so it can run
+// on a worker thread.
+void Plot_Window::build_grid()
+{
+  if( axes_[0].values.rows() >= npoints && axes_[1].values.rows() >= npoints) {
+    grid_.build( axes_[0].values, axes_[1].values, npoints);
+  }
+  else grid_.free();
+  gridValid_ = 1;
+}
+
 //***************************************************************************
 // Plot_Window::update_selection_from_footprint() -- 
 void Plot_Window::update_selection_from_footprint()
 {
-  blitz::Range NPTS( 0, npoints-1);  
-
   Brush  *current_brush = (Brush *)NULL;
   current_brush =  dynamic_cast <Brush*> (brushes_tab->value());
   assert (current_brush);
 
   if (current_brush->paint->value()) {
-    newly_selected( NPTS) |= inside_footprint(NPTS);
+    newly_selected.or_with( inside_footprint);
   } else {
-    newly_selected( NPTS) = inside_footprint(NPTS);
+    newly_selected = inside_footprint;
   }
 
   // then tag them with the appropriate integer (index of current brush) so that later
   // they'll get sorted correctly and drawn with the correct color and texture.
+  // This is done 64 points at a time, using one word of the packed flags.
   Brush *bp = dynamic_cast <Brush*> (brushes_tab->value());
   assert (bp);
   int brush_index = bp->index; 
-  if (mask_out_deselected->value() && brush_index>0) {
-    // MCL this should be called "and with selection" or some such.
-    selected( NPTS) = where( newly_selected( NPTS) && selected(NPTS), brush_index, previously_selected( NPTS));
-  } 
-  else if (mask_out_deselected->value() && brush_index==0) {
-    // MCL XXX this is a bogus hack to implement an "inverse" brush that deselects everything outside of it,
-    // and leaves unchanged whatever is inside it.  Invoke using brush zero while "mask_out_deselected" is turned on.
-    selected( NPTS) = where( !newly_selected( NPTS), brush_index, previously_selected( NPTS));
-  } 
-  else {
-    selected( NPTS) = where( newly_selected( NPTS), brush_index, previously_selected( NPTS));
+  int mask = mask_out_deselected->value();
+  unsigned char* pSelected = selected.data();
+  const unsigned char* pPrevious = previously_selected.data();
+
+  // Points whose brush changes are collected so the cached histograms can 
+  // follow them, unless so many change that recomputing is as cheap
+  std::vector<unsigned int> removed[ NBRUSHES], added[ NBRUSHES];
+  int nChanged = 0, doPatch = 1;
+  unsigned char old_ids[ Bit_Mask::WORD_BITS];
+  int nWords = ( npoints + Bit_Mask::WORD_BITS-1) / Bit_Mask::WORD_BITS;
+  assert( nWords <= newly_selected.n_words());
+  for( int iWord=0; iWord<nWords; iWord++) {
+    int iFirst = iWord * Bit_Mask::WORD_BITS;
+    int nBits = min( (int) Bit_Mask::WORD_BITS, npoints-iFirst);
+    assert( nBits > 0);
+    if( doPatch) memcpy( old_ids, pSelected+iFirst, nBits);
+    Bit_Mask::Word word = newly_selected.word( iWord);
+    if (mask && brush_index>0) {
+      // MCL this should be called "and with selection" or some such.
+      word &= Bit_Mask::nonzero_word( pSelected+iFirst, nBits);
+    } 
+    else if (mask && brush_index==0) {
+      // MCL XXX this is a bogus hack to implement an "inverse" brush that deselects everything outside of it,
+      // and leaves unchanged whatever is inside it.  Invoke using brush zero while "mask_out_deselected" is turned on.
+      word = ~word;
+    } 
+    Bit_Mask::blend_ids( 
+      word, (unsigned char) brush_index, pPrevious+iFirst, pSelected+iFirst, nBits);
+    if( doPatch && memcmp( old_ids, pSelected+iFirst, nBits) != 0) {
+      for( int i=0; i<nBits; i++) {
+        if( old_ids[ i] == pSelected[ iFirst+i]) continue;
+        removed[ old_ids[ i]].push_back( iFirst+i);
+        added[ pSelected[ iFirst+i]].push_back( iFirst+i);
+        nChanged++;
+      }
+      if( nChanged > npoints/8) doPatch = 0;
+    }
   }
   
-  // pack (gather) the new index arrays for later rendering
+  // pack (gather) the new index arrays for later rendering, then bring the
+  // histograms that were current up to date
+  unsigned int generation = selection_generation;
   color_array_from_selection ();
+  if( doPatch) patch_histograms( removed, added, generation);
 }
 
 //***************************************************************************
-// Plot_Window::color_array_from_selection() -- Fill the index arrays and 
-// their associated counts.  Each array of indices will be rendered later 
-// using the properties of its corresponding brush.
-void Plot_Window::color_array_from_selection()
+// Plot_Window::update_box_footprint( box_min, box_max) -- Update the 
+// footprint, the selection, and the index arrays after the selection box 
+// moved from the last footprint to [box_min, box_max], with the same brush 
+// settings.  Only points in the strips between the old and new edges of 
+// the box can enter or leave it, so only they are examined, using the 
+// sorted axes, and only points whose brush changes are moved between the
+// index arrays.  Gives the same result as update_selection_from_footprint().
+void Plot_Window::update_box_footprint( 
+  const float box_min[2], const float box_max[2])
 {
-  // Loop: initialize brush counts to zero
-  for( int i=0; i<NBRUSHES; i++) {
-    brushes[i]->count = 0;
+  int brush_index = footprintBrush_;
+  std::vector<unsigned int> removed[ NBRUSHES], added[ NBRUSHES];
+  int nChanged = 0;
+
+  // Loop: Examine the strips between the old and new lower and upper edges
+  // of the box on each axis
+  for( int k=0; k<2; k++) {
+    float edges[2][2] = {
+      { footprintMin_[k], box_min[k]}, { footprintMax_[k], box_max[k]}};
+    for( int m=0; m<2; m++) {
+      if( edges[m][0] == edges[m][1]) continue;
+      int iBegin, iEnd;
+      Axis_Cache::find_range( 
+        axes_[k], fminf( edges[m][0], edges[m][1]), 
+        fmaxf( edges[m][0], edges[m][1]), iBegin, iEnd);
+      const blitz::Array<int,1> &order = axes_[k].order;
+      for( int i=iBegin; i<iEnd; i++) {
+        int j = order(i);
+        float x = axes_[0].values(j), y = axes_[1].values(j);
+        int inside = 
+          x >= box_min[0] && x <= box_max[0] && 
+          y >= box_min[1] && y <= box_max[1];
+        if( inside == inside_footprint.get( j)) continue;
+        inside_footprint.set( j, inside);
+
+        // Apply the rules of update_selection_from_footprint() to this point
+        int newly = footprintPaint_ ? (newly_selected.get( j) | inside) : inside;
+        newly_selected.set( j, newly);
+        int set;
+        if( footprintMask_ && brush_index == 0) {
+          set = ( !newly) ? brush_index : previously_selected(j);
+        }
+        else {
+          set = newly ? brush_index : previously_selected(j);
+        }
+        if( set == selected(j)) continue;
+        removed[ selected(j)].push_back( j);
+        added[ set].push_back( j);
+        selected(j) = set;
+        nChanged++;
+      }
+    }
+  }
+  for( int k=0; k<2; k++) {
+    footprintMin_[k] = box_min[k];
+    footprintMax_[k] = box_max[k];
   }
+  if( nChanged == 0) return;
 
-  // Loop: Examine successive points to fill the index arrays and their
-  // associated counts
-  int set, count=0;
-  for( int i=0; i<npoints; i++) {
-    set = selected(i);
-    count = brushes[set]->count++;
-    indices_selected( set, count) = i;
+  // Patch the ranges of the brushes that gained or lost points, and the 
+  // histograms
+  patch_indices_selected( removed, added);
+  nselected = npoints - brushes[0]->count;
+  patch_histograms( removed, added, selection_generation);
+}
+
+//***************************************************************************
+// Plot_Window::patch_indices_selected( removed, added) -- STATIC method to 
+// remove the points REMOVED[ set] from, and add the points ADDED[ set] to,
+// the range of each brush in the index array, keeping each range in 
+// ascending order as color_array_from_selection() does, so line strips 
+// still connect points in order.  Every point removed from one brush must
+// be added to another, so only the part of the array from the first change
+// to the end of the last brush that changes is moved, and only that part
+// is marked for upload to the index VBO.
+void Plot_Window::patch_indices_selected( 
+  std::vector<unsigned int> removed[], std::vector<unsigned int> added[])
+{
+  unsigned int* pIndices = indices_selected.data();
+
+  // Find the first and last brushes that change, and the first change in 
+  // the range of the first one
+  int first_set = -1, last_set = -1;
+  for( int set=0; set<NBRUSHES; set++) {
+    std::sort( removed[ set].begin(), removed[ set].end());
+    std::sort( added[ set].begin(), added[ set].end());
+    if( !removed[ set].empty() || !added[ set].empty()) {
+      if( first_set < 0) first_set = set;
+      last_set = set;
+    }
+  }
+  if( first_set < 0) return;
+  unsigned int first = 0;
+  if( !removed[ first_set].empty()) first = removed[ first_set][ 0];
+  if( !added[ first_set].empty() && 
+      ( removed[ first_set].empty() || added[ first_set][ 0] < first)) {
+    first = added[ first_set][ 0];
   }
+  unsigned int* pBegin = pIndices + indices_start[ first_set];
+  unsigned int iFirst = 
+    std::lower_bound( pBegin, pBegin + brushes[ first_set]->count, first) - 
+    pIndices;
+
+  // Save the part of the array that changes, then loop: merge the saved 
+  // indices of successive brushes, less the removed ones, with the added 
+  // ones
+  unsigned int iLast = indices_start[ last_set] + brushes[ last_set]->count;
+  std::vector<unsigned int> tail( pIndices + iFirst, pIndices + iLast);
+  unsigned int iTail = 0, iOut = iFirst;
+  for( int set=first_set; set<=last_set; set++) {
+    unsigned int iBegin = iOut;
+    if( set == first_set) iBegin = indices_start[ set];
+    unsigned int iEnd = 
+      indices_start[ set] + brushes[ set]->count - iFirst;
+    unsigned int iRemoved = 0, iAdded = 0;
+    for( ; iTail < iEnd; iTail++) {
+      while( iAdded < added[ set].size() && added[ set][ iAdded] < tail[ iTail]) {
+        pIndices[ iOut++] = added[ set][ iAdded++];
+      }
+      if( iRemoved < removed[ set].size() && 
+          removed[ set][ iRemoved] == tail[ iTail]) {
+        iRemoved++;
+        continue;
+      }
+      pIndices[ iOut++] = tail[ iTail];
+    }
+    while( iAdded < added[ set].size()) {
+      pIndices[ iOut++] = added[ set][ iAdded++];
+    }
+    indices_start[ set] = iBegin;
+    brushes[ set]->count = iOut - iBegin;
+  }
+  assert( iOut == iLast);
+  mark_indices_changed( iFirst, iLast);
+}
+
+//***************************************************************************
+// Brush_Sort -- Work shared by the Worker_Pool tasks of 
+// color_array_from_selection().  Each task handles one contiguous slice of
+// the points, so counts(iTask,set) is the number of points of brush SET in
+// slice ITASK, and is then replaced by the position of its first index.
+struct Brush_Sort {
+  const unsigned char* pSelected;
+  unsigned int* pIndices;
+  int nTasks;
+  std::vector<unsigned int> counts;
+};
+
+//***************************************************************************
+// Plot_Window::color_array_from_selection() -- Fill the index array and 
+// the associated counts and offsets by a two-pass counting sort of the 
+// points by brush, with slices of the points counted and then scattered on
+// the Worker_Pool.  Each range of indices will be rendered later using the
+// properties of its corresponding brush.
+void Plot_Window::color_array_from_selection()
+{
+  Brush_Sort sort;
+  sort.pSelected = selected.data();
+  sort.pIndices = indices_selected.data();
+  sort.nTasks = Worker_Pool::n_tasks_for( npoints);
+  sort.counts.assign( sort.nTasks*NBRUSHES, 0);
+  Worker_Pool::run_tasks( count_brushes_task, (void*) &sort, sort.nTasks);
+
+  // Loop: Turn the counts into the starting position of each brush and
+  // of each slice within the range of each brush
+  unsigned int position = 0;
+  for( int set=0; set<NBRUSHES; set++) {
+    indices_start[ set] = position;
+    for( int iTask=0; iTask<sort.nTasks; iTask++) {
+      unsigned int count = sort.counts[ iTask*NBRUSHES + set];
+      sort.counts[ iTask*NBRUSHES + set] = position;
+      position += count;
+    }
+    brushes[set]->count = position - indices_start[ set];
+  }
+  Worker_Pool::run_tasks( scatter_brushes_task, (void*) &sort, sort.nTasks);
   nselected = npoints - brushes[0]->count;
   // assert(sum(number_selected(blitz::Range(0,nplots))) == (unsigned int)npoints);
-  indexVBOsfilled = 0;
+  mark_indices_changed( 0, npoints);
+  selection_generation++;
+  indices_generation = selection_generation;
+}
+
+//***************************************************************************
+// Plot_Window::count_brushes_task( pUser, iTask) -- STATIC Worker_Pool task
+// for color_array_from_selection() that counts the points of each brush in
+// slice ITASK.
+void Plot_Window::count_brushes_task( void* pUser, int iTask)
+{
+  Brush_Sort* pSort = (Brush_Sort*) pUser;
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, pSort->nTasks, npoints, iBegin, iEnd);
+  unsigned int counts[ NBRUSHES];
+  for( int set=0; set<NBRUSHES; set++) counts[ set] = 0;
+  const unsigned char* pSelected = pSort->pSelected;
+  for( int i=iBegin; i<iEnd; i++) counts[ pSelected[ i]]++;
+  for( int set=0; set<NBRUSHES; set++) {
+    pSort->counts[ iTask*NBRUSHES + set] = counts[ set];
+  }
+}
+
+//***************************************************************************
+// Plot_Window::scatter_brushes_task( pUser, iTask) -- STATIC Worker_Pool 
+// task for color_array_from_selection() that stores the indices of the 
+// points in slice ITASK at the positions found from the counts.  Slices are
+// in order, so the indices of each brush remain in ascending order.
+void Plot_Window::scatter_brushes_task( void* pUser, int iTask)
+{
+  Brush_Sort* pSort = (Brush_Sort*) pUser;
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, pSort->nTasks, npoints, iBegin, iEnd);
+  unsigned int positions[ NBRUSHES];
+  for( int set=0; set<NBRUSHES; set++) {
+    positions[ set] = pSort->counts[ iTask*NBRUSHES + set];
+  }
+  const unsigned char* pSelected = pSort->pSelected;
+  unsigned int* pIndices = pSort->pIndices;
+  for( int i=iBegin; i<iEnd; i++) pIndices[ positions[ pSelected[ i]]++] = i;
 }
 
 //***************************************************************************
@@ -1306,10 +1660,29 @@ void Plot_Window::draw_selection_information()
     glColor4f( 0.25,0.25,0.75,0.0);
     glBegin( GL_LINE_LOOP);
 
-    glVertex2f( xdown, ydown);
-    glVertex2f( xtracked, ydown);
-    glVertex2f( xtracked, ytracked);
-    glVertex2f( xdown, ytracked);
+    // Outline the footprint of the current brush
+    Brush *current_brush = dynamic_cast <Brush*> (brushes_tab->value());
+    int footprint = Brush::FOOTPRINT_BOX;
+    if( current_brush) footprint = current_brush->footprint->value();
+    if( footprint == Brush::FOOTPRINT_CIRCLE) {
+      float xs = xscale*w(), ys=yscale*h();
+      float r = sqrt( pow2((xtracked-xdown)*xs) + pow2((ytracked-ydown)*ys));
+      for( int i=0; i<64; i++) {
+        float theta = i * 2.0 * M_PI / 64;
+        glVertex2f( xdown + r*cos(theta)/xs, ydown + r*sin(theta)/ys);
+      }
+    }
+    else if( footprint == Brush::FOOTPRINT_LASSO) {
+      for( unsigned int k=0; k+1<lasso_.size(); k+=2) {
+        glVertex2f( lasso_[ k], lasso_[ k+1]);
+      }
+    }
+    else {
+      glVertex2f( xdown, ydown);
+      glVertex2f( xtracked, ydown);
+      glVertex2f( xtracked, ytracked);
+      glVertex2f( xdown, ytracked);
+    }
 
     glEnd();
   }
@@ -1346,7 +1719,10 @@ void Plot_Window::draw_data_points()
   }
 
   // Tell the GPU where to find the vertices for this plot.
-  if (use_VBOs) {
+  if (axis_program != 0) {
+    bind_axes();
+  }
+  else if (use_VBOs) {
     // bind VBO for vertex data
     glBindBuffer(GL_ARRAY_BUFFER, index+1);
 
@@ -1355,10 +1731,11 @@ void Plot_Window::draw_data_points()
     // here, where the correct window and context are active.
     if (!VBOfilled) fill_VBO();
 
-    glVertexPointer (3, GL_FLOAT, 0, BUFFER_OFFSET(0));
+    glVertexPointer (nComponents_, GL_FLOAT, 0, BUFFER_OFFSET(0));
   }
   else {
-    glVertexPointer (3, GL_FLOAT, 0, (GLfloat *)vertices.data()); 
+    if (!verticesFilled) fill_vertices();
+    glVertexPointer (nComponents_, GL_FLOAT, 0, (GLfloat *)vertices.data()); 
   }
 
   // set the blending mode for this plot
@@ -1476,16 +1853,14 @@ void Plot_Window::draw_data_points()
 
       // then render the points
       if (use_VBOs) {
-        assert (VBOinitialized && VBOfilled && indexVBOsinitialized && indexVBOsfilled) ;
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, MAXPLOTS+1+brush_index); 
-        glDrawElements( element_mode, (GLsizei)count, GL_UNSIGNED_INT, BUFFER_OFFSET(0)); // would it bee faster to use glDrawRangeElements() ?
+        assert ((axis_program != 0 || (VBOinitialized && VBOfilled)) && indexVBOsinitialized && indexVBOsfilled) ;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, MAXPLOTS+1); 
+        glDrawElements( element_mode, (GLsizei)count, GL_UNSIGNED_INT, BUFFER_OFFSET(indices_start[brush_index]*sizeof(GLuint))); // would it bee faster to use glDrawRangeElements() ?
         // make sure we succeeded 
         CHECK_GL_ERROR("drawing points from VBO");
       }
       else {
-        // Create an alias to slice
-        blitz::Array<unsigned int, 1> tmpArray = indices_selected(brush_index, blitz::Range(0,npoints-1));
-        unsigned int *indices = (unsigned int *) (tmpArray.data());
+        unsigned int *indices = indices_selected.data() + indices_start[brush_index];
         glDrawRangeElements( element_mode, 0, npoints, count, GL_UNSIGNED_INT, indices);
       }
     }
@@ -1501,6 +1876,9 @@ void Plot_Window::draw_data_points()
   if (current_sprite > 0) {
     disable_sprites();
   }
+  if (axis_program != 0) {
+    unbind_axes();
+  }
   glLineWidth(1);
 
 #ifdef ALPHA_TEXTURE
@@ -1510,66 +1888,384 @@ void Plot_Window::draw_data_points()
 
 //***************************************************************************
 // Plot_Window::compute_histogram( axis) -- If requested, compute equi-width 
-// histogram for axis 'axis'.
+// or equi-depth histogram for axis 'axis'.
 //
-// MCL XXX this should be split into two routines, one for computing the 
-// histogram for all the points, the other for selected points, and _neither_ 
-// of them needs to be called as often as they are.  The first only needs to 
-// be called in extract_and_redraw(), and the second only when the selection 
-// changes (but it must be called for all plots in that case), or when {x,y}bins 
-// changes (in that case, only for one plot).  The way it is, a lot of extra 
-// time is burned here if any histograms are being shown.
+// The histograms of all points and of the points of each brush are cached.
+// They are only computed again when the axis is extracted or transformed,
+// or when the bin count, style, weighting, or selection generation 
+// changes.  Brush strokes patch the cached counts of the points whose 
+// selection changed (see patch_histograms()), so redrawing every plot after
+// a stroke costs O(nbins) per plot.  Unweighted histograms are computed 
+// from the sorted order of the axis and the index array, without looking 
+// at the unselected points (see rebuild_histogram()), so dragging the bin 
+// count slider stays fast for large data sets.
 // Note - we could experiment with openGL histograms...but they seem to suck.
 //
-// MCL XXX also note that if we want to get rid of the vertices() instance 
-// variable to save memory, which should be doable since vertices are copied 
-// into VBOs, then we will have to do something else here.
+// Histograms are computed from the normalized axes of the plot, since 
+// there is no other CPU-side copy of its vertices.
 void Plot_Window::compute_histogram( int axis)
+{
+  int nbins, brush_index, weighted, equi_depth;
+  if( histogram_settings( 
+        axis, nbins, brush_index, weighted, equi_depth) == 0) return;
+  fill_histogram( axis, nbins, brush_index, weighted, equi_depth);
+}
+
+//***************************************************************************
+// Plot_Window::histogram_settings( axis, nbins, brush_index, weighted, 
+// equi_depth) -- Get the number of bins, the index of the most recent 
+// brush, and the weighting and equi-depth flags for the histogram of axis 
+// 'axis' from the control panel and the brushes tab, and make sure the 
+// sorted order of the axis is known.  Returns 0 if no histogram is to be 
+// computed.  Must be called from the main (FLTK) thread.
+int Plot_Window::histogram_settings( 
+  int axis, int &nbins, int &brush_index, int &weighted, int &equi_depth)
 {
   int marginal    = cp->show_histogram[axis]->menu()[Control_Panel_Window::HISTOGRAM_MARGINAL].value();
   int selection   = cp->show_histogram[axis]->menu()[Control_Panel_Window::HISTOGRAM_SELECTION].value();
   int conditional = cp->show_histogram[axis]->menu()[Control_Panel_Window::HISTOGRAM_CONDITIONAL].value();
   // MCL XXX presently, weighting is based on the z-axis variable.  Weighting variable should really be a pulldown of is own.
-  int weighted    = cp->show_histogram[axis]->menu()[Control_Panel_Window::HISTOGRAM_WEIGHTED].value();
+  weighted        = cp->show_histogram[axis]->menu()[Control_Panel_Window::HISTOGRAM_WEIGHTED].value();
+  equi_depth      = cp->show_histogram[axis]->menu()[Control_Panel_Window::HISTOGRAM_EQUI_DEPTH].value();
   if (!(marginal || selection || conditional)) {
-    return;
+    return 0;
   }
 
-  // Get number of bins, initialize arrays, and set range
-  int nbins = (int) (exp2(cp->nbins_slider[axis]->value()));
-  if( nbins <= 0) return;
-  blitz::Range BINS( 0, nbins-1);
-  counts( BINS, axis) = 0.0;
-
-  counts_selected( BINS, axis) = 0.0;
-  // range is tweaked by (n+1)/n to get the "last" point into the correct bin.
-  float range = (amax[axis] - amin[axis]) * ((float)(npoints+1)/(float)npoints); 
+  // Get number of bins, which also sorts the axis if it is to be chosen 
+  // automatically
+  nbins = histogram_nbins( axis);
+  if( nbins <= 0) return 0;
 
   // only count points that are being selected by the most recent brush
   Brush *bp = dynamic_cast <Brush*> (brushes_tab->value());
   assert (bp);
-  int brush_index = bp->index; 
+  brush_index = bp->index; 
 
-  // Loop: sum over successive points to load histogram arrays
-  for( int i=0; i<npoints; i++) {
-    float x = vertices( i, axis);
-    // MCL XXX presently, weighting is based on the z-axis variable.  Weighting variable should really be a pulldown of is own.
-    float weight = weighted?vertices(i,2):1.0;
-    int bin = (int)(floorf( nbins * ( ( x - amin[axis]) / range)));
-    if( bin < 0) bin = 0;
-    if( bin > nbins-1) bin = nbins-1;
-    counts( bin, axis) += weight;
-    if( selected( i) == brush_index) counts_selected( bin, axis)+=weight;
-  }
-  float maxcount = max(max(counts(BINS,axis)), 1.0f);
-  
-  // Normalize results.  
+  // Sorting is done once per normalized axis and shared through the 
+  // Axis_Cache
+  if( axes_[ axis].values.rows() >= npoints) {
+    Axis_Cache::sort_axis( axes_[ axis], axis == 0 ? x_rank : y_rank);
+  }
+  return 1;
+}
+
+//***************************************************************************
+// Plot_Window::histogram_nbins( axis) -- Get the number of bins for the 
+// histogram of axis 'axis': either 2^(value of the bin count slider), or, 
+// if one of the auto bins styles is checked, the number chosen by Knuth's 
+// rule or the Freedman-Diaconis rule from the sorted order of the axis.  
+// The automatic choice is kept until the axis or its range changes.  Must 
+// be called from the main (FLTK) thread.
+int Plot_Window::histogram_nbins( int axis)
+{
+  int nbins = (int) (exp2(cp->nbins_slider[axis]->value()));
+  int method = Auto_Binning::NONE;
+  if( cp->show_histogram[axis]->menu()[Control_Panel_Window::HISTOGRAM_AUTO_KNUTH].value()) {
+    method = Auto_Binning::KNUTH;
+  }
+  else if( cp->show_histogram[axis]->menu()[Control_Panel_Window::HISTOGRAM_AUTO_FREEDMAN_DIACONIS].value()) {
+    method = Auto_Binning::FREEDMAN_DIACONIS;
+  }
+  if( method == Auto_Binning::NONE || npoints <= 0 || 
+      axes_[ axis].values.rows() < npoints) {
+    return nbins;
+  }
+
+  // Reuse the last choice if nothing has changed
+  if( autoBins_[ axis] > 0 && autoBinsMethod_[ axis] == method && 
+      autoBinsNpoints_[ axis] == npoints && 
+      autoBinsMin_[ axis] == amin[ axis] && autoBinsMax_[ axis] == amax[ axis]) {
+    return autoBins_[ axis];
+  }
+
+  // Choose the bin count for the same bins as rebuild_histogram() uses, 
+  // with the range tweaked by (n+1)/n.
+  Axis_Cache::sort_axis( axes_[ axis], axis == 0 ? x_rank : y_rank);
+  float range = (amax[axis] - amin[axis]) * ((float)(npoints+1)/(float)npoints); 
+  int autoBins = Auto_Binning::optimal_bins( 
+    method, axes_[ axis].values, axes_[ axis].order, npoints, amin[ axis], 
+    range, 2, nbins_max);
+  if( autoBins <= 0) return nbins;
+  autoBins_[ axis] = autoBins;
+  autoBinsMethod_[ axis] = method;
+  autoBinsNpoints_[ axis] = npoints;
+  autoBinsMin_[ axis] = amin[ axis];
+  autoBinsMax_[ axis] = amax[ axis];
+  return autoBins;
+}
+
+//***************************************************************************
+// Plot_Window::fill_histogram( axis, nbins, brush_index, weighted, 
+// equi_depth) -- Compute histograms of all points and of the points 
+// selected by brush BRUSH_INDEX for axis 'axis' from the cached counts, 
+// recomputing these first if they are out of date.  The bars of equi-depth
+// histograms are as high as the number of points per unit length, so 
+// their areas are proportional to the counts.  Touches no widgets, so the 
+// histograms of different plots can be computed at the same time on 
+// different threads.  NTASKS is handed to rebuild_histogram().
+void Plot_Window::fill_histogram( 
+  int axis, int nbins, int brush_index, int weighted, int equi_depth, 
+  int nTasks)
+{
+  if( !histogram_is_current( axis, nbins, weighted, equi_depth)) {
+    rebuild_histogram( axis, nbins, weighted, equi_depth, nTasks);
+  }
+
+  // Copy the counts, scaled by the widths of the bins for equi-depth 
+  // histograms, and normalize them
+  const double* pMarginal = &marginalCounts_[ axis][ 0];
+  const double* pSelected = &brushCounts_[ axis][ brush_index*nbins];
+  const float* pEdges = NULL;
+  if( histEquiDepth_[ axis]) pEdges = &histEdges_[ axis][ 0];
+  float maxcount = pEdges ? 0.0 : 1.0;
+  for( int bin=0; bin<nbins; bin++) {
+    double scale = 1.0;
+    if( pEdges) {
+      float width = pEdges[ bin+1] - pEdges[ bin];
+      scale = width > 0.0 ? 1.0 / width : 0.0;
+    }
+    counts( bin, axis) = (float) ( scale * pMarginal[ bin]);
+    counts_selected( bin, axis) = (float) ( scale * pSelected[ bin]);
+    if( counts( bin, axis) > maxcount) maxcount = counts( bin, axis);
+  }
+  if( maxcount <= 0.0) maxcount = 1.0;
+  blitz::Range BINS( 0, nbins-1);
   if( npoints > 0) {
     counts(BINS,axis) = counts(BINS,axis) / (float)maxcount;
     counts_selected(BINS,axis) = counts_selected(BINS,axis) / (float)maxcount;
   }
 }
 
+//***************************************************************************
+// Plot_Window::histogram_is_current( axis, nbins, weighted, equi_depth) -- 
+// Are the cached counts of axis 'axis' valid for these settings, the 
+// current range of the axis, and the current selection?
+int Plot_Window::histogram_is_current( 
+  int axis, int nbins, int weighted, int equi_depth) const
+{
+  return 
+    histValid_[ axis] && histNbins_[ axis] == nbins && 
+    histWeighted_[ axis] == weighted && histEquiDepth_[ axis] == equi_depth &&
+    histNpoints_[ axis] == npoints &&
+    histMin_[ axis] == amin[ axis] && histMax_[ axis] == amax[ axis] &&
+    histSelection_[ axis] == selection_generation;
+}
+
+//***************************************************************************
+// Plot_Window::rebuild_histogram( axis, nbins, weighted, equi_depth, 
+// nTasks) -- Recompute the cached counts of all points and of the
+// points of each brush for axis 'axis'.  If the sorted order of the axis is
+// known, equi-depth bins are placed at its quantiles, and, for unweighted 
+// histograms, the marginal counts are found by binary search and the 
+// counts of brushes other than brush 0 from the points of their ranges of
+// the index array, so only the selected points are looked at.  Otherwise
+// all points are counted by the Histogram_Kernel with NTASKS tasks (zero 
+// for as many as are worth it).
+void Plot_Window::rebuild_histogram( 
+  int axis, int nbins, int weighted, int equi_depth, int nTasks)
+{
+  histValid_[ axis] = 1;
+  histNbins_[ axis] = nbins;
+  histWeighted_[ axis] = weighted;
+  histEquiDepth_[ axis] = equi_depth;
+  histNpoints_[ axis] = npoints;
+  histMin_[ axis] = amin[ axis];
+  histMax_[ axis] = amax[ axis];
+  histSelection_[ axis] = selection_generation;
+
+  // range is tweaked by (n+1)/n to get the "last" point into the correct bin.
+  float range = (amax[axis] - amin[axis]) * ((float)(npoints+1)/(float)npoints); 
+  histScale_[ axis] = nbins / range;
+
+  marginalCounts_[ axis].assign( nbins, 0.0);
+  brushCounts_[ axis].assign( NBRUSHES*nbins, 0.0);
+  histEdges_[ axis].assign( nbins+1, 0.0);
+
+  // Get the normalized axes.  NOTE: These are references, since blitz 
+  // reference counts must not be touched on worker threads.
+  const blitz::Array<float,1> &values = axes_[ axis].values;
+  const blitz::Array<float,1> &zValues = axes_[ 2].values;
+  const blitz::Array<int,1> &order = axes_[ axis].order;
+  if( npoints <= 0 || values.rows() < npoints) return;
+  int hasZ = ( zValues.rows() >= npoints);
+  int isSorted = ( order.rows() == npoints);
+
+  // Place equi-depth bin edges at the quantiles of the sorted finite 
+  // values.  Without the sorted order, or without finite values, fall back 
+  // to equi-width bins.
+  if( equi_depth && !isSorted) histEquiDepth_[ axis] = 0;
+  int iBegin = 0, iEnd = 0;
+  if( histEquiDepth_[ axis]) {
+    Rank_Engine::finite_range( 
+      values.data(), values.stride( 0), order.data(), npoints, iBegin, iEnd);
+    if( iEnd <= iBegin) histEquiDepth_[ axis] = 0;
+  }
+  float* pEdges = &histEdges_[ axis][ 0];
+  if( histEquiDepth_[ axis]) {
+    int nFinite = iEnd - iBegin;
+    for( int bin=0; bin<nbins; bin++) {
+      pEdges[ bin] = 
+        values( order( iBegin + (int) ( ( (long long) bin*nFinite) / nbins)));
+    }
+    pEdges[ nbins] = values( order( iEnd-1));
+  }
+  else {
+    for( int bin=0; bin<=nbins; bin++) {
+      pEdges[ bin] = amin[ axis] + bin * ( amax[ axis] - amin[ axis]) / nbins;
+    }
+  }
+
+  double* pMarginal = &marginalCounts_[ axis][ 0];
+  double* pBrushes = &brushCounts_[ axis][ 0];
+
+  // Without weights, use the sorted order and the index array, if it is 
+  // sorted for this selection.  Points of brush 0 are whatever is left.
+  if( !weighted && isSorted && indices_generation == selection_generation &&
+      indices_selected.rows() >= npoints) {
+    count_sorted_bins( axis);
+    const unsigned int* pIndices = indices_selected.data();
+    for( int set=1; set<NBRUSHES; set++) {
+      const unsigned int* pBegin = pIndices + indices_start[ set];
+      const unsigned int* pEnd = pBegin + brushes[ set]->count;
+      double* pCounts = pBrushes + set*nbins;
+      for( const unsigned int* p = pBegin; p < pEnd; p++) {
+        pCounts[ histogram_bin( axis, values( *p))] += 1.0;
+      }
+    }
+    for( int bin=0; bin<nbins; bin++) {
+      double count = pMarginal[ bin];
+      for( int set=1; set<NBRUSHES; set++) count -= pBrushes[ set*nbins + bin];
+      pBrushes[ bin] = count;
+    }
+    return;
+  }
+
+  // Count every point, in one pass, in the bins of its brush, and add up 
+  // the brushes to get the marginal counts
+  Histogram_Kernel kernel;
+  if( histEquiDepth_[ axis]) kernel.set_equi_depth_bins( nbins, pEdges);
+  else kernel.set_equi_width_bins( nbins, amin[ axis], histScale_[ axis]);
+  kernel.set_points( values.data(), values.stride( 0), npoints);
+
+  // MCL XXX presently, weighting is based on the z-axis variable.  Weighting variable should really be a pulldown of is own.
+  // Without a z-axis, z is zero.
+  if( weighted && hasZ) {
+    kernel.set_weights( zValues.data(), zValues.stride( 0), 1.0);
+  }
+  else kernel.set_weights( NULL, 1, weighted ? 0.0 : 1.0);
+  kernel.set_sets( selected.data(), NBRUSHES);
+  kernel.run( nTasks, pBrushes);
+  for( int set=0; set<NBRUSHES; set++) {
+    for( int bin=0; bin<nbins; bin++) pMarginal[ bin] += pBrushes[ set*nbins + bin];
+  }
+}
+
+//***************************************************************************
+// Plot_Window::count_sorted_bins( axis) -- Compute the unweighted marginal 
+// counts of axis 'axis' from its sorted order.  Bins are in ascending order
+// of value, so the first point of each bin is found by binary search, and 
+// the cost is O(nbins log npoints).  The sorted order must be known.  This 
+// holds only for the finite values, so -Inf, +Inf, and NaN, which are 
+// sorted before and after them, are binned one at a time.
+void Plot_Window::count_sorted_bins( int axis)
+{
+  int nbins = histNbins_[ axis];
+  const blitz::Array<float,1> &values = axes_[ axis].values;
+  const blitz::Array<int,1> &order = axes_[ axis].order;
+  double* pMarginal = &marginalCounts_[ axis][ 0];
+  int iBegin, iEnd;
+  Rank_Engine::finite_range( 
+    values.data(), values.stride( 0), order.data(), npoints, iBegin, iEnd);
+
+  // Loop: Find the first finite point of each bin after the first, 
+  // searching only the points after the first point of the previous bin
+  int iFirst = iBegin;
+  for( int bin=0; bin<nbins; bin++) {
+    int iLow = iFirst, iHigh = iEnd;
+    while( iLow < iHigh) {
+      int iMid = iLow + ( iHigh-iLow)/2;
+      if( histogram_bin( axis, values( order( iMid))) <= bin) iLow = iMid+1;
+      else iHigh = iMid;
+    }
+    pMarginal[ bin] = iLow - iFirst;
+    iFirst = iLow;
+  }
+
+  // Loops: Add the points that aren't finite to the bins histogram_bin() 
+  // puts them in, so these counts agree with those of the brushes
+  for( int i=0; i<iBegin; i++) {
+    pMarginal[ histogram_bin( axis, values( order( i)))] += 1.0;
+  }
+  for( int i=iEnd; i<npoints; i++) {
+    pMarginal[ histogram_bin( axis, values( order( i)))] += 1.0;
+  }
+}
+
+//***************************************************************************
+// Plot_Window::histogram_bin( axis, x) -- Bin of value X in the cached 
+// histogram of axis 'axis', as found by the Histogram_Kernel.
+int Plot_Window::histogram_bin( int axis, float x) const
+{
+  int nbins = histNbins_[ axis];
+  if( histEquiDepth_[ axis]) {
+    return Histogram_Kernel::equi_depth_bin( x, &histEdges_[ axis][ 0], nbins);
+  }
+  return Histogram_Kernel::equi_width_bin( 
+    x, histMin_[ axis], histScale_[ axis], nbins);
+}
+
+//***************************************************************************
+// Plot_Window::patch_histogram( axis, removed, added) -- Move the points 
+// REMOVED[ set] out of, and the points ADDED[ set] into, the cached counts 
+// of brush SET for axis 'axis'.  The points of the marginal histogram 
+// don't change.
+void Plot_Window::patch_histogram( 
+  int axis, const std::vector<unsigned int> removed[], 
+  const std::vector<unsigned int> added[])
+{
+  int nbins = histNbins_[ axis];
+  const blitz::Array<float,1> &values = axes_[ axis].values;
+  const blitz::Array<float,1> &zValues = axes_[ 2].values;
+  if( values.rows() < npoints) return;
+  int hasZ = ( zValues.rows() >= npoints);
+  int weighted = histWeighted_[ axis];
+  double* pBrushes = &brushCounts_[ axis][ 0];
+  for( int set=0; set<NBRUSHES; set++) {
+    for( unsigned int m=0; m<removed[ set].size(); m++) {
+      int i = removed[ set][ m];
+      float weight = weighted?(hasZ ? zValues(i) : 0.0):1.0;
+      pBrushes[ set*nbins + histogram_bin( axis, values( i))] -= weight;
+    }
+    for( unsigned int m=0; m<added[ set].size(); m++) {
+      int i = added[ set][ m];
+      float weight = weighted?(hasZ ? zValues(i) : 0.0):1.0;
+      pBrushes[ set*nbins + histogram_bin( axis, values( i))] += weight;
+    }
+  }
+}
+
+//***************************************************************************
+// Plot_Window::patch_histograms( removed, added, generation) -- STATIC 
+// method to bring the cached histograms of all plots up to date after the 
+// points REMOVED[ set] left, and the points ADDED[ set] joined, brush SET.
+// Histograms that were current for selection generation GENERATION are 
+// patched and marked current, so a brush stroke costs O(points whose 
+// selection changed).  Any others are recomputed when they are next shown.
+void Plot_Window::patch_histograms( 
+  const std::vector<unsigned int> removed[], 
+  const std::vector<unsigned int> added[], unsigned int generation)
+{
+  for( int i=0; i<nplots; i++) {
+    Plot_Window* pw = pws[ i];
+    for( int axis=0; axis<2; axis++) {
+      if( !pw->histValid_[ axis] || pw->histNpoints_[ axis] != npoints ||
+          pw->histSelection_[ axis] != generation) continue;
+      pw->patch_histogram( axis, removed, added);
+      pw->histSelection_[ axis] = selection_generation;
+    }
+  }
+}
+
 //***************************************************************************
 // Plot_Window::compute_histograms() -- Invoke compute_histogram to compute
 // histograms for axes 0 and 1.
@@ -1580,14 +2276,21 @@ void Plot_Window::compute_histograms()
 }
 
 //***************************************************************************
-// Plot_Window::draw_x_histogram( bin_counts, nbins) -- Draw x histogram
+// Plot_Window::draw_x_histogram( bin_counts, nbins, pEdges) -- Draw x 
+// histogram.  If PEDGES is not NULL, it holds the nbins+1 edges of unequal
+// bins.
 void Plot_Window::draw_x_histogram(
-  const blitz::Array<float,1> bin_counts, const int nbins)
+  const blitz::Array<float,1> bin_counts, const int nbins, 
+  const float* pEdges)
 {
   float x = amin[0];
   float xwidth = (amax[0]-amin[0]) / (float)(nbins);
   glBegin( GL_LINE_STRIP);
   for( int bin=0; bin<nbins; bin++, x+=xwidth) {
+    if( pEdges) {
+      x = pEdges[ bin];
+      xwidth = pEdges[ bin+1] - pEdges[ bin];
+    }
     glVertex2f( x, 0.0); // lower left corner
     glVertex2f( x, bin_counts( bin, 0));   // left edge
     glVertex2f( x+xwidth, bin_counts( bin, 0));   // top edge
@@ -1597,14 +2300,21 @@ void Plot_Window::draw_x_histogram(
 }
 
 //***************************************************************************
-// Plot_Window::draw_y_histogram( bin_counts, nbins) -- Draw x histogram
+// Plot_Window::draw_y_histogram( bin_counts, nbins, pEdges) -- Draw y 
+// histogram.  If PEDGES is not NULL, it holds the nbins+1 edges of unequal
+// bins.
 void Plot_Window::draw_y_histogram(
-  const blitz::Array<float,1> bin_counts, const int nbins)
+  const blitz::Array<float,1> bin_counts, const int nbins, 
+  const float* pEdges)
 {
   float y = amin[1];
   float ywidth = (amax[1]-amin[1]) / (float)(nbins);
   glBegin( GL_LINE_STRIP);
   for( int bin=0; bin<nbins; bin++) {
+    if( pEdges) {
+      y = pEdges[ bin];
+      ywidth = pEdges[ bin+1] - pEdges[ bin];
+    }
     glVertex2f( 0.0, y);          
     glVertex2f(bin_counts(bin),y);   // bottom
     glVertex2f(bin_counts(bin), y+ywidth);   // right edge
@@ -1632,14 +2342,23 @@ void Plot_Window::draw_histograms()
     return;
   }
 
-  // note use of slider to control log_2 bincount
-  int xbins = (int)exp2(cp->nbins_slider[0]->value());
-  int ybins = (int)exp2(cp->nbins_slider[1]->value());
+  // note use of slider to control log_2 bincount, unless it is chosen 
+  // automatically
+  int xbins = histogram_nbins( 0);
+  int ybins = histogram_nbins( 1);
 
   // if no axes has bin count > zero, return immediately
   if (xbins <= 0 && ybins <= 0)
     return;
 
+  // Equi-depth histograms have bins of unequal widths
+  const float* pEdges[ 2] = { NULL, NULL};
+  int bins[ 2] = { xbins, ybins};
+  for( int k=0; k<2; k++) {
+    if( histValid_[ k] && histEquiDepth_[ k] && histNbins_[ k] == bins[ k])
+      pEdges[ k] = &histEdges_[ k][ 0];
+  }
+
   // histograms base is this far from edge of window
   float hoffset = 0.1; 
 
@@ -1660,12 +2379,12 @@ void Plot_Window::draw_histograms()
     // Draw x-axis histogram of all points.
     if (x_marginal) {
       glColor4f( 0.0, 0.5, 0.5, 1.0);
-      draw_x_histogram (counts(BINS,0), xbins);
+      draw_x_histogram (counts(BINS,0), xbins, pEdges[0]);
     }
     // Draw x-axis histogram of selected points
     if( nselected > 0 && x_selection) {
       glColor4f( 0.25, 1.0, 1.0, 1.0);
-      draw_x_histogram (counts_selected(BINS,0), xbins);
+      draw_x_histogram (counts_selected(BINS,0), xbins, pEdges[0]);
     }
     // Draw scaled x-axis histogram of selected points ("conditional");
     if( nselected > 0 && x_conditional) {
@@ -1673,7 +2392,7 @@ void Plot_Window::draw_histograms()
       blitz::Array<float,1> scaled_bin_counts(xbins);
       scaled_bin_counts = yscale*counts_selected(BINS,0);
       glColor4f( 0.5, 1.0, 1.0, 1.0);
-      draw_x_histogram (scaled_bin_counts, xbins);
+      draw_x_histogram (scaled_bin_counts, xbins, pEdges[0]);
     }
   }
 
@@ -1690,12 +2409,12 @@ void Plot_Window::draw_histograms()
     // Draw y-axis histogram of all points.
     if (y_marginal) {
       glColor4f( 0.0, 0.5, 0.5, 1.0);
-      draw_y_histogram (counts(BINS,1), ybins);
+      draw_y_histogram (counts(BINS,1), ybins, pEdges[1]);
     }
     // Draw y-axis histogram of selected points
     if( nselected > 0 && y_selection) {
       glColor4f( 0.25, 1.0, 1.0, 1.0);
-      draw_y_histogram (counts_selected(BINS,1), ybins);
+      draw_y_histogram (counts_selected(BINS,1), ybins, pEdges[1]);
     }
     // Draw scaled y-axis histogram of selected points ("conditional");
     if( nselected > 0 && y_conditional) {
@@ -1703,7 +2422,7 @@ void Plot_Window::draw_histograms()
       blitz::Array<float,1> scaled_bin_counts(ybins);
       scaled_bin_counts = yscale*counts_selected(BINS,1);
       glColor4f( 0.5, 1.0, 1.0, 1.0);
-      draw_y_histogram (scaled_bin_counts, ybins);
+      draw_y_histogram (scaled_bin_counts, ybins, pEdges[1]);
     }
 
   }
@@ -1711,26 +2430,114 @@ void Plot_Window::draw_histograms()
 }
 
 //***************************************************************************
-// Plot_Window::density_1D( a, axis) -- Compute marginal density estimate 
-// along axis using equi-width histogram.  Input array a is over-written.
-void Plot_Window::density_1D( blitz::Array<float,1> a, const int axis)
+// Plot_Window::update_density() -- Make sure the smoothed density of the 
+// (x,y) points of this plot is current.  The bandwidth along each axis is 
+// half the width of a histogram bin of that axis, so the density resolves 
+// about as much detail as the histograms do, and follows the bin count 
+// sliders and automatic bin counts.  The density is kept until the axes, 
+// their ranges, or the bandwidths change.  Returns 0 if there is no 
+// density.  Must be called from the main (FLTK) thread.
+int Plot_Window::update_density()
 {
-  // need to compute (but not necessarily display) the x-axis histogram if 
-  // its not already there.
-  if (!cp->show_histogram[axis]->value()) compute_histogram(axis);
-  int nbins = (int)(exp2(cp->nbins_slider[axis]->value()));
+  const blitz::Array<float,1> &x = axes_[0].values;
+  const blitz::Array<float,1> &y = axes_[1].values;
+  if( npoints <= 0 || x.rows() < npoints || y.rows() < npoints) return 0;
+
+  // Use a grid with at least three nodes per bandwidth, if it isn't too 
+  // large
+  float bandwidth[ 2];
+  int nodes[ 2];
+  for( int k=0; k<2; k++) {
+    int nbins = histogram_nbins( k);
+    if( nbins <= 0) nbins = nbins_default;
+    bandwidth[ k] = 0.5 * ( amax[ k] - amin[ k]) / nbins;
+    nodes[ k] = 64;
+    while( nodes[ k] < 6*nbins && nodes[ k] < density_nodes_max) nodes[ k] *= 2;
+  }
+  if( densityValid_ && densityNpoints_ == npoints &&
+      densityMin_[ 0] == amin[ 0] && densityMax_[ 0] == amax[ 0] &&
+      densityMin_[ 1] == amin[ 1] && densityMax_[ 1] == amax[ 1] &&
+      densityBandwidth_[ 0] == bandwidth[ 0] && 
+      densityBandwidth_[ 1] == bandwidth[ 1]) {
+    return 1;
+  }
 
-  // Loop: For each point, find which bin its in (since that isn't saved in 
-  // compute_histogram) and set the density estimate for the point 
-  // equal to the bin count
-  // range is tweaked by (n+1)/n to get the "last" point into the correct bin.
-  float range = (amax[axis] - amin[axis]) * ((float)(npoints+1)/(float)npoints); 
-  for( int i=0; i<npoints; i++) {
-    int bin = (int)(floorf( nbins * ( ( vertices(i,axis) - amin[axis]) / range)));
-    if( bin < 0) bin = 0;
-    if( bin > nbins-1) bin = nbins-1;
-    a(i) = counts( bin, axis)/(float)npoints;
+  densityGrid_.compute( 
+    x.data(), x.stride( 0), y.data(), y.stride( 0), npoints, 
+    amin[ 0], amax[ 0], amin[ 1], amax[ 1], bandwidth[ 0], bandwidth[ 1], 
+    nodes[ 0], nodes[ 1], 0);
+  densityValid_ = densityGrid_.is_computed();
+  densityNpoints_ = npoints;
+  for( int k=0; k<2; k++) {
+    densityMin_[ k] = amin[ k];
+    densityMax_[ k] = amax[ k];
+    densityBandwidth_[ k] = bandwidth[ k];
   }
+  densityTextureValid_ = 0;
+  return densityValid_;
+}
+
+//***************************************************************************
+// Plot_Window::density_2D( a) -- Compute smoothed density estimate of the 
+// (x,y) points at each point.  Input array a is over-written.
+void Plot_Window::density_2D( blitz::Array<float,1> a)
+{
+  if( a.rows() < npoints || !update_density()) return;
+  const blitz::Array<float,1> &x = axes_[0].values;
+  const blitz::Array<float,1> &y = axes_[1].values;
+  blitz::Array<float,1> density( npoints);
+  densityGrid_.interpolate( 
+    x.data(), x.stride( 0), y.data(), y.stride( 0), npoints, 
+    density.data(), 0);
+  a( blitz::Range( 0, npoints-1)) = density;
+}
+
+//***************************************************************************
+// Plot_Window::draw_density() -- If requested, draw the smoothed density of
+// the points as a grey-level image behind them, with the densest places 
+// mid-grey so the points stand out.
+void Plot_Window::draw_density()
+{
+  if( !cp->show_density->value() || cp->dont_clear->value()) return;
+  if( !update_density()) return;
+  int nx = densityGrid_.nx(), ny = densityGrid_.ny();
+
+  glEnable( GL_TEXTURE_2D);
+  if( densityTexture_ == 0) glGenTextures( 1, &densityTexture_);
+  glBindTexture( GL_TEXTURE_2D, densityTexture_);
+  if( !densityTextureValid_) {
+    std::vector<float> luminance( (size_t) nx * ny);
+    const float* pDensity = densityGrid_.data();
+    float scale = 0.5 / densityGrid_.max_value();
+    for( unsigned int k=0; k<luminance.size(); k++) {
+      luminance[ k] = scale * pDensity[ k];
+    }
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D( 
+      GL_TEXTURE_2D, 0, GL_LUMINANCE, nx, ny, 0, GL_LUMINANCE, GL_FLOAT, 
+      &luminance[ 0]);
+    CHECK_GL_ERROR( "loading density texture");
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    densityTextureValid_ = 1;
+  }
+  glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+  glDisable( GL_DEPTH_TEST);
+  glBlendFunc( GL_ONE, GL_ZERO);
+
+  // Texels are centered on the nodes of the grid
+  float dx = densityGrid_.dx(), dy = densityGrid_.dy();
+  float x0 = densityGrid_.x0() - 0.5*dx, x1 = x0 + nx*dx;
+  float y0 = densityGrid_.y0() - 0.5*dy, y1 = y0 + ny*dy;
+  glBegin( GL_QUADS);
+  glTexCoord2f( 0.0, 0.0); glVertex3f( x0, y0, 0.0);
+  glTexCoord2f( 1.0, 0.0); glVertex3f( x1, y0, 0.0);
+  glTexCoord2f( 1.0, 1.0); glVertex3f( x1, y1, 0.0);
+  glTexCoord2f( 0.0, 1.0); glVertex3f( x0, y1, 0.0);
+  glEnd();
+  glDisable( GL_TEXTURE_2D);
 }
 
 //***************************************************************************
@@ -1741,46 +2548,64 @@ int Plot_Window::transform_2d()
   blitz::Range NPTS(0,npoints-1);
 
   if( cp->no_transform->value()) return 1;
-
-  else if( cp->sum_vs_difference->value()) {
-    blitz::Array <float,1> tmp1(npoints), tmp2(npoints);
-    tmp1 = vertices(NPTS,0);
-    tmp2 = vertices(NPTS,1);
-    vertices(NPTS,0) = (sqrt(2.0)/2.0) * (tmp1 + tmp2);
-    vertices(NPTS,1) = (sqrt(2.0)/2.0) * (tmp2 - tmp1);
+  if( nExtracted_ != npoints) return 0;
+
+  // The normalized axes may be shared with other plots, so transform 
+  // copies of them.  The transformed axes belong to this plot alone.
+  blitz::Array <float,1> x(npoints), y(npoints);
+  x = axes_[0].values(NPTS);
+  y = axes_[1].values(NPTS);
+  int xChanged = 0;
+  if( cp->sum_vs_difference->value()) {
+    blitz::Array <float,1> tmp1(npoints);
+    tmp1 = x;
+    x = (sqrt(2.0)/2.0) * (tmp1 + y);
+    y = (sqrt(2.0)/2.0) * (y - tmp1);
+    xChanged = 1;
   }
   else if( cp->cond_prop->value()) {
-    blitz::Array <float,1> tmp1(npoints);
-    tmp1 = vertices(NPTS,1);
     int nbins = (int)(exp2(cp->nbins_slider[0]->value()));
-    cummulative_conditional (tmp1, x_rank, (npoints-1)/(nbins*2));
-    vertices(NPTS,1) = tmp1;
+    cummulative_conditional (y, x_rank, (npoints-1)/(nbins*2));
   }
   else if( cp->fluctuation->value()) {
-    blitz::Array <float,1> tmp1(npoints);
-    tmp1 = vertices(NPTS,1);
     int nbins = (int)(exp2(cp->nbins_slider[0]->value()));
-    fluctuation (tmp1, x_rank, (npoints-1)/(nbins*2));
-    vertices(NPTS,1) = tmp1;
+    fluctuation (y, x_rank, (npoints-1)/(nbins*2));
   }
+  else if( cp->xy_density->value()) {
+    density_2D (y);
+  }
+  blitz::Array <float,1>* transformed_values[2] = { &x, &y};
   for (int i=0; i<2; i++) {
-    wmin[i] = amin[i] = min(vertices(NPTS,i));
-    wmax[i] = amax[i] = max(vertices(NPTS,i));
+    wmin[i] = amin[i] = min(*transformed_values[i]);
+    wmax[i] = amax[i] = max(*transformed_values[i]);
+    if (i == 0 && !xChanged) continue;
+
+    Normalized_Axis transformed;
+    transformed.jvar = axes_[i].jvar;
+    transformed.style = axes_[i].style;
+    transformed.offset = axes_[i].offset;
+    transformed.npoints = npoints;
+    transformed.values.reference(*transformed_values[i]);
+    transformed.amin = amin[i];
+    transformed.amax = amax[i];
+    transformed.hasRange = 1;
+    transformed.lastUsed = 0;
+    attach_axis(i, transformed);
   }
   return 1;
 }
 
 //***************************************************************************
-// Plot_Window::normalize( a, a_rank0, style, axis_index) --  Apply
-// normalization of the requested style.
+// Plot_Window::normalize( a, a_rank0, style, axis_index, delta) --  Apply
+// normalization of the requested style to data that were shifted by the
+// axis offset DELTA.  Touches no widgets.
 int Plot_Window::normalize(
   blitz::Array<float,1> a, 
   blitz::Array<int,1> a_rank0, 
-  int style, int axis_index)
+  int style, int axis_index, int delta)
 {
   blitz::Range NPTS(0,npoints-1);
 
-  int delta = (int)cp->offset[axis_index]->value();
   // a_rank holds either the shifted rank indices, or unshifted when delta==0
   // necessary for exotic normalizations and/or (time)-shifted data.
   blitz::Array<int,1> a_rank(NPTS);
@@ -1943,42 +2768,14 @@ int Plot_Window::normalize(
 
 //***************************************************************************
 // Plot_Window::compute_rank( var_index) -- Order data for normalization and 
-// for the generation of histograms
+// for the generation of histograms.  If a background job is working on this
+// column, wait for it, and if one is queued, take it back.  Then rank the 
+// column here unless that has already been done, e.g., in the background or
+// because its ranks were loaded from a cache file.
 void Plot_Window::compute_rank( int var_index)
 {
-  // If we have a rank "cache hit", return, otherwise order data, etc.
-  if( Data_File_Manager::column_info[var_index].isRanked) {
-    return; 
-  }
-  else {
-    blitz::Range NPTS(0,npoints-1);
-
-    // The blitz copy constructor aliases the RHS,
-    // So this next statement just creates a new view of the rhs.
-    blitz::Array<int,1> a_ranked_indices =
-      (Data_File_Manager::column_info[var_index]).ranked_points(NPTS); 
-    
-    // initialialize the ranked indices to be sequential.  The sort that
-    // follows will permute them into the correct order.
-    blitz::firstIndex ident;    // MCL XXX don't we have a global holding this?
-    a_ranked_indices = ident;
-
-    // the sort method myCompare() needs a global alias (tmp_points) to the 
-    // array data holding the sort key.  We can't use the copy contructor 
-    // here since tmp_points was constructed in pre-main.
-    // Lucky for us, blitz provides the reference() method for this purpose.
-    tmp_points.reference(
-      (Data_File_Manager::column_info[var_index]).points(NPTS));
-
-    int *lo = a_ranked_indices.data();
-    int *hi = lo + npoints;
-    std::stable_sort( lo, hi, MyCompare());
-
-    // Data_File_Manager::column_info[var_index].ranked_points(NPTS) = a_ranked_indices(NPTS);
-
-    Data_File_Manager::column_info[var_index].isRanked = 1;  // now we are ranked
-    return;
-  }
+  Rank_Scheduler::claim( var_index);
+  (Data_File_Manager::column_info[var_index]).rank();
 }
 
 //***************************************************************************
@@ -1986,9 +2783,6 @@ void Plot_Window::compute_rank( int var_index)
 // set of axes, rank (order) and normalize and scale data, compute histograms, 
 // and compute axes scales.
 //
-// MCL XXX this routine (and others) could be refactored to loop over the axes
-// instead of having so much code replicated for each axis.
-//
 // MCL XXX this routine needs to be split into separate routines that:
 //  1) change one (or more) of the axes for a plot
 //  2) change the normalization of an axis (or axes) but only when necessary
@@ -1999,148 +2793,21 @@ void Plot_Window::compute_rank( int var_index)
 // can change the view for no good reason) and breakage in the rank-dependent
 // normalizations and transformations when operating on an axis with offset != 0.
 // Also, offsets should get reset to zero when an axis is changed.
+// (Items 1-3 are now handled by extract_data_points( axis_index).)
 int Plot_Window::extract_data_points ()
 {
-  // Get the labels for the plot's axes
-  long axis0 = (long)(cp->varindex1->mvalue()->user_data());
-  long axis1 = (long)(cp->varindex2->mvalue()->user_data());
-  long axis2 = (long)(cp->varindex3->mvalue()->user_data());
-
-  xlabel = pdfm->column_label(axis0);
-  ylabel = pdfm->column_label(axis1);
-  if( axis2 != nvars) zlabel = pdfm->column_label(axis2);
-  else zlabel = "";
-
-  // xlabel = Data_File_Manager::column_info[ axis0].label;
-  // ylabel = Data_File_Manager::column_info[ axis1].label;
-  // if( axis2 != nvars) zlabel = Data_File_Manager::column_info[ axis2].label;
-  // else zlabel = "";
-  
-  // Define a Range operator with which to extract subarrays
-  blitz::Range NPTS( 0, npoints-1);
-
-  // Order data to prepare for normalization and scaling and 
-  // report progress
+  // Report progress
   if (be_verbose) {
     cout << "Plot_Window::extract_data_points: plot[ " 
          << row << ", " << column << "]" <<endl;
     cout << " pre-normalization: " << endl;
   }
-  
-  // Rank points by x-axis value
-  compute_rank(axis0);
-  x_rank.reference( 
-    Data_File_Manager::column_info[axis0].ranked_points(NPTS));
-  tmin[0] =
-    Data_File_Manager::column_info[axis0].points(x_rank( 0));
-  tmax[0] =
-    Data_File_Manager::column_info[axis0].points(x_rank( npoints-1));
-  if( be_verbose) {
-    cout << "  x-axis( " << xlabel
-         << "): min[ " << x_rank( 0) << "] = "
-         << tmin[0]
-         << ", max[ " << x_rank( npoints-1) << "] = "
-         << tmax[0] << endl;
-  }
-
-  // Rank points by y-axis value
-  compute_rank(axis1);
-  y_rank.reference(
-    Data_File_Manager::column_info[axis1].ranked_points(NPTS));
-  tmin[1] =
-    Data_File_Manager::column_info[axis1].points( y_rank( 0));
-  tmax[1] =
-    Data_File_Manager::column_info[axis1].points( y_rank( npoints-1));
-  if( be_verbose) {
-    cout << "  y-axis( " << ylabel
-         << "): min[ " << y_rank( 0) << "] = "
-         << tmin[1]
-         << ", max[ " << y_rank( npoints-1) << "] = "
-         << tmax[1] << endl;
-  }
-
-  // If z-axis was specified, rank points by z-axis value
-  if( axis2 != nvars) {
-    compute_rank(axis2);
-    z_rank.reference(
-      Data_File_Manager::column_info[axis2].ranked_points(NPTS));
-    tmin[2] =
-      Data_File_Manager::column_info[axis2].points( z_rank( 0));
-    tmax[2] =
-      Data_File_Manager::column_info[axis2].points( z_rank( npoints-1));
-    if( be_verbose) {
-      cout << "  z-axis( " << zlabel
-           << "): min[ " << z_rank( 0) << "] = "
-           << tmin[2]
-           << ", max[ " << z_rank( npoints-1) << "] = "
-           << tmax[2] << endl;
-    }
-  }
-  if (be_verbose) cout << endl;
 
-  // OpenGL vertices, vertex arrays, and VBOs need to have their x, y, and z 
-  // coordinates interleaved -- i.e. stored in adjacent memory locations:  
-  // x[0],y[0],z[0],x[1],y[1],z[1],...  Unfortunately, this is not how the 
-  // raw data are stored in the blitz points() array.  For this reason, we 
-  // must copy the appropriate data "columns" from the points() array into 
-  // the appropriate components of the vertex() array.
-  //
-  // Though this copying takes up time and memory, it is OK since we will
-  // almost certainly want to normalize and/or transform the vertices prior 
-  // rendering them.  Since we don't want to transform and/or normalize 
-  // (i.e. clobber) the "original" data, we transform and/or normalize 
-  // using aliases to the vertex data.  Since the vertex data are copies 
-  // (not aliases) of the original uncorrupted points() data, this works 
-  // out fine.
-
-  // MCL XXX - there is no need to copy and normalize all axes if only one 
-  // has changed... Oh, well...
-
-  // copy (via assignment) the appropriate columns of points() data to 
-  // corresponding components of vertex() array, with circular offset(s), if 
-  // requested (experimental).
-  // MCL XXX need to do away with axis0, axis1, and axis2 & replace with axis_index[].
-  // First copy the x-axis
-  int delta = (int)cp->offset[0]->value();
-  if( delta == 0) {
-    vertices( NPTS, 0) = Data_File_Manager::column_info[ axis0].points( NPTS);
-  }
-  else {
-    circular_shift( vertices(NPTS,0), Data_File_Manager::column_info[axis0].points(NPTS), delta);
-  }
-
-  // Then copy the y-axis
-  delta = (int)cp->offset[1]->value();
-  if (delta == 0) {
-    vertices( NPTS, 1) = Data_File_Manager::column_info[ axis1].points( NPTS);
-  }
-  else {
-    circular_shift( vertices(NPTS,1), Data_File_Manager::column_info[axis1].points(NPTS), delta);
-  }
-
-  // if z-axis is set to "-nothing-" (which it is, by default), then all z=0.
-  if( axis2 == nvars)    {
-    vertices( NPTS, 2) = 0.0;
-  }
-  else {
-    // MCL XXX offset not supported for z axis (yet).
-    vertices( NPTS, 2) = Data_File_Manager::column_info[ axis2].points( NPTS);
-  }
-  
-  // create aliases to newly copied vertex data for normalization & transformation.
-  blitz::Array<float,1> xpoints = vertices( NPTS, 0); 
-  blitz::Array<float,1> ypoints = vertices( NPTS, 1);
-  blitz::Array<float,1> zpoints = vertices( NPTS, 2);
-
-  // Apply the normalize() method to normalize and scale the plot's data 
-  (void) normalize( xpoints, x_rank, cp->x_normalization_style->value(), 0);
-  (void) normalize( ypoints, y_rank, cp->y_normalization_style->value(), 1);
-  if( axis2 != nvars) {
-    (void) normalize( zpoints, z_rank, cp->z_normalization_style->value(), 2);
-  } else {
-    amin[2] = -1.0;
-    amax[2] = +1.0;
-  }
+  // Rank, normalize, and attach each axis
+  set_vertex_components( vertex_components());
+  for( int i=0; i<3; i++) extract_axis_data( i);
+  if (be_verbose) cout << endl;
+  nExtracted_ = npoints;
 
   // VBO will have to be updated to hold the new vertices in draw_data_points(), 
   // so we set a flag.  We can't update the VBO now, since we can't call openGL 
@@ -2156,12 +2823,377 @@ int Plot_Window::extract_data_points ()
   reset_view();
 
   compute_histograms();
+  build_grid();
+  return 1;
+}
+
+//***************************************************************************
+// Plot_Window::extract_data_points( axis_index) -- Extract data after the
+// variable, normalization, or offset of axis AXIS_INDEX has changed.  Only 
+// that axis is ranked, normalized, and copied, and only its histogram is 
+// recomputed.  Everything is extracted if a 2D transformation is active,
+// since these combine the x and y axes, if the vertices of the other axes
+// are out of date, or if the z-axis was added or removed, which changes 
+// the layout of the interleaved vertices.
+int Plot_Window::extract_data_points( int axis_index)
+{
+  if( axis_index < 0 || axis_index > 2 || nExtracted_ != npoints ||
+      !cp->no_transform->value() || vertex_components() != nComponents_) {
+    return extract_data_points();
+  }
+
+  extract_axis_data( axis_index);
+  VBOfilled = false;
+  reset_view();
+
+  // Histograms may be weighted by the z-axis
+  if( axis_index < 2) compute_histogram( axis_index);
+  else compute_histograms();
   return 1;
 }
 
+//***************************************************************************
+// Plot_Window::vertex_components() -- Number of components the vertices 
+// need for the current axes: two if the z-axis is "-nothing-", otherwise
+// three.  Must be called from the main (FLTK) thread.
+int Plot_Window::vertex_components()
+{
+  int axis2 = (long)(cp->varindex3->mvalue()->user_data());
+  if( axis2 == nvars) return 2;
+  return 3;
+}
+
+//***************************************************************************
+// Plot_Window::set_vertex_components( nComponents) -- Set the number of 
+// components of the interleaved vertices for the next extraction.  If the
+// layout or the number of points changes, any interleaved vertices are 
+// discarded and this window's VBO, if it has one, must be reallocated.
+void Plot_Window::set_vertex_components( int nComponents)
+{
+  if( nExtracted_ == npoints && nComponents_ == nComponents) return;
+  nComponents_ = nComponents;
+  vertices.free();
+  verticesFilled = false;
+  VBOinitialized = 0;
+  VBOfilled = false;
+}
+
+//***************************************************************************
+// Plot_Window::extract_axis_data( axis_index) -- Rank and normalize the 
+// data for axis AXIS_INDEX, unless they're in the Axis_Cache, and show 
+// them in this plot.
+void Plot_Window::extract_axis_data( int axis_index)
+{
+  Normalized_Axis axis;
+  if( prepare_axis( axis_index, axis) == 0) {
+    normalize_axis( axis_index, axis);
+    if( axis.style != Control_Panel_Window::NORMALIZATION_RANDOMIZE)
+      Axis_Cache::store( axis);
+  }
+  attach_axis( axis_index, axis);
+}
+
+//***************************************************************************
+// Plot_Window::prepare_axis( axis_index, axis) -- Get the label of axis 
+// AXIS_INDEX, rank its column to get the true range of the data, and fill 
+// in the column, normalization style, offset, and number of points of AXIS.
+// If the normalized data are in the Axis_Cache, or if the z-axis is set to
+// "-nothing-", AXIS is complete and 1 is returned.  Otherwise 0 is returned 
+// and AXIS must be passed to normalize_axis().  Must be called from the 
+// main (FLTK) thread.
+int Plot_Window::prepare_axis( int axis_index, Normalized_Axis &axis)
+{
+  Fl_Choice* varindex[ 3] = { cp->varindex1, cp->varindex2, cp->varindex3};
+  Fl_Choice* normalization_style[ 3] = {
+    cp->x_normalization_style, cp->y_normalization_style, 
+    cp->z_normalization_style};
+  std::string* label[ 3] = { &xlabel, &ylabel, &zlabel};
+  blitz::Array<int,1>* a_rank[ 3] = { &x_rank, &y_rank, &z_rank};
+  const char* axis_name[ 3] = { "x", "y", "z"};
+
+  // Get the variable, normalization style, and offset for this axis
+  axis.jvar = (int)(long)(varindex[ axis_index]->mvalue()->user_data());
+  axis.style = normalization_style[ axis_index]->value();
+  axis.offset = (int) cp->offset[ axis_index]->value();
+  axis.npoints = npoints;
+
+  // if z-axis is set to "-nothing-" (which it is, by default), then all z=0.
+  if( axis.jvar == nvars) {
+    *label[ axis_index] = "";
+    axis.amin = -1.0;
+    axis.amax = +1.0;
+    axis.hasRange = 1;
+    return 1;
+  }
+  *label[ axis_index] = pdfm->column_label( axis.jvar);
+
+  // Define a Range operator with which to extract subarrays
+  blitz::Range NPTS( 0, npoints-1);
+
+  // Rank points by value to prepare for normalization and scaling
+  compute_rank( axis.jvar);
+  blitz::Array<int,1> &rank = *a_rank[ axis_index];
+  rank.reference( 
+    Data_File_Manager::column_info[ axis.jvar].ranked_points( NPTS));
+  tmin[ axis_index] =
+    Data_File_Manager::column_info[ axis.jvar].points( rank( 0));
+  tmax[ axis_index] =
+    Data_File_Manager::column_info[ axis.jvar].points( rank( npoints-1));
+  if( be_verbose) {
+    cout << "  " << axis_name[ axis_index] << "-axis( " 
+         << *label[ axis_index]
+         << "): min[ " << rank( 0) << "] = "
+         << tmin[ axis_index]
+         << ", max[ " << rank( npoints-1) << "] = "
+         << tmax[ axis_index] << endl;
+  }
+
+  // Randomized data are never shared, so each plot gets its own shuffle
+  if( axis.style == Control_Panel_Window::NORMALIZATION_RANDOMIZE) return 0;
+  return Axis_Cache::find( axis.jvar, axis.style, axis.offset, axis);
+}
+
+//***************************************************************************
+// Plot_Window::normalize_axis( axis_index, axis) -- Copy the data for the 
+// column of AXIS, shifted by its offset, and apply its normalization style 
+// to get its values and range.  AXIS must have been filled in by 
+// prepare_axis() for axis AXIS_INDEX of this plot.  Touches no widgets, 
+// so axes of different columns can be normalized at the same time on 
+// different threads, except that randomization uses the shared random 
+// number generator.
+void Plot_Window::normalize_axis( int axis_index, Normalized_Axis &axis)
+{
+  blitz::Range NPTS( 0, npoints-1);
+  blitz::Array<float,1> column = 
+    Data_File_Manager::column_info[ axis.jvar].points( NPTS);
+  blitz::Array<int,1> a_rank = 
+    Data_File_Manager::column_info[ axis.jvar].ranked_points( NPTS);
+
+  // Styles that only set the range leave the data alone, so unshifted 
+  // data can be used as they are.  Otherwise, normalize a copy.
+  int isRangeOnly =
+    axis.style == Control_Panel_Window::NORMALIZATION_NONE ||
+    axis.style == Control_Panel_Window::NORMALIZATION_MINMAX ||
+    axis.style == Control_Panel_Window::NORMALIZATION_ZEROMAX ||
+    axis.style == Control_Panel_Window::NORMALIZATION_MAXABS;
+  if( axis.offset == 0 && isRangeOnly) axis.values.reference( column);
+  else {
+    axis.values.resize( npoints);
+    if( axis.offset == 0) axis.values = column;
+    else circular_shift( axis.values, column, axis.offset);
+  }
+
+  // Some styles don't always set the range, so flag it to find out
+  float amin_save = amin[ axis_index], amax_save = amax[ axis_index];
+  amin[ axis_index] = MAXFLOAT;
+  amax[ axis_index] = -MAXFLOAT;
+  (void) normalize( axis.values, a_rank, axis.style, axis_index, axis.offset);
+  axis.hasRange = 
+    amin[ axis_index] != MAXFLOAT || amax[ axis_index] != -MAXFLOAT;
+  axis.amin = amin[ axis_index];
+  axis.amax = amax[ axis_index];
+  amin[ axis_index] = amin_save;
+  amax[ axis_index] = amax_save;
+}
+
+//***************************************************************************
+// Plot_Window::attach_axis( axis_index, axis) -- Show the normalized values
+// of AXIS, by reference, as axis AXIS_INDEX of this plot, set the range of
+// the axis, and let go of the shared VBO of the old values.  draw() gets 
+// the VBO for the new values, or, if the shader for shared axes isn't 
+// available, refills the interleaved vertices.  If the axis has no column 
+// (the z-axis is "-nothing-"), it has no values and z is zero.  Must be 
+// called from the main (FLTK) thread, since blitz reference counts are not
+// thread safe.
+void Plot_Window::attach_axis( int axis_index, const Normalized_Axis &axis)
+{
+  Axis_Cache::release_buffer( axisBuffers_[ axis_index]);
+  axisBuffers_[ axis_index] = 0;
+  Axis_Cache::copy( axes_[ axis_index], axis);
+  if( axis_index < 2) gridValid_ = 0;
+
+  // Histograms may be weighted by the z-axis
+  if( axis_index < 2) histValid_[ axis_index] = 0;
+  else histValid_[ 0] = histValid_[ 1] = 0;
+  if( axis_index < 2) autoBins_[ axis_index] = 0;
+  if( axis_index < 2) densityValid_ = 0;
+  if( axis.hasRange) {
+    amin[ axis_index] = axis.amin;
+    amax[ axis_index] = axis.amax;
+  }
+  VBOfilled = false;
+  verticesFilled = false;
+}
+
 //***************************************************************************
 // Define STATIC methods
 
+//***************************************************************************
+// Extract_Run -- Work shared by the Worker_Pool tasks of 
+// extract_all_data_points().  Each Axis_Job is a normalized axis that wasn't
+// in the Axis_Cache, to be normalized for the first plot axis that needs 
+// it.  Jobs are grouped by column, so the blitz arrays of a column are 
+// only touched by one thread.  Each Plot_Job holds the normalized axes and
+// histogram settings of one plot, and whether its spatial grid can be 
+// built from the attached axes.
+struct Axis_Job {
+  Plot_Window* pw;
+  int axis_index;
+  Normalized_Axis axis;
+};
+
+struct Plot_Job {
+  Normalized_Axis axes[ 3];
+  int iAxisJob[ 3];
+  int doHistogram[ 2], nbins[ 2], brush_index[ 2], weighted[ 2];
+  int equi_depth[ 2];
+  int doGrid;
+};
+
+struct Extract_Run {
+  std::vector<Axis_Job> axis_jobs;
+  std::vector< std::vector<int> > column_jobs;
+  std::vector<Plot_Job> plot_jobs;
+};
+
+//***************************************************************************
+// Plot_Window::extract_all_data_points() -- STATIC method that does the 
+// work of extract_data_points() for every plot window, with the CPU-bound 
+// work for different columns and different plots done at the same time on
+// the Worker_Pool: 
+//  1) On the main (FLTK) thread, get labels and settings and rank each 
+//     column that is shown.  Each column is ranked only once, and ranks are
+//     shared by all plots.
+//  2) On worker threads, normalize each axis that isn't in the Axis_Cache,
+//     one task per column.  Then store the new axes in the cache and 
+//     attach them to the plots.
+//  3) On worker threads, compute histograms and spatial grids, one task 
+//     per plot.
+//  4) On the main thread, apply 2D transformations, if any, and reset the
+//     views.  VBOs are filled by draw() as usual.
+void Plot_Window::extract_all_data_points()
+{
+  if( nplots <= 0) return;
+  Extract_Run run;
+  run.plot_jobs.resize( nplots);
+  run.column_jobs.resize( nvars);
+
+  // Step 1: Prepare axes, and find the normalized axes that aren't cached.
+  // Randomized axes use the shared random number generator, so they are 
+  // normalized here.
+  for( int i=0; i<nplots; i++) {
+    Plot_Window* pw = pws[ i];
+    Plot_Job &plot_job = run.plot_jobs[ i];
+    if( be_verbose) {
+      cout << "Plot_Window::extract_all_data_points: plot[ " 
+           << pw->row << ", " << pw->column << "]" <<endl;
+      cout << " pre-normalization: " << endl;
+    }
+    pw->set_vertex_components( pw->vertex_components());
+    for( int k=0; k<3; k++) {
+      Normalized_Axis &axis = plot_job.axes[ k];
+      plot_job.iAxisJob[ k] = -1;
+      if( pw->prepare_axis( k, axis) != 0) continue;
+      if( axis.style == Control_Panel_Window::NORMALIZATION_RANDOMIZE) {
+        pw->normalize_axis( k, axis);
+        continue;
+      }
+      for( unsigned int m=0; m<run.axis_jobs.size(); m++) {
+        const Normalized_Axis &queued = run.axis_jobs[ m].axis;
+        if( queued.jvar == axis.jvar && queued.style == axis.style &&
+            queued.offset == axis.offset) {
+          plot_job.iAxisJob[ k] = m;
+          break;
+        }
+      }
+      if( plot_job.iAxisJob[ k] >= 0) continue;
+      plot_job.iAxisJob[ k] = run.axis_jobs.size();
+      run.column_jobs[ axis.jvar].push_back( run.axis_jobs.size());
+      Axis_Job axis_job;
+      axis_job.pw = pw;
+      axis_job.axis_index = k;
+      Axis_Cache::copy( axis_job.axis, axis);
+      run.axis_jobs.push_back( axis_job);
+    }
+    if( be_verbose) cout << endl;
+  }
+
+  // Step 2: Normalize the new axes, then store them in the cache and give
+  // them to the plots that need them
+  Worker_Pool::run_tasks( normalize_task, (void*) &run, nvars);
+  for( unsigned int m=0; m<run.axis_jobs.size(); m++)
+    Axis_Cache::store( run.axis_jobs[ m].axis);
+  for( int i=0; i<nplots; i++) {
+    Plot_Job &plot_job = run.plot_jobs[ i];
+    for( int k=0; k<3; k++) {
+      if( plot_job.iAxisJob[ k] >= 0) {
+        Axis_Cache::copy( 
+          plot_job.axes[ k], run.axis_jobs[ plot_job.iAxisJob[ k]].axis);
+      }
+      pws[ i]->attach_axis( k, plot_job.axes[ k]);
+    }
+
+    // Histograms and grids are computed with the attached axes, unless a 
+    // transformation will change them.
+    plot_job.doGrid = pws[ i]->cp->no_transform->value();
+    for( int k=0; k<2; k++) {
+      plot_job.doHistogram[ k] = 
+        pws[ i]->cp->no_transform->value() &&
+        pws[ i]->histogram_settings( 
+          k, plot_job.nbins[ k], plot_job.brush_index[ k], 
+          plot_job.weighted[ k], plot_job.equi_depth[ k]);
+    }
+  }
+
+  // Step 3: Compute histograms and spatial grids
+  Worker_Pool::run_tasks( extract_task, (void*) &run, nplots);
+
+  // Step 4: Finish each plot on the main thread
+  for( int i=0; i<nplots; i++) {
+    Plot_Window* pw = pws[ i];
+    pw->nExtracted_ = npoints;
+    pw->VBOfilled = false;
+    if( !pw->cp->no_transform->value()) {
+      (void) pw->transform_2d();
+      pw->reset_view();
+      pw->compute_histograms();
+      pw->build_grid();
+    }
+    else pw->reset_view();
+  }
+}
+
+//***************************************************************************
+// Plot_Window::normalize_task( pUser, jcol) -- STATIC Worker_Pool task for
+// extract_all_data_points() that normalizes the new axes of column JCOL.
+void Plot_Window::normalize_task( void* pUser, int jcol)
+{
+  Extract_Run* pRun = (Extract_Run*) pUser;
+  std::vector<int> &jobs = pRun->column_jobs[ jcol];
+  for( unsigned int m=0; m<jobs.size(); m++) {
+    Axis_Job &axis_job = pRun->axis_jobs[ jobs[ m]];
+    (axis_job.pw)->normalize_axis( axis_job.axis_index, axis_job.axis);
+  }
+}
+
+//***************************************************************************
+// Plot_Window::extract_task( pUser, iPlot) -- STATIC Worker_Pool task for 
+// extract_all_data_points() that computes the histograms and the spatial 
+// grid of plot IPLOT.
+void Plot_Window::extract_task( void* pUser, int iPlot)
+{
+  Extract_Run* pRun = (Extract_Run*) pUser;
+  Plot_Job &plot_job = pRun->plot_jobs[ iPlot];
+  Plot_Window* pw = pws[ iPlot];
+  for( int k=0; k<2; k++) {
+    if( plot_job.doHistogram[ k] == 0) continue;
+    pw->fill_histogram( 
+      k, plot_job.nbins[ k], plot_job.brush_index[ k], plot_job.weighted[ k],
+      plot_job.equi_depth[ k], 1);
+  }
+  if( plot_job.doGrid) pw->build_grid();
+}
+
 //***************************************************************************
 // Plot_Window::upper_triangle_incr( i, j, n) -- STATIC method to increment 
 // the row and column indices, (i,j), to traverse an upper triangular matrix 
@@ -2254,30 +3286,54 @@ void Plot_Window::run_timing_test()
        << " vertices/sec " << endl;
 }
 
+//***************************************************************************
+// Delete_Rows -- Map from old to new row numbers used to delete rows, and 
+// delete_rows_task( pUser, jcol), the Worker_Pool task that deletes them 
+// from column JCOL.  Columns are independent, so they can be compacted at 
+// the same time.
+struct Delete_Rows {
+  const int* pNewIndex;
+  int n;
+};
+
+static void delete_rows_task( void* pUser, int jcol)
+{
+  Delete_Rows* pDelete = (Delete_Rows*) pUser;
+  Data_File_Manager::column_info[ jcol].remove_rows( 
+    pDelete->pNewIndex, pDelete->n);
+}
+
 //***************************************************************************
 // Plot_Window::delete_selection( p) -- STATIC method to delete selected 
-// points.  This is a static method used only by class Plot_Window.
+// points.  This is a static method used only by class Plot_Window.  Columns
+// are compacted in parallel.  Deleting rows doesn't change the order of the
+// rows that remain, so the ranks of each ranked column are kept and simply
+// renumbered.
 void Plot_Window::delete_selection( Fl_Widget *o)
 {
   // blitz::Range NVARS(0,nvars-1);
+  blitz::Range NPTS( 0, npoints-1);
+  if( !blitz::any( selected( NPTS) > 0)) return;
+
+  // Stop background ranking and discard normalized axes before any column
+  // is changed
+  Rank_Scheduler::stop();
+  Axis_Cache::clear();
+
+  // Number the rows that remain.  Deleted rows get -1.
+  std::vector<int> new_index( npoints);
   int ipoint=0;
   for( int n=0; n<npoints; n++) {
-    if( selected( n) < 0.5) {
-      // could speed this up with look-ahead....
-      for( int j=0; j<nvars; j++) {
-        Data_File_Manager::column_info[j].points(ipoint) = Data_File_Manager::column_info[j].points(n);
-      }
-      ipoint++;
-    }
+    if( selected( n) < 0.5) new_index[ n] = ipoint++;
+    else new_index[ n] = -1;
   }
 
-  // KLUDGE: If no points remain, reload the first two points
+  // KLUDGE: If fewer than two points remain, keep the first two points
   // to avoid overflows
   if( ipoint < 2) {
-    for( int j=0; j<nvars; j++) {
-      Data_File_Manager::column_info[j].points(0) = Data_File_Manager::column_info[j].points(0);
-      Data_File_Manager::column_info[j].points(1) = Data_File_Manager::column_info[j].points(1);
-    }
+    for( int n=0; n<npoints; n++) new_index[ n] = -1;
+    new_index[ 0] = 0;
+    new_index[ 1] = 1;
     ipoint = 2;
     cerr << " -WARNING: tried to delete every data point, "
          << "first two points retained." << endl;
@@ -2285,19 +3341,37 @@ void Plot_Window::delete_selection( Fl_Widget *o)
   }
   
   // If the final index does not match the number of points, some point(s) 
-  // got deleted and everyone's ranking must be recomputed
+  // got deleted.
   if( ipoint != npoints)  {
+
+    // Columns and ranks that are views into a memory-mapped file must be 
+    // copied before they can be compacted in place.  Then compact every 
+    // column.
+    for( int j=0; j<nvars; j++) 
+      Data_File_Manager::column_info[j].materialize();
+    Delete_Rows delete_rows;
+    delete_rows.pNewIndex = &new_index[ 0];
+    delete_rows.n = npoints;
+    Worker_Pool::run_tasks( delete_rows_task, (void*) &delete_rows, nvars);
       
     // Update the number of points
     npoints = ipoint;
 
     // Resize the current data buffer to conserve memory and because the
-    // Data_File_Manager class uses it to recalculate NPOINTS.  Also reset
-    // the 'isRanked' flags.
+    // Data_File_Manager class uses it to recalculate NPOINTS.  Resize the 
+    // ranks too.  Columns that weren't ranked will be ranked in the 
+    // background.
     for( int j=0; j<nvars; j++) {
-      (Data_File_Manager::column_info[j].points).resizeAndPreserve(npoints);
-      Data_File_Manager::column_info[j].isRanked = 0;
+      Column_Info &info = Data_File_Manager::column_info[j];
+      (info.points).resizeAndPreserve(npoints);
+      if( info.is_ranked()) (info.ranked_points).resizeAndPreserve(npoints);
+      else info.unrank();
     }
+    Rank_Scheduler::start();
+
+    // Shrink the selection arrays and masks to the new number of points.
+    // This also clears the selection.
+    Data_File_Manager::resize_selection_arrays();
 
     // Clear selections and redraw everything
     clear_selections( (Fl_Widget *) NULL);
@@ -2397,18 +3471,38 @@ void Plot_Window::clear_selections( Fl_Widget *o)
 }
 
 //***************************************************************************
-// Plot_Window::select_on_string( *str, a_col) -- Search through all points, 
-// using given column, a_col, as the "key".  Flag as "inside the footprint" 
-// (i.e. painted by this "string search brush") only those points whose 
-// corresponding ascii value matches the given string.
-void Plot_Window::select_on_string( const char *str, int a_col)
+// Plot_Window::select_on_string( *str, a_col, useRegex, ignoreCase) -- 
+// Search through all points, using given column, a_col, as the "key".  Flag
+// as "inside the footprint" (i.e. painted by this "string search brush") 
+// only those points whose corresponding ascii value matches the given 
+// string or regular expression.  The string is matched once against each 
+// distinct ascii value, then the codes of the points are looked up in the 
+// resulting table 64 points at a time.
+void Plot_Window::select_on_string(
+  const char *str, int a_col, int useRegex, int ignoreCase)
 {
-  if( Data_File_Manager::column_info[a_col].hasASCII && a_col>=0) {
-    for(int i=0;i<npoints;i++) {
-      const char *label_a = 
-        Data_File_Manager::column_info[a_col].ascii_value(
-          (int) Data_File_Manager::column_info[a_col].points(i)).c_str();
-      inside_footprint(i) = (label_a && strstr(label_a,str))?1:0;
+  if( a_col>=0 && Data_File_Manager::column_info[a_col].hasASCII) {
+    Column_Info &info = Data_File_Manager::column_info[a_col];
+    std::vector<unsigned char> matches;
+    if( info.match_ascii_values( str, useRegex, ignoreCase, matches) != 0) 
+      return;
+    int nCodes = matches.size();
+    const float* pCodes = info.points.data();
+    int stride = info.points.stride( 0);
+    int nWords = ( npoints + Bit_Mask::WORD_BITS-1) / Bit_Mask::WORD_BITS;
+    assert( nWords <= inside_footprint.n_words());
+    for( int iWord=0; iWord<nWords; iWord++) {
+      int iBegin = iWord * Bit_Mask::WORD_BITS;
+      int nBits = npoints - iBegin;
+      if( nBits > Bit_Mask::WORD_BITS) nBits = Bit_Mask::WORD_BITS;
+      const float* p = pCodes + (size_t) iBegin * stride;
+      Bit_Mask::Word w = 0;
+      for( int i=0; i<nBits; i++, p+=stride) {
+        int code = (int) *p;
+        if( code >= 0 && code < nCodes)
+          w |= ( (Bit_Mask::Word) matches[ code]) << i;
+      }
+      inside_footprint.set_word( iWord, w);
     }
   }
   else {
@@ -2608,7 +3702,7 @@ void Plot_Window::initialize_VBO()
 
     // Reserve enough space in openGL server memory VBO to hold all the 
     // vertices, but do not initilize it.
-    glBufferData( GL_ARRAY_BUFFER, (GLsizeiptr) npoints*3*sizeof(GLfloat), (void *)NULL, GL_DYNAMIC_DRAW);
+    glBufferData( GL_ARRAY_BUFFER, (GLsizeiptr) npoints*nComponents_*sizeof(GLfloat), (void *)NULL, GL_DYNAMIC_DRAW);
 
     // Make sure we succeeded 
     CHECK_GL_ERROR ("initializing VBO");
@@ -2618,70 +3712,248 @@ void Plot_Window::initialize_VBO()
 }
  
 //***************************************************************************
-// Plot_Window::fill_VBO() -- Fill the VBO for this window
+// Plot_Window::fill_VBO() -- Fill the VBO for this window.  The normalized
+// axes are interleaved straight into the mapped VBO, so no CPU-side copy of
+// the vertices is needed.  If the VBO can't be mapped, or its contents are
+// lost before it is unmapped, the vertices are interleaved into a 
+// temporary buffer and copied with glBufferSubData() instead.
 void Plot_Window::fill_VBO()
 {
   if (!VBOfilled) {
     glBindBuffer(GL_ARRAY_BUFFER, index+1);  
-    void *vertexp = (void *)vertices.data();
-    glBufferSubData( GL_ARRAY_BUFFER, (GLintptr) 0, (GLsizeiptr) (npoints*3*sizeof(GLfloat)), vertexp);
+    if (npoints > 0) {
+      int isFilled = 0;
+      float *vertexp = (float *) glMapBuffer( GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+      CHECK_GL_ERROR("mapping VBO");
+      if (vertexp != NULL) {
+        interleave_axes( vertexp);
+        isFilled = (glUnmapBuffer( GL_ARRAY_BUFFER) == GL_TRUE);
+        if (!isFilled) {
+          cerr << " VBO for plot window " << index << " was lost while it was filled, copying it again" << endl;
+        }
+      }
+      else {
+        cerr << " couldn't map VBO for plot window " << index << ", copying it instead" << endl;
+      }
+      if (!isFilled) {
+        size_t nValues = (size_t) npoints*nComponents_;
+        std::vector<GLfloat> buffer( nValues);
+        interleave_axes( &buffer[ 0]);
+        glBufferSubData( GL_ARRAY_BUFFER, 0, (GLsizeiptr) nValues*sizeof(GLfloat), &buffer[ 0]);
+      }
+    }
     CHECK_GL_ERROR("filling VBO");
     VBOfilled = true;
+
+    // Interleaved vertices, if any were made without VBOs, aren't needed
+    vertices.free();
+    verticesFilled = false;
   }
 }
 
 //***************************************************************************
-// Plot_Window::initialize_indexVBO() -- Initialize the 'index VBO' that
-// holds indices of selected (or non-selected) points.
-// MCL XXX index VBOs hould probably be handled by the Brush class.
-void Plot_Window::initialize_indexVBO(int set)
+// Plot_Window::fill_vertices() -- Fill the interleaved vertices for this 
+// window.  Only needed if neither the shader for shared axes nor VBOs can 
+// be used.
+void Plot_Window::fill_vertices()
 {
-  // There is one shared set of index VBOs for all plots.
-  //  indexVBO bound to MAXPLOTS+1 holds indices of nonselected (brushes[0]) points
-  //  indexVBO bound to MAXPLOTS+2 holds indices of points selected by brushes[1], etc.
-  glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, MAXPLOTS+set+1);  // a safe place....
-  glBufferData( GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) (npoints*sizeof(GLuint)), (void*) NULL, GL_DYNAMIC_DRAW);
+  vertices.resize( npoints, nComponents_);
+  if (npoints > 0) interleave_axes( vertices.data());
+  verticesFilled = true;
 }
 
 //***************************************************************************
-// Plot_Window::initialize_indexVBOs() -- Initialize set of index VBOs
-void Plot_Window::initialize_indexVBOs() 
+// Plot_Window::interleave_axes( pVertex) -- Copy the normalized axes of 
+// this window to PVERTEX as npoints vertices of nComponents_ components.
+// OpenGL vertex arrays and VBOs read by glVertexPointer() need to have 
+// their x, y, and z coordinates interleaved -- i.e. stored in adjacent 
+// memory locations: x[0],y[0],z[0],x[1],y[1],z[1],...  Unfortunately, this 
+// is not how the normalized axes are stored.  An axis without values (e.g.,
+// before the first extraction) is zero.
+void Plot_Window::interleave_axes( float* pVertex)
 {
-  if (!indexVBOsinitialized) {
-    for (int set=0; set<NBRUSHES; set++) {
-      initialize_indexVBO(set);
+  for( int k=0; k<nComponents_; k++) {
+    const blitz::Array<float,1> &values = axes_[ k].values;
+    float* pComponent = pVertex + k;
+    if( values.rows() < npoints) {
+      for( int i=0; i<npoints; i++) pComponent[ i*nComponents_] = 0.0;
+      continue;
     }
-    indexVBOsinitialized = 1;
+    const float* pValue = values.data();
+    int valueStride = values.stride( 0);
+    for( int i=0; i<npoints; i++)
+      pComponent[ i*nComponents_] = pValue[ i*valueStride];
   }
 }
 
 //***************************************************************************
-// Plot_Window::fill_indexVBO() -- Fill the index VBO
-void Plot_Window::fill_indexVBO(int set)
+// Vertex shader that reads the x, y, and z coordinates of each point from 
+// three separate arrays, so the shared VBOs of normalized axes can be used
+// as they are.  Everything else is left to the fixed-function pipeline.
+static const char* axis_shader_source =
+  "attribute float xCoord;\n"
+  "attribute float yCoord;\n"
+  "attribute float zCoord;\n"
+  "void main()\n"
+  "{\n"
+  "  gl_Position = gl_ModelViewProjectionMatrix * vec4( xCoord, yCoord, zCoord, 1.0);\n"
+  "  gl_FrontColor = gl_Color;\n"
+  "  gl_BackColor = gl_Color;\n"
+  "}\n";
+
+//***************************************************************************
+// Plot_Window::initialize_axis_program() -- STATIC method to compile and 
+// link the vertex shader for shared axes.  The coordinates are bound to 
+// generic attributes 0, 1, and 2.  If openGL 2.0 isn't available or the 
+// shader can't be built, axis_program is left at zero and each window uses 
+// its own interleaved vertices.  Any program built before is deleted 
+// first, along with its shader.  Must be called while an openGL context 
+// is current.
+void Plot_Window::initialize_axis_program()
 {
-  if (brushes[set]->count > 0) {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, MAXPLOTS+set+1);
-    // Create an alias to slice
-    blitz::Array<unsigned int, 1> tmpArray = indices_selected( set, blitz::Range(0,npoints-1));
-    unsigned int *indices = (unsigned int *) (tmpArray.data());
-    glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, (GLintptr) 0, (GLsizeiptr) (brushes[set]->count*sizeof(GLuint)), indices);
-    // make sure we succeeded 
-    CHECK_GL_ERROR("filling index VBO");
+  axis_program_initialized = 1;
+  if( axis_program != 0) glDeleteProgram( axis_program);
+  axis_program = 0;
+  const char* version = (const char*) glGetString( GL_VERSION);
+  if( version == NULL || atof( version) < 2.0) {
+    cerr << " openGL 2.0 is not available, plot windows will not share VBOs" 
+         << endl;
+    return;
   }
+
+  // Compile the shader
+  GLuint shader = glCreateShader( GL_VERTEX_SHADER);
+  glShaderSource( shader, 1, &axis_shader_source, NULL);
+  glCompileShader( shader);
+  GLint status = 0;
+  glGetShaderiv( shader, GL_COMPILE_STATUS, &status);
+  if( status == 0) {
+    cerr << " couldn't compile shader, plot windows will not share VBOs" 
+         << endl;
+    glDeleteShader( shader);
+    return;
+  }
+
+  // Link the program.  The shader is deleted when the program is.
+  GLuint program = glCreateProgram();
+  glAttachShader( program, shader);
+  glBindAttribLocation( program, 0, "xCoord");
+  glBindAttribLocation( program, 1, "yCoord");
+  glBindAttribLocation( program, 2, "zCoord");
+  glLinkProgram( program);
+  glDeleteShader( shader);
+  glGetProgramiv( program, GL_LINK_STATUS, &status);
+  if( status == 0) {
+    cerr << " couldn't link shader, plot windows will not share VBOs" << endl;
+    glDeleteProgram( program);
+    return;
+  }
+  CHECK_GL_ERROR( "building shader");
+  axis_program = program;
+  cerr << " initialized shader, plot windows will share VBOs" << endl;
 }
 
 //***************************************************************************
-// Plot_Window::fill_indexVBOs() -- Fill all the index VBOs
+// Plot_Window::bind_axes() -- Tell the GPU where to find the x, y, and z 
+// coordinates of this plot: in the shared VBOs of its normalized axes, or,
+// without VBOs, in the normalized axes themselves.  An axis without values 
+// (the z-axis when it is "-nothing-") is a constant zero.
+void Plot_Window::bind_axes()
+{
+  glUseProgram( axis_program);
+  glDisableClientState( GL_VERTEX_ARRAY);
+  for( int k=0; k<3; k++) {
+    const Normalized_Axis &axis = axes_[ k];
+    if( axis.values.rows() < npoints || npoints <= 0) {
+      glDisableVertexAttribArray( k);
+      glVertexAttrib1f( k, 0.0);
+      continue;
+    }
+    if( use_VBOs) {
+      if( !Axis_Cache::has_buffer( axisBuffers_[ k]))
+        axisBuffers_[ k] = Axis_Cache::acquire_buffer( axis);
+      glBindBuffer( GL_ARRAY_BUFFER, axisBuffers_[ k]);
+      glVertexAttribPointer( k, 1, GL_FLOAT, GL_FALSE, 0, BUFFER_OFFSET(0));
+    }
+    else {
+      glBindBuffer( GL_ARRAY_BUFFER, 0);
+      glVertexAttribPointer( 
+        k, 1, GL_FLOAT, GL_FALSE, 0, (GLfloat *) axis.values.data());
+    }
+    glEnableVertexAttribArray( k);
+  }
+  CHECK_GL_ERROR( "binding shared axes");
+}
+
+//***************************************************************************
+// Plot_Window::unbind_axes() -- Restore the fixed-function vertex array 
+// state changed by bind_axes().
+void Plot_Window::unbind_axes()
+{
+  for( int k=0; k<3; k++) glDisableVertexAttribArray( k);
+  glBindBuffer( GL_ARRAY_BUFFER, 0);
+  glUseProgram( 0);
+  glEnableClientState( GL_VERTEX_ARRAY);
+}
+
+//***************************************************************************
+// Plot_Window::initialize_indexVBOs() -- Initialize the 'index VBO' that
+// holds the indices of the points of every brush, sorted by brush.
+// MCL XXX index VBOs hould probably be handled by the Brush class.
+void Plot_Window::initialize_indexVBOs() 
+{
+  if (!indexVBOsinitialized) {
+    // There is one shared index VBO for all plots and all brushes, bound 
+    // to MAXPLOTS+1.  Each brush draws its range of it.
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, MAXPLOTS+1);  // a safe place....
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) (npoints*sizeof(GLuint)), (void*) NULL, GL_DYNAMIC_DRAW);
+    indexVBOsinitialized = 1;
+
+    // A new buffer must be filled completely
+    mark_indices_changed( 0, npoints);
+  }
+}
+
+//***************************************************************************
+// Plot_Window::fill_indexVBOs() -- Upload the part of the index array that
+// changed since the index VBO was last filled.
 void Plot_Window::fill_indexVBOs() 
 {
   if (!indexVBOsfilled) {
-    for (int set=0; set<NBRUSHES; set++) {
-      fill_indexVBO(set);
+    if (indices_changed_end > indices_changed_begin) {
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, MAXPLOTS+1);
+      glBufferSubData( 
+        GL_ELEMENT_ARRAY_BUFFER, 
+        (GLintptr) (indices_changed_begin*sizeof(GLuint)), 
+        (GLsizeiptr) ((indices_changed_end-indices_changed_begin)*sizeof(GLuint)), 
+        indices_selected.data() + indices_changed_begin);
+      // make sure we succeeded 
+      CHECK_GL_ERROR("filling index VBO");
     }
+    indices_changed_begin = indices_changed_end = 0;
     indexVBOsfilled = 1;
   }
 }
 
+//***************************************************************************
+// Plot_Window::mark_indices_changed( iBegin, iEnd) -- STATIC method to note
+// that entries [iBegin, iEnd) of the index array changed, so they are 
+// uploaded the next time the index VBO is filled.  Changes accumulate as
+// the smallest range that holds them all.
+void Plot_Window::mark_indices_changed( unsigned int iBegin, unsigned int iEnd)
+{
+  if( iEnd <= iBegin) return;
+  if( indices_changed_end <= indices_changed_begin) {
+    indices_changed_begin = iBegin;
+    indices_changed_end = iEnd;
+  }
+  else {
+    indices_changed_begin = min( indices_changed_begin, iBegin);
+    indices_changed_end = max( indices_changed_end, iEnd);
+  }
+  indexVBOsfilled = 0;
+}
+
 
 //***************************************************************************
 // Define global methods.  NOTE: Is it a good idea to do this here rather 
@@ -8,7 +8,6 @@
 //
 // Classes referenced:
 //   Control_panel_window -- Control panel window
-//   MyCompare -- Member class used by std::stable_sort
 //
 // Required packages
 //    FLTK 1.1.6 -- Fast Light Toolkit graphics package
@@ -44,6 +43,21 @@
 // member variables of this class
 class Control_Panel_Window;
 
+// Include the Axis_Cache for struct Normalized_Axis
+#include "axis_cache.h"
+
+// Include the Point_Grid used by circle and lasso footprints
+#include "point_grid.h"
+
+// Include the Histogram_Kernel that bins the points of an axis
+#include "histogram_kernel.h"
+
+// Include the Auto_Binning used to choose the number of histogram bins
+#include "auto_binning.h"
+
+// Include the Density_Grid for smoothed density estimates
+#include "density_grid.h"
+
 //***************************************************************************
 // Class: Plot_Window
 //
@@ -69,9 +83,15 @@ class Control_Panel_Window;
 //
 //   initialize_VBO() -- Initialize VBO for this window
 //   fill_VBO() -- Fill the VBO for this window
-//   initialize_indexVBO( int) -- Initialize one brush's index VBO
-//   initialize_indexVBOs() -- Initialize all index VBOs
-//   fill_indexVBOs() -- Fill all index VBOs with the indices of the vertices they should plot.
+//   fill_vertices() -- Fill the interleaved vertices for this window
+//   interleave_axes( pVertex) -- Interleave the axes of this window
+//   initialize_axis_program() -- Build the shader that reads shared axes
+//   bind_axes() -- Point openGL at the shared axes of this window
+//   unbind_axes() -- Undo bind_axes()
+//   initialize_indexVBOs() -- Initialize the shared index VBO
+//   fill_indexVBOs() -- Fill the shared index VBO with the indices of the vertices to plot.
+//   mark_indices_changed( iBegin, iEnd) -- Mark part of the index array 
+//     for upload
 //
 //   draw() -- Draw plot
 //   draw_background() -- Draw background
@@ -90,25 +110,61 @@ class Control_Panel_Window;
 //
 //   handle( event) -- Main event handler
 //   handle_selection() -- update or change selection based on mouse position
+//   build_grid() -- Build the spatial grid of the points of this plot
+//   update_box_footprint( box_min, box_max) -- Update the selection for a 
+//     box that moved
+//   patch_indices_selected( removed, added) -- Move points between the 
+//     brushes' ranges of the index array
 //   run_timing_test() --
 //
 //   void screen_to_world( xs, ys, x, y) -- Screen to word coords (only works for 2D)
 //   void print_selection_stats() -- print number of points and % of points currently selected
 //
 //   compute_histogram( int) -- Compute histogram bin counts for one variable
-//   draw_x_histogram( bin_counts, nbins);
-//   draw_y_histogram( bin_counts, nbins);
+//   draw_x_histogram( bin_counts, nbins, pEdges);
+//   draw_y_histogram( bin_counts, nbins, pEdges);
 //   draw_histograms() --
-//   density_1D( a, axis) --
+//   update_density() -- Make sure the smoothed density of the points is 
+//     current
+//   density_2D( a) -- Smoothed density at each point
+//   draw_density() -- Draw the smoothed density behind the points
 //
 //   compute_histograms () -- Compute both histograms for marginals of 2D plot
 //   compute_rank(int var_index) create an array of indices that rank order a variable (basically a sort).
+//   histogram_settings( axis, nbins, brush_index, weighted, equi_depth) -- 
+//     Get histogram settings from the widgets
+//   histogram_nbins( axis) -- Number of bins set by the slider, or chosen 
+//     automatically
+//   fill_histogram( axis, nbins, brush_index, weighted, equi_depth, 
+//     nTasks) -- Compute histogram
+//   histogram_is_current( axis, nbins, weighted, equi_depth) -- Are the 
+//     cached counts of an axis up to date?
+//   rebuild_histogram( axis, nbins, weighted, equi_depth, nTasks) -- 
+//     Recompute the cached counts of an axis
+//   count_sorted_bins( axis) -- Marginal counts of an axis from its sorted
+//     order
+//   histogram_bin( axis, x) -- Bin of a value in the cached histogram
+//   patch_histogram( axis, removed, added) -- Move points between the 
+//     cached brush counts of an axis
+//   patch_histograms( removed, added, generation) -- Move points between 
+//     the cached brush counts of all plots
 //   normalize() -- Normalize data based on user-selected normalization scheme
+//   prepare_axis( axis_index, axis) -- Get label, rank, and cached data
+//   normalize_axis( axis_index, axis) -- Normalize data for one axis
+//   attach_axis( axis_index, axis) -- Show a normalized axis in this plot
 //
+//   vertex_components() -- Number of vertex components for these axes
+//   set_vertex_components( nComponents) -- Change the layout of the 
+//     interleaved vertices
 //   extract_data_points() -- Extract data for these axes
+//   extract_data_points( axis_index) -- Extract data for one changed axis
+//   extract_axis_data( axis_index) -- Rank, normalize, and copy one axis
+//   extract_all_data_points() -- Extract data for all plots in parallel
 //   transform_2d() -- Transform all (x,y) to (f(x,y), g(x,y))
 //   reset_selection_box() -- Reset selection box
 //   color_array_from_selection() -- Fill index arrays 
+//   count_brushes_task( pUser, iTask) -- Count the points of each brush
+//   scatter_brushes_task( pUser, iTask) -- Sort points by brush
 //   reset_view() -- Reset plot
 //   redraw_one_plot() -- Redraw one plot
 //   change_axes() -- Change axes of this plot
@@ -169,13 +225,31 @@ class Plot_Window : public Fl_Gl_Window
     // and have we filled it with our chunk of vertex data yet?
     bool VBOfilled;
     void fill_VBO();
+    void interleave_axes( float* pVertex);
     
-    // have we initialized the shared openGL index vertex buffer objects?
+    // If openGL 2.0 is available, the x, y, and z coordinates are read from
+    // separate arrays by a vertex shader, so each normalized axis is stored 
+    // on the graphics card once, in a VBO shared by all plots that show it
+    // (see Axis_Cache).  Otherwise the per-window VBO above is used.  On 
+    // the CPU side, the normalized axes are the only copy of the data 
+    // shown in this plot: selection and histograms work with them.
+    Normalized_Axis axes_[ 3];
+    unsigned int axisBuffers_[ 3];
+    static GLuint axis_program;
+    static int axis_program_initialized;
+    static void initialize_axis_program();
+    void bind_axes();
+    void unbind_axes();
+
+    // have we initialized the shared openGL index vertex buffer object?
     static int indexVBOsinitialized;
     void initialize_indexVBOs();
-    // and are they filled with the latest index data?
+    // and is it filled with the latest index data?  If not, which part of
+    // the index array must be uploaded?
     static int indexVBOsfilled;
     void fill_indexVBOs();
+    static unsigned int indices_changed_begin, indices_changed_end;
+    static void mark_indices_changed( unsigned int iBegin, unsigned int iEnd);
     
     // Draw routines
     void draw();
@@ -201,9 +275,26 @@ class Plot_Window : public Fl_Gl_Window
     
     void screen_to_world(float xs, float ys, float &x, float &y);
     void update_selection_from_footprint();
+
+    // Spatial grid of the (x,y) points of this plot, used by circle and 
+    // lasso footprints, and the vertices of the lasso being drawn, as 
+    // (x,y) pairs
+    Point_Grid grid_;
+    int gridValid_;
+    void build_grid();
+    std::vector<float> lasso_;
+
+    // Box and brush settings of the last footprint, so successive drag 
+    // events only have to update the points whose state changes
+    int footprintValid_, footprintBrush_, footprintPaint_, footprintMask_;
+    float footprintMin_[2], footprintMax_[2];
+    void update_box_footprint( const float box_min[2], const float box_max[2]);
+    static void patch_indices_selected( 
+      std::vector<unsigned int> removed[], std::vector<unsigned int> added[]);
     void print_selection_stats();
     void interval_to_strings (const int column, const float x1, const float x2, char *buf1, char *buf2);
-    void select_on_string(const char *str,int col);
+    void select_on_string(
+      const char *str, int col, int useRegex, int ignoreCase);
     void center_on_click(int x, int y);
 
     // Event parameters
@@ -222,10 +313,67 @@ class Plot_Window : public Fl_Gl_Window
     blitz::Array<float,2> counts, counts_selected;
     float xhscale, yhscale;
     void compute_histogram( int);
-    void draw_x_histogram(const blitz::Array<float,1>bin_counts, const int nbins);
-    void draw_y_histogram(const blitz::Array<float,1>bin_counts, const int nbins);
+    int histogram_settings( 
+      int axis, int &nbins, int &brush_index, int &weighted, 
+      int &equi_depth);
+    int histogram_nbins( int axis);
+
+    // Bin counts chosen automatically by rule autoBinsMethod_ for the axis 
+    // values attached when autoBins_ was set (if nonzero), and the range and
+    // number of points they were chosen for.
+    int autoBins_[ 2], autoBinsMethod_[ 2], autoBinsNpoints_[ 2];
+    float autoBinsMin_[ 2], autoBinsMax_[ 2];
+    void fill_histogram( 
+      int axis, int nbins, int brush_index, int weighted, int equi_depth, 
+      int nTasks = 0);
+
+    // Cached histograms of the x- and y-axes, kept as raw (unnormalized) 
+    // counts of all points and of the points of each brush, so changing the
+    // brush or redrawing costs O(nbins).  The counts of brush i are 
+    // brushCounts_[ axis][ i*histNbins_[ axis] + bin].  They are valid for
+    // the axis values attached when histValid_ was set, the bin count, 
+    // weighting, range, and number of points they were computed for, and 
+    // the selection of generation histSelection_.  Equi-depth histograms
+    // have bins with (nearly) equal numbers of points, whose edges, taken
+    // from the sorted order of the axis, are histEdges_[ axis].
+    int histValid_[ 2], histNbins_[ 2], histWeighted_[ 2], histNpoints_[ 2];
+    int histEquiDepth_[ 2];
+    unsigned int histSelection_[ 2];
+    float histMin_[ 2], histMax_[ 2], histScale_[ 2];
+    std::vector<float> histEdges_[ 2];
+    std::vector<double> marginalCounts_[ 2], brushCounts_[ 2];
+    int histogram_is_current( 
+      int axis, int nbins, int weighted, int equi_depth) const;
+    void rebuild_histogram( 
+      int axis, int nbins, int weighted, int equi_depth, int nTasks = 0);
+    void count_sorted_bins( int axis);
+    int histogram_bin( int axis, float x) const;
+    void patch_histogram( 
+      int axis, const std::vector<unsigned int> removed[], 
+      const std::vector<unsigned int> added[]);
+    static void patch_histograms( 
+      const std::vector<unsigned int> removed[], 
+      const std::vector<unsigned int> added[], unsigned int generation);
+    void draw_x_histogram(
+      const blitz::Array<float,1>bin_counts, const int nbins, 
+      const float* pEdges);
+    void draw_y_histogram(
+      const blitz::Array<float,1>bin_counts, const int nbins, 
+      const float* pEdges);
     void draw_histograms();
-    void density_1D (blitz::Array<float,1>a, const int axis);
+
+    // Smoothed density of the (x,y) points, computed for the axis values 
+    // attached when densityValid_ was set, their ranges, and the 
+    // bandwidths densityBandwidth_.  densityTexture_ holds it as an image
+    // if densityTextureValid_ is set.
+    Density_Grid densityGrid_;
+    int densityValid_, densityNpoints_;
+    float densityMin_[ 2], densityMax_[ 2], densityBandwidth_[ 2];
+    GLuint densityTexture_;
+    int densityTextureValid_;
+    int update_density();
+    void density_2D( blitz::Array<float,1> a);
+    void draw_density();
 
     int show_center_glyph;
     int selection_changed;
@@ -242,10 +390,6 @@ class Plot_Window : public Fl_Gl_Window
     void load_state();
     static int active_plot;
 
-    // Initialize and fill index VBO for this window
-    void initialize_indexVBO(int);
-    void fill_indexVBO(int);
-
     // true min and max of the data before normalization and transformation
     float tmin[3], tmax[3];
 
@@ -255,8 +399,18 @@ class Plot_Window : public Fl_Gl_Window
     // (the X and Y axes lines bound the left and bottom edges of this "window")
     float wmin[3], wmax[3];
 
-    // openGL vertices of points to be plotted
+    // Interleaved openGL vertices of points to be plotted, needed only if
+    // neither the shader for shared axes nor VBOs can be used, the number
+    // of components of each vertex (two if the z-axis is "-nothing-", 
+    // otherwise three), and the number of points whose axes were 
+    // extracted, which is zero before the first extraction
     blitz::Array<float,2> vertices;
+    bool verticesFilled;
+    void fill_vertices();
+    int nComponents_;
+    int nExtracted_;
+    int vertex_components();
+    void set_vertex_components( int nComponents);
 
     // indices of points when ranked according to their x, y, or z coordinate 
     // respectively
@@ -266,13 +420,23 @@ class Plot_Window : public Fl_Gl_Window
     static const int nbins_default = 128;
     static const int nbins_max = 1024;
 
+    // largest number of nodes along each axis of a density grid
+    static const int density_nodes_max = 512;
+
     // Routines to compute histograms and normalize data
     void compute_rank(int var_index);
     void compute_histograms();
     int normalize( 
       blitz::Array<float,1> a, 
       blitz::Array<int,1> a_rank, 
-      int style, int axis_index);
+      int style, int axis_index, int delta);
+    int prepare_axis( int axis_index, Normalized_Axis &axis);
+    void normalize_axis( int axis_index, Normalized_Axis &axis);
+    void attach_axis( int axis_index, const Normalized_Axis &axis);
+
+    // Worker_Pool tasks for extract_all_data_points()
+    static void normalize_task( void* pUser, int jcol);
+    static void extract_task( void* pUser, int iPlot);
 
     // Define strings to hold axis labels
     std::string xlabel, ylabel, zlabel;
@@ -287,17 +451,22 @@ class Plot_Window : public Fl_Gl_Window
 
     // More plot routines
     int extract_data_points();
+    int extract_data_points( int axis_index);
+    void extract_axis_data( int axis_index);
+    static void extract_all_data_points();
     int transform_2d();
 
     // Routines and variables to handle point colors and selection
     void reset_selection_box();
     void color_array_from_selection();
+    static void count_brushes_task( void* pUser, int iTask);
+    static void scatter_brushes_task( void* pUser, int iTask);
     void update_selection_color_table ();
 
     // Routines to redraw plots
     void reset_view();
     void redraw_one_plot();
-    void change_axes( int nchange);
+    void change_axes( int nchange, int doExtract = 1);
     float angle;
     int needs_redraw;
     unsigned do_reset_view_with_show;
@@ -321,8 +490,19 @@ class Plot_Window : public Fl_Gl_Window
     static int sfactor;
     static int dfactor;
 
-    // Indices of points for rendering, packed acording to selection state;
-    static blitz::Array<unsigned int,2> indices_selected; 
+    // Indices of points for rendering, sorted by brush.  The indices of 
+    // the points of brush i, in ascending order, are the brushes[i]->count
+    // indices starting at indices_start[i].
+    static blitz::Array<unsigned int,1> indices_selected; 
+    static unsigned int indices_start[ NBRUSHES];
+
+    // Generation of the selection, incremented whenever the brushes of the
+    // points are reassigned wholesale, so cached histograms know when they
+    // have to be recomputed, and the generation the index array was last 
+    // sorted for, so they know whether it can be used to find the points 
+    // of each brush
+    static unsigned int selection_generation;
+    static unsigned int indices_generation;
 
     // point sprites-specific data
     static int sprites_initialized;
@@ -0,0 +1,344 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: point_grid.cpp
+//
+// Class definitions:
+//   Point_Grid -- Uniform grid of the points of a 2D plot
+//
+// Classes referenced:
+//   Bit_Mask -- Array of flags packed into 64-bit words
+//
+// Required packages
+//    Blitz++ 0.9 -- Various math routines
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <point_grid.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "point_grid.h"
+
+// Average number of points per cell, and the largest number of cells along
+// each axis
+static const double POINTS_PER_CELL = 32.0;
+static const int MAX_CELLS_PER_AXIS = 1024;
+
+// Cells are enlarged by this fraction of their size when they are
+// classified, to allow for rounding when points were binned
+static const float CELL_MARGIN = 1.0e-3;
+
+// Cell states used by select_polygon()
+enum { CELL_UNKNOWN = 0, CELL_BOUNDARY = 1};
+
+// Column or row of the cell at F cells from the origin, clamped to the
+// N cells of the grid.  Clamping is done before the conversion to int, so
+// far-away vertices can't overflow.
+static inline int clamp_cell( float f, int n)
+{
+  if( !( f > 0)) return 0;
+  if( f > n-1) return n-1;
+  return (int) f;
+}
+
+//***************************************************************************
+// segment_hits_box( x0, y0, x1, y1, bounds) -- Does the segment from
+// (x0,y0) to (x1,y1) touch the box BOUNDS = { xlo, xhi, ylo, yhi}?  Uses
+// Liang-Barsky clipping.
+static int segment_hits_box(
+  float x0, float y0, float x1, float y1, const float bounds[4])
+{
+  float t0 = 0.0, t1 = 1.0;
+  float p[4] = { x0-x1, x1-x0, y0-y1, y1-y0};
+  float q[4] = { x0-bounds[0], bounds[1]-x0, y0-bounds[2], bounds[3]-y0};
+  for( int k=0; k<4; k++) {
+    if( p[k] == 0) {
+      if( q[k] < 0) return 0;
+      continue;
+    }
+    float t = q[k] / p[k];
+    if( p[k] < 0) {
+      if( t > t1) return 0;
+      if( t > t0) t0 = t;
+    }
+    else {
+      if( t < t0) return 0;
+      if( t < t1) t1 = t;
+    }
+  }
+  return 1;
+}
+
+//***************************************************************************
+// Point_Grid::Point_Grid() -- Default constructor makes an empty grid.
+Point_Grid::Point_Grid() : n_( 0), nx_( 0), ny_( 0),
+  xmin_( 0.0), ymin_( 0.0), dx_( 1.0), dy_( 1.0)
+{}
+
+//***************************************************************************
+// Point_Grid::build( x, y, n) -- Bin the first N points, with coordinates
+// X and Y, into cells that cover their bounding box, using a counting sort
+// of the points by cell.
+void Point_Grid::build(
+  const blitz::Array<float,1> &x, const blitz::Array<float,1> &y, int n)
+{
+  free();
+  if( n <= 0) return;
+  const float* px = x.data();
+  const float* py = y.data();
+  int xStride = x.stride( 0), yStride = y.stride( 0);
+
+  // Find the bounding box of the points that can be plotted
+  int nFinite = 0;
+  float xmax = 0.0, ymax = 0.0;
+  for( int i=0; i<n; i++) {
+    float xi = px[ i*xStride], yi = py[ i*yStride];
+    if( !is_finite( xi) || !is_finite( yi)) continue;
+    if( nFinite == 0) {
+      xmin_ = xmax = xi;
+      ymin_ = ymax = yi;
+    }
+    else {
+      xmin_ = min( xmin_, xi);
+      xmax = max( xmax, xi);
+      ymin_ = min( ymin_, yi);
+      ymax = max( ymax, yi);
+    }
+    nFinite++;
+  }
+
+  // Choose the number and size of the cells
+  int nSide = (int) sqrt( nFinite / POINTS_PER_CELL);
+  nx_ = ny_ = max( 1, min( MAX_CELLS_PER_AXIS, nSide));
+  dx_ = ( xmax - xmin_) / nx_;
+  dy_ = ( ymax - ymin_) / ny_;
+  if( dx_ <= 0) dx_ = 1.0;
+  if( dy_ <= 0) dy_ = 1.0;
+
+  // Count the points in each cell, turn the counts into starting positions,
+  // and store the points
+  int nCells = nx_*ny_;
+  cell_start_.assign( nCells+1, 0);
+  for( int i=0; i<n; i++) {
+    float xi = px[ i*xStride], yi = py[ i*yStride];
+    if( !is_finite( xi) || !is_finite( yi)) continue;
+    cell_start_[ cell_index( xi, yi) + 1]++;
+  }
+  for( int c=0; c<nCells; c++) cell_start_[ c+1] += cell_start_[ c];
+  std::vector<unsigned int> next( cell_start_.begin(), cell_start_.end()-1);
+  points_.resize( nFinite);
+  for( int i=0; i<n; i++) {
+    float xi = px[ i*xStride], yi = py[ i*yStride];
+    if( !is_finite( xi) || !is_finite( yi)) continue;
+    points_[ next[ cell_index( xi, yi)]++] = i;
+  }
+  n_ = n;
+}
+
+//***************************************************************************
+// Point_Grid::free() -- Release memory and make the grid empty.
+void Point_Grid::free()
+{
+  n_ = nx_ = ny_ = 0;
+  std::vector<unsigned int>().swap( cell_start_);
+  std::vector<unsigned int>().swap( points_);
+}
+
+//***************************************************************************
+// Point_Grid::select_polygon( pPolygon, nVertices, x, y, inside) -- Set the
+// flags in INSIDE of the points, with coordinates X and Y, that lie inside
+// the polygon with NVERTICES vertices ( pPolygon[ 2*i], pPolygon[ 2*i+1]).
+// The polygon is closed implicitly and may intersect itself, in which case
+// the even-odd rule applies.  Flags of other points are left alone.
+void Point_Grid::select_polygon(
+  const float* pPolygon, int nVertices,
+  const blitz::Array<float,1> &x, const blitz::Array<float,1> &y,
+  Bit_Mask &inside) const
+{
+  if( !is_built() || nVertices < 3) return;
+  const float* px = x.data();
+  const float* py = y.data();
+  int xStride = x.stride( 0), yStride = y.stride( 0);
+  std::vector<unsigned char> state( nx_*ny_, (unsigned char) CELL_UNKNOWN);
+  float bounds[ 4];
+
+  // Loop: Mark the cells that an edge passes through as boundary cells
+  for( int i=0; i<nVertices; i++) {
+    int j = ( i+1) % nVertices;
+    float x0 = pPolygon[ 2*i], y0 = pPolygon[ 2*i+1];
+    float x1 = pPolygon[ 2*j], y1 = pPolygon[ 2*j+1];
+    int ixlo = clamp_cell( floor( ( min( x0, x1) - xmin_) / dx_) - 1, nx_);
+    int ixhi = clamp_cell( floor( ( max( x0, x1) - xmin_) / dx_) + 1, nx_);
+    int iylo = clamp_cell( floor( ( min( y0, y1) - ymin_) / dy_) - 1, ny_);
+    int iyhi = clamp_cell( floor( ( max( y0, y1) - ymin_) / dy_) + 1, ny_);
+    for( int iy=iylo; iy<=iyhi; iy++) {
+      for( int ix=ixlo; ix<=ixhi; ix++) {
+        if( state[ ix + nx_*iy] == CELL_BOUNDARY) continue;
+        cell_bounds( ix, iy, bounds);
+        if( segment_hits_box( x0, y0, x1, y1, bounds)) {
+          state[ ix + nx_*iy] = CELL_BOUNDARY;
+        }
+      }
+    }
+  }
+
+  // Loop: Classify the other cells of each row by the number of edges that
+  // cross the center line of the row to the left of their centers.  No
+  // edge passes through these cells, so their centers speak for all their
+  // points.
+  std::vector<float> crossings;
+  for( int iy=0; iy<ny_; iy++) {
+    float yc = ymin_ + ( iy+0.5) * dy_;
+    crossings.clear();
+    for( int i=0; i<nVertices; i++) {
+      int j = ( i+1) % nVertices;
+      float x0 = pPolygon[ 2*i], y0 = pPolygon[ 2*i+1];
+      float x1 = pPolygon[ 2*j], y1 = pPolygon[ 2*j+1];
+      if( ( y0 > yc) != ( y1 > yc)) {
+        crossings.push_back( x0 + ( yc-y0) * ( x1-x0) / ( y1-y0));
+      }
+    }
+    std::sort( crossings.begin(), crossings.end());
+    unsigned int nLeft = 0;
+    for( int ix=0; ix<nx_; ix++) {
+      float xc = xmin_ + ( ix+0.5) * dx_;
+      while( nLeft < crossings.size() && crossings[ nLeft] < xc) nLeft++;
+      if( state[ ix + nx_*iy] == CELL_BOUNDARY || nLeft % 2 == 0) continue;
+      const unsigned int *pBegin, *pEnd;
+      cell_points( ix, iy, pBegin, pEnd);
+      set_points( pBegin, pEnd, inside);
+    }
+  }
+
+  // Loop: Test the points of each boundary cell against the edges that
+  // overlap the cell in y, one edge at a time for all the points, which
+  // keeps the inner loop short and free of branches.
+  std::vector<float> xCell, yCell;
+  std::vector<unsigned char> parity;
+  for( int iy=0; iy<ny_; iy++) {
+    for( int ix=0; ix<nx_; ix++) {
+      if( state[ ix + nx_*iy] != CELL_BOUNDARY) continue;
+      const unsigned int *pBegin, *pEnd;
+      cell_points( ix, iy, pBegin, pEnd);
+      int nCell = pEnd - pBegin;
+      if( nCell == 0) continue;
+      cell_bounds( ix, iy, bounds);
+      xCell.resize( nCell);
+      yCell.resize( nCell);
+      parity.assign( nCell, 0);
+      for( int m=0; m<nCell; m++) {
+        xCell[ m] = px[ pBegin[ m]*xStride];
+        yCell[ m] = py[ pBegin[ m]*yStride];
+      }
+      for( int i=0; i<nVertices; i++) {
+        int j = ( i+1) % nVertices;
+        float x0 = pPolygon[ 2*i], y0 = pPolygon[ 2*i+1];
+        float x1 = pPolygon[ 2*j], y1 = pPolygon[ 2*j+1];
+        if( y0 == y1 || max( y0, y1) < bounds[ 2] || min( y0, y1) > bounds[ 3]) {
+          continue;
+        }
+        float slope = ( x1-x0) / ( y1-y0);
+        for( int m=0; m<nCell; m++) {
+          parity[ m] ^=
+            ( ( y0 > yCell[ m]) != ( y1 > yCell[ m])) &
+            ( xCell[ m] < x0 + ( yCell[ m]-y0) * slope);
+        }
+      }
+      for( int m=0; m<nCell; m++) {
+        if( parity[ m]) inside.set( pBegin[ m], 1);
+      }
+    }
+  }
+}
+
+//***************************************************************************
+// Point_Grid::select_ellipse( xc, yc, xs, ys, r2, x, y, inside) -- Set the
+// flags in INSIDE of the points, with coordinates X and Y, for which
+// ((x-xc)*xs)^2 + ((y-yc)*ys)^2 <= R2.  Flags of other points are left
+// alone.
+void Point_Grid::select_ellipse(
+  float xc, float yc, float xs, float ys, float r2,
+  const blitz::Array<float,1> &x, const blitz::Array<float,1> &y,
+  Bit_Mask &inside) const
+{
+  if( !is_built()) return;
+  const float* px = x.data();
+  const float* py = y.data();
+  int xStride = x.stride( 0), yStride = y.stride( 0);
+  float bounds[ 4];
+  for( int iy=0; iy<ny_; iy++) {
+    for( int ix=0; ix<nx_; ix++) {
+      cell_bounds( ix, iy, bounds);
+
+      // Skip cells whose nearest point is outside, select all the points of
+      // cells whose farthest corner is inside, and test the others
+      float xNear = min( max( xc, bounds[ 0]), bounds[ 1]);
+      float yNear = min( max( yc, bounds[ 2]), bounds[ 3]);
+      if( pow2( ( xNear-xc)*xs) + pow2( ( yNear-yc)*ys) > r2) continue;
+      float xFar = ( fabs( bounds[ 0]-xc) > fabs( bounds[ 1]-xc)) ? bounds[ 0] : bounds[ 1];
+      float yFar = ( fabs( bounds[ 2]-yc) > fabs( bounds[ 3]-yc)) ? bounds[ 2] : bounds[ 3];
+      const unsigned int *pBegin, *pEnd;
+      cell_points( ix, iy, pBegin, pEnd);
+      if( pow2( ( xFar-xc)*xs) + pow2( ( yFar-yc)*ys) <= r2) {
+        set_points( pBegin, pEnd, inside);
+        continue;
+      }
+      for( const unsigned int* p=pBegin; p<pEnd; p++) {
+        float xi = px[ (*p)*xStride], yi = py[ (*p)*yStride];
+        if( pow2( ( xi-xc)*xs) + pow2( ( yi-yc)*ys) <= r2) inside.set( *p, 1);
+      }
+    }
+  }
+}
+
+//***************************************************************************
+// Point_Grid::cell_index( x, y) -- Index of the cell that holds (x,y).
+// Points on the upper edges of the grid go in the last cells.
+int Point_Grid::cell_index( float x, float y) const
+{
+  int ix = min( nx_-1, max( 0, (int) ( ( x - xmin_) / dx_)));
+  int iy = min( ny_-1, max( 0, (int) ( ( y - ymin_) / dy_)));
+  return ix + nx_*iy;
+}
+
+//***************************************************************************
+// Point_Grid::cell_bounds( ix, iy, bounds) -- Bounds of cell (ix,iy),
+// enlarged by CELL_MARGIN, as { xlo, xhi, ylo, yhi}.
+void Point_Grid::cell_bounds( int ix, int iy, float bounds[4]) const
+{
+  bounds[ 0] = xmin_ + ( ix - CELL_MARGIN) * dx_;
+  bounds[ 1] = xmin_ + ( ix + 1 + CELL_MARGIN) * dx_;
+  bounds[ 2] = ymin_ + ( iy - CELL_MARGIN) * dy_;
+  bounds[ 3] = ymin_ + ( iy + 1 + CELL_MARGIN) * dy_;
+}
+
+//***************************************************************************
+// Point_Grid::cell_points( ix, iy, pBegin, pEnd) -- Set [pBegin, pEnd) to
+// the indices of the points in cell (ix,iy).
+void Point_Grid::cell_points(
+  int ix, int iy, const unsigned int* &pBegin,
+  const unsigned int* &pEnd) const
+{
+  int c = ix + nx_*iy;
+  pBegin = pEnd = NULL;
+  if( points_.empty()) return;
+  pBegin = &points_[ 0] + cell_start_[ c];
+  pEnd = &points_[ 0] + cell_start_[ c+1];
+}
+
+//***************************************************************************
+// Point_Grid::set_points( pBegin, pEnd, inside) -- STATIC method to set the
+// flags in INSIDE of the points [pBegin, pEnd).
+void Point_Grid::set_points(
+  const unsigned int* pBegin, const unsigned int* pEnd, Bit_Mask &inside)
+{
+  for( const unsigned int* p=pBegin; p<pEnd; p++) inside.set( *p, 1);
+}
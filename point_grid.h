@@ -0,0 +1,110 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: point_grid.h
+//
+// Class definitions:
+//   Point_Grid -- Uniform grid of the points of a 2D plot
+//
+// Classes referenced:
+//   Bit_Mask -- Array of flags packed into 64-bit words
+//
+// Required packages
+//    Blitz++ 0.9 -- Various math routines
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Spatial index used to find the points of a plot that lie inside
+//   a circle or a free-form (lasso) polygon without testing every point.
+//
+// General design philosophy:
+//   1) The grid covers the bounding box of the points with square-ish
+//      cells that hold a few dozen points each.  The points of each cell
+//      are stored together, in a single permutation of the point indices.
+//   2) A footprint classifies each cell as inside, outside, or on its
+//      boundary.  Points in cells that are inside are selected as a block,
+//      points in cells that are outside are never looked at, and only
+//      points in boundary cells are tested one by one.
+//   3) Cells are classified with slightly enlarged bounds, so points that
+//      rounding put in a neighboring cell are still handled correctly.
+//   4) The grid holds indices only.  The coordinates are passed in when it
+//      is built and used, and must not have changed in between.
+//   5) build() touches nothing but its arguments and the grid, so grids of
+//      different plots can be built at the same time on worker threads.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef POINT_GRID_H
+#define POINT_GRID_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include the Bit_Mask for the flags of the selected points
+#include "bit_mask.h"
+
+//***************************************************************************
+// Class: Point_Grid
+//
+// Class definitions:
+//   Point_Grid -- Uniform grid of the points of a 2D plot
+//
+// Classes referenced:
+//   Bit_Mask
+//
+// Purpose: Bin the points of a plot into cells, and select the points that
+//   lie inside a polygon or an ellipse cell by cell.
+//
+// Functions:
+//   Point_Grid() -- Default constructor
+//   build( x, y, n) -- Bin the first n points
+//   free() -- Release memory
+//   is_built() -- Has the grid been built?
+//   select_polygon( pPolygon, nVertices, x, y, inside) -- Flag the points
+//     inside a polygon
+//   select_ellipse( xc, yc, xs, ys, r2, x, y, inside) -- Flag the points
+//     inside an ellipse
+//   cell_bounds( ix, iy, bounds) -- Enlarged bounds of a cell
+//   cell_points( ix, iy, pBegin, pEnd) -- Points of a cell
+//   set_points( pBegin, pEnd, inside) -- Flag all points of a cell
+//***************************************************************************
+class Point_Grid
+{
+  public:
+    Point_Grid();
+    void build(
+      const blitz::Array<float,1> &x, const blitz::Array<float,1> &y, int n);
+    void free();
+    int is_built() const { return n_ > 0;}
+    void select_polygon(
+      const float* pPolygon, int nVertices,
+      const blitz::Array<float,1> &x, const blitz::Array<float,1> &y,
+      Bit_Mask &inside) const;
+    void select_ellipse(
+      float xc, float yc, float xs, float ys, float r2,
+      const blitz::Array<float,1> &x, const blitz::Array<float,1> &y,
+      Bit_Mask &inside) const;
+
+  protected:
+    // Number of points and cells, origin and size of the cells.  The cell
+    // of point i is ix + nx_*iy.
+    int n_, nx_, ny_;
+    float xmin_, ymin_, dx_, dy_;
+
+    // Indices of the points of cell c are points_[ cell_start_[ c]] ...
+    // points_[ cell_start_[ c+1]-1].  Points with NaN or infinite 
+    // coordinates aren't in any cell.
+    std::vector<unsigned int> cell_start_;
+    std::vector<unsigned int> points_;
+
+    int cell_index( float x, float y) const;
+    void cell_bounds( int ix, int iy, float bounds[4]) const;
+    void cell_points(
+      int ix, int iy, const unsigned int* &pBegin,
+      const unsigned int* &pEnd) const;
+    static void set_points(
+      const unsigned int* pBegin, const unsigned int* pEnd, Bit_Mask &inside);
+};
+
+#endif   // POINT_GRID_H
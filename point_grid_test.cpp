@@ -0,0 +1,126 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: point_grid_test.cpp
+//
+// Class definitions: none
+//
+// Classes referenced:
+//   Point_Grid -- Uniform grid of the points of a 2D plot
+//   Bit_Mask -- Array of flags packed into 64-bit words
+//
+// Required packages
+//    Blitz++ 0.9 -- Various math routines
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Stand-alone check that a Point_Grid ignores points with NaN or
+//   infinite coordinates, which must neither be binned nor selected.
+//   Build and run with 'make test'.  It should be built with the same 
+//   (e.g., -ffast-math) flags as vp, since those are what broke it.
+//
+// Functions:
+//   Point_Grid_Probe -- Point_Grid with its layout made visible
+//   main() -- Run the checks and report the number of failures
+//***************************************************************************
+
+// Define the globals here, since vp.cpp isn't linked
+#define DEFINE_GLOBALS 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "point_grid.h"
+
+// Point_Grid whose layout can be inspected
+class Point_Grid_Probe : public Point_Grid
+{
+  public:
+    int n_binned() const { return (int) points_.size();}
+    float xmin() const { return xmin_;}
+    float xmax() const { return xmin_ + nx_*dx_;}
+    float ymin() const { return ymin_;}
+    float ymax() const { return ymin_ + ny_*dy_;}
+};
+
+//***************************************************************************
+// main() -- Build a grid of points on a line, some of whose coordinates are
+// NaN or infinite, and select with ellipses that cover everything and that
+// cover only a few of the points.  Returns the number of failures.
+int main()
+{
+  const int n = 1000;
+  float fNaN, fInf;
+  unsigned int uNaN = 0x7FC00000u, uInf = 0x7F800000u;
+  memcpy( &fNaN, &uNaN, sizeof( fNaN));
+  memcpy( &fInf, &uInf, sizeof( fInf));
+
+  // Points lie on the line y = x, 0 <= x < 1, except that every tenth point
+  // has a NaN, +Inf, or -Inf coordinate
+  blitz::Array<float,1> x( n), y( n);
+  for( int i=0; i<n; i++) {
+    x( i) = y( i) = (float) i / n;
+    if( i % 10 == 1) x( i) = fNaN;
+    if( i % 10 == 2) y( i) = fInf;
+    if( i % 10 == 3) x( i) = -fInf;
+    if( i % 10 == 4) y( i) = fNaN;
+  }
+  Point_Grid_Probe grid;
+  grid.build( x, y, n);
+
+  // Only the finite points may be binned, and the grid must cover no more
+  // than their bounding box
+  int nFailures = 0;
+  int nFinite = n - 4 * ( n / 10);
+  if( !grid.is_built()) {
+    cout << "FAILED: grid wasn't built" << endl;
+    nFailures++;
+  }
+  if( grid.n_binned() != nFinite) {
+    cout << "FAILED: " << grid.n_binned() << " points were binned instead of "
+         << nFinite << endl;
+    nFailures++;
+  }
+  if( !( grid.xmin() >= 0.0 && grid.xmax() <= 1.01 &&
+         grid.ymin() >= 0.0 && grid.ymax() <= 1.01)) {
+    cout << "FAILED: grid covers ( " << grid.xmin() << "..." << grid.xmax()
+         << ", " << grid.ymin() << "..." << grid.ymax()
+         << ") instead of ( 0...1, 0...1)" << endl;
+    nFailures++;
+  }
+
+  // An ellipse that covers every finite point must select exactly those
+  Bit_Mask inside;
+  inside.resize( n);
+  grid.select_ellipse( 0.5, 0.5, 1.0, 1.0, 4.0, x, y, inside);
+  for( int i=0; i<n; i++) {
+    int isFinite = ( i % 10 < 1 || i % 10 > 4);
+    if( inside.get( i) != isFinite) {
+      cout << "FAILED: point " << i << " ( " << x( i) << ", " << y( i)
+           << ") was " << ( isFinite ? "not " : "") << "selected" << endl;
+      nFailures++;
+    }
+  }
+
+  // A small circle must select only its neighbors
+  inside.resize( n);
+  grid.select_ellipse( 0.5, 0.5, 1.0, 1.0, 1.0e-4, x, y, inside);
+  for( int i=0; i<n; i++) {
+    float d = (float) i / n - 0.5;
+    int isNear = ( i % 10 < 1 || i % 10 > 4) && 2*d*d <= 1.0e-4;
+    if( inside.get( i) != isNear) {
+      cout << "FAILED: point " << i << " near ( 0.5, 0.5) was "
+           << ( isNear ? "not " : "") << "selected" << endl;
+      nFailures++;
+    }
+  }
+
+  if( nFailures == 0) cout << "point_grid_test: all checks passed" << endl;
+  else cout << "point_grid_test: " << nFailures << " failures" << endl;
+  return nFailures;
+}
@@ -0,0 +1,206 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: rank_engine.cpp
+//
+// Class definitions:
+//   Rank_Engine -- Radix sort ranking engine
+//
+// Classes referenced:
+//   Worker_Pool -- Pool of worker threads
+//
+// Required packages
+//    POSIX threads (pthreads-win32 under Windows)
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <rank_engine.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "rank_engine.h"
+#include "worker_pool.h"
+
+// Number of buckets per radix digit
+static const int NBUCKETS = 1 << Rank_Engine::RADIX_BITS;
+
+// State of one call to rank(), shared by its tasks.  During each pass, keys
+// and indices are read from KEYS and INDICES and written to KEYS_OUT and 
+// INDICES_OUT.  COUNTS holds a row of NBUCKETS digit counts for each task, 
+// which are later converted to the position where that task writes the 
+// first value with each digit.
+struct Rank_Run {
+  const float* pData;
+  int stride;
+  int n;
+  int nTasks;
+  int shift;
+  unsigned int* keys;
+  unsigned int* keys_out;
+  int* indices;
+  int* indices_out;
+  std::vector<int> counts;
+};
+
+//***************************************************************************
+// Rank_Engine::sort_key( x) -- Map a float to an unsigned integer key such 
+// that keys compare the way the floats do.  Flipping the sign bit of 
+// positive values and all bits of negative values does this for the IEEE 
+// format.  Negative zero is treated as zero, since the two compare equal, 
+// and NaNs are placed after everything else.  Negative zero is recognized
+// from its bits, NaN by is_nan(), since -ffast-math may fold comparisons.
+unsigned int Rank_Engine::sort_key( float x)
+{
+  if( is_nan( x)) return 0xFFFFFFFFu;
+  unsigned int u;
+  memcpy( &u, &x, sizeof( u));
+  if( u == 0x80000000u) u = 0;
+  if( u & 0x80000000u) return ~u;
+  return u | 0x80000000u;
+}
+
+//***************************************************************************
+// Rank_Engine::rank( pData, stride, n, pRanks) -- Store in PRANKS the 
+// indices of the N floats PDATA[ 0], PDATA[ STRIDE], ... in ascending 
+// order.  Equal values stay in index order.  Passes in which every value 
+// has the same digit are skipped, which is common for the high digits.
+void Rank_Engine::rank( const float* pData, int stride, int n, int* pRanks)
+{
+  if( n <= 0) return;
+
+  int nTasks = Worker_Pool::n_tasks_for( n);
+
+  std::vector<unsigned int> keys( n), keys_out( n);
+  std::vector<int> indices_out( n);
+  Rank_Run run;
+  run.pData = pData;
+  run.stride = stride;
+  run.n = n;
+  run.nTasks = nTasks;
+  run.keys = &keys[ 0];
+  run.keys_out = &keys_out[ 0];
+  run.indices = pRanks;
+  run.indices_out = &indices_out[ 0];
+  run.counts.resize( nTasks * NBUCKETS);
+
+  // Generate the keys and the identity permutation
+  Worker_Pool::run_tasks( key_task, (void*) &run, nTasks);
+
+  // Loop: Sort on successive digits, starting with the least significant
+  for( run.shift = 0; run.shift < 32; run.shift += RADIX_BITS) {
+    Worker_Pool::run_tasks( count_task, (void*) &run, nTasks);
+
+    // Convert counts to starting positions.  Buckets are visited in order,
+    // and within each bucket, tasks are visited in order of their slices.
+    int offset = 0, isTrivial = 0;
+    for( int iBucket = 0; iBucket < NBUCKETS; iBucket++) {
+      int nInBucket = 0;
+      for( int iTask = 0; iTask < nTasks; iTask++) {
+        int nCount = run.counts[ iTask*NBUCKETS + iBucket];
+        run.counts[ iTask*NBUCKETS + iBucket] = offset;
+        offset += nCount;
+        nInBucket += nCount;
+      }
+      if( nInBucket == n) isTrivial = 1;
+    }
+    if( isTrivial) continue;
+
+    Worker_Pool::run_tasks( scatter_task, (void*) &run, nTasks);
+    std::swap( run.keys, run.keys_out);
+    std::swap( run.indices, run.indices_out);
+  }
+
+  // If the sorted indices ended up in the scratch buffer, copy them
+  if( run.indices != pRanks)
+    memcpy( pRanks, run.indices, (size_t) n * sizeof( int));
+}
+
+//***************************************************************************
+// Rank_Engine::finite_range( pData, stride, pRanks, n, iBegin, iEnd) -- Set
+// [ IBEGIN, IEND) to the part of the ranking PRANKS, as found by rank(), 
+// that holds the finite values.  -Inf comes before it, and +Inf and NaN 
+// after it, so both ends are found by binary search on the sort keys.
+void Rank_Engine::finite_range(
+  const float* pData, int stride, const int* pRanks, int n,
+  int &iBegin, int &iEnd)
+{
+  // Keys of -Inf and +Inf
+  const unsigned int minusInf = 0x007FFFFFu, plusInf = 0xFF800000u;
+
+  // Find the first value above -Inf, then the first at or above +Inf
+  int iLow = 0, iHigh = n;
+  while( iLow < iHigh) {
+    int iMid = iLow + ( iHigh-iLow)/2;
+    if( sort_key( pData[ pRanks[ iMid]*stride]) <= minusInf) iLow = iMid+1;
+    else iHigh = iMid;
+  }
+  iBegin = iLow;
+  iHigh = n;
+  while( iLow < iHigh) {
+    int iMid = iLow + ( iHigh-iLow)/2;
+    if( sort_key( pData[ pRanks[ iMid]*stride]) < plusInf) iLow = iMid+1;
+    else iHigh = iMid;
+  }
+  iEnd = iLow;
+}
+
+//***************************************************************************
+// Rank_Engine::key_task( pUser, iTask) -- Worker_Pool task to generate the 
+// keys and the identity permutation for slice ITASK.
+void Rank_Engine::key_task( void* pUser, int iTask)
+{
+  Rank_Run* run = (Rank_Run*) pUser;
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, run->nTasks, run->n, iBegin, iEnd);
+  const float* pData = run->pData;
+  size_t stride = run->stride;
+  for( int i=iBegin; i<iEnd; i++) {
+    run->keys[ i] = sort_key( pData[ i*stride]);
+    run->indices[ i] = i;
+  }
+}
+
+//***************************************************************************
+// Rank_Engine::count_task( pUser, iTask) -- Worker_Pool task to count the 
+// current digit of the keys in slice ITASK.
+void Rank_Engine::count_task( void* pUser, int iTask)
+{
+  Rank_Run* run = (Rank_Run*) pUser;
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, run->nTasks, run->n, iBegin, iEnd);
+  int* counts = &( run->counts[ iTask*NBUCKETS]);
+  memset( counts, 0, NBUCKETS * sizeof( int));
+  const unsigned int* keys = run->keys;
+  int shift = run->shift;
+  for( int i=iBegin; i<iEnd; i++) 
+    counts[ ( keys[ i] >> shift) & ( NBUCKETS-1)]++;
+}
+
+//***************************************************************************
+// Rank_Engine::scatter_task( pUser, iTask) -- Worker_Pool task to move the 
+// keys and indices of slice ITASK to their positions for the current 
+// digit.
+void Rank_Engine::scatter_task( void* pUser, int iTask)
+{
+  Rank_Run* run = (Rank_Run*) pUser;
+  int iBegin, iEnd;
+  Worker_Pool::task_range( iTask, run->nTasks, run->n, iBegin, iEnd);
+  int* positions = &( run->counts[ iTask*NBUCKETS]);
+  const unsigned int* keys = run->keys;
+  const int* indices = run->indices;
+  unsigned int* keys_out = run->keys_out;
+  int* indices_out = run->indices_out;
+  int shift = run->shift;
+  for( int i=iBegin; i<iEnd; i++) {
+    int iPosition = positions[ ( keys[ i] >> shift) & ( NBUCKETS-1)]++;
+    keys_out[ iPosition] = keys[ i];
+    indices_out[ iPosition] = indices[ i];
+  }
+}
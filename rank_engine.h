@@ -0,0 +1,77 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: rank_engine.h
+//
+// Class definitions:
+//   Rank_Engine -- Radix sort ranking engine
+//
+// Classes referenced:
+//   Worker_Pool -- Pool of worker threads
+//
+// Required packages
+//    POSIX threads (pthreads-win32 under Windows)
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Compute the permutation that rank orders a column of data, for
+//   use in normalization and histograms.
+//
+// General design philosophy:
+//   1) Floats are mapped to unsigned keys whose order is the order of the 
+//      floats, then (key, index) pairs are sorted with a least significant 
+//      digit radix sort.  Every pass is stable, so values that compare 
+//      equal stay in index order, exactly as with std::stable_sort.
+//   2) Each pass is split among the threads of a Worker_Pool.  Every 
+//      thread counts digits in its own slice, and the counts are combined 
+//      in slice order, which keeps the sort stable.
+//   3) There are no globals or statics, so several columns can be ranked 
+//      at the same time on different threads.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef RANK_ENGINE_H
+#define RANK_ENGINE_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+//***************************************************************************
+// Class: Rank_Engine
+//
+// Class definitions:
+//   Rank_Engine -- Radix sort ranking engine
+//
+// Classes referenced: none
+//
+// Purpose: Static methods to rank order an array of floats.
+//
+// Functions:
+//   rank( pData, stride, n, pRanks) -- Rank order N floats
+//   sort_key( x) -- Unsigned key with the same order as X
+//   finite_range( pData, stride, pRanks, n, iBegin, iEnd) -- Find the
+//     ranked values that are finite
+//***************************************************************************
+class Rank_Engine
+{
+  public:
+    static void rank( const float* pData, int stride, int n, int* pRanks);
+    static unsigned int sort_key( float x);
+    static void finite_range(
+      const float* pData, int stride, const int* pRanks, int n,
+      int &iBegin, int &iEnd);
+
+    // Define static to hold the number of bits per radix digit
+    static const int RADIX_BITS = 11;
+
+  protected:
+    static void key_task( void* pUser, int iTask);
+    static void count_task( void* pUser, int iTask);
+    static void scatter_task( void* pUser, int iTask);
+};
+
+#endif   // RANK_ENGINE_H
@@ -0,0 +1,268 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: rank_scheduler.cpp
+//
+// Class definitions:
+//   Rank_Scheduler -- Background ranking of columns
+//
+// Classes referenced:
+//   Column_Info -- Column information
+//   Rank_Engine -- Radix sort ranking engine
+//
+// Required packages
+//    FLTK 1.1.6 -- Fast Light Toolkit graphics package
+//    POSIX threads (pthreads-win32 under Windows)
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <rank_scheduler.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "rank_scheduler.h"
+#include "rank_engine.h"
+#include "data_file_manager.h"
+#include "control_panel_window.h"
+
+// Description of one column to be ranked.  The data pointer, stride, and 
+// number of points are captured on the main thread when the job is queued.
+// The background thread fills in the ranks and the range of the data.
+struct Rank_Job {
+  int jcol;
+  const float* pData;
+  int stride;
+  int n;
+  int* pRanks;
+  float minValue, maxValue;
+};
+
+// State shared by the main thread and the background thread.  Everything 
+// but isThreadStarted and the done callback is protected by the mutex.
+static pthread_mutex_t scheduler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_available = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_finished = PTHREAD_COND_INITIALIZER;
+static std::vector<Rank_Job> queued_jobs;
+static std::vector<Rank_Job> finished_jobs;
+static int jcolRunning = -1;
+static int isThreadStarted = 0;
+static Rank_Scheduler::Done_Function pDoneFunction = NULL;
+static void* pDoneUser = NULL;
+
+// Interval, in seconds, at which the main thread collects results
+static const double COLLECT_INTERVAL = 0.1;
+
+//***************************************************************************
+// Rank_Scheduler::start( done, pUser) -- Queue a job for every column that
+// isn't ranked, beginning with the columns shown in the plot windows, and 
+// start the background thread if necessary.  When all of these have been
+// ranked, call DONE( PUSER), if DONE isn't NULL.  If there is no background
+// thread, DONE is called at once.
+void Rank_Scheduler::start( Done_Function done, void* pUser)
+{
+  stop();
+
+  // Build the list of columns, shown columns first
+  std::vector<int> order;
+  for( int i=0; i<nplots; i++) {
+    if( cps[i] == NULL) continue;
+    order.push_back( cps[i]->varindex1->value());
+    order.push_back( cps[i]->varindex2->value());
+    order.push_back( cps[i]->varindex3->value());
+  }
+  for( int j=0; j<nvars; j++) order.push_back( j);
+
+  if( start_thread() != 0) {
+    if( done != NULL) done( pUser);
+    return;
+  }
+
+  // Loop: Queue a job for each unranked column
+  pthread_mutex_lock( &scheduler_mutex);
+  for( unsigned int k=0; k<order.size(); k++) {
+    int jcol = order[ k];
+    if( jcol < 0 || jcol >= nvars || npoints <= 0) continue;
+    Column_Info &info = Data_File_Manager::column_info[ jcol];
+    if( info.rank_state() != Column_Info::UNRANKED) continue;
+    Rank_Job job;
+    job.jcol = jcol;
+    job.pData = (info.points).data();
+    job.stride = (info.points).stride( 0);
+    job.n = npoints;
+    job.pRanks = NULL;
+    job.minValue = job.maxValue = 0.0;
+    queued_jobs.push_back( job);
+    info.rank_state( Column_Info::RANKING);
+  }
+  pDoneFunction = done;
+  pDoneUser = pUser;
+  pthread_cond_signal( &work_available);
+  pthread_mutex_unlock( &scheduler_mutex);
+
+  // Collect results periodically
+  Fl::add_timeout( COLLECT_INTERVAL, cb_collect, NULL);
+}
+
+//***************************************************************************
+// Rank_Scheduler::stop() -- Cancel queued jobs, wait for the job in 
+// progress, if any, and discard all results that haven't been adopted.  
+// Columns that were waiting become unranked again.  The done callback is
+// cancelled.
+void Rank_Scheduler::stop()
+{
+  Fl::remove_timeout( cb_collect, NULL);
+  pDoneFunction = NULL;
+  pDoneUser = NULL;
+  if( !isThreadStarted) return;
+
+  pthread_mutex_lock( &scheduler_mutex);
+  queued_jobs.erase( queued_jobs.begin(), queued_jobs.end());
+  while( jcolRunning >= 0)
+    pthread_cond_wait( &job_finished, &scheduler_mutex);
+  for( unsigned int k=0; k<finished_jobs.size(); k++)
+    delete[] finished_jobs[ k].pRanks;
+  finished_jobs.erase( finished_jobs.begin(), finished_jobs.end());
+  pthread_mutex_unlock( &scheduler_mutex);
+
+  // Columns that were queued or in progress are now unranked
+  for( int j=0; j<nvars && j<(int) (Data_File_Manager::column_info).size(); j++) {
+    Column_Info &info = Data_File_Manager::column_info[ j];
+    if( info.rank_state() == Column_Info::RANKING)
+      info.rank_state( Column_Info::UNRANKED);
+  }
+}
+
+//***************************************************************************
+// Rank_Scheduler::claim( jcol) -- Make sure no background job will work on 
+// column JCOL.  If its job is queued, take it back, and if it is in 
+// progress, wait for it to finish.  Then adopt any finished results.  
+// Called before a column is ranked on the main thread.
+void Rank_Scheduler::claim( int jcol)
+{
+  if( !isThreadStarted) return;
+
+  pthread_mutex_lock( &scheduler_mutex);
+  for( unsigned int k=0; k<queued_jobs.size(); k++) {
+    if( queued_jobs[ k].jcol == jcol) {
+      queued_jobs.erase( queued_jobs.begin() + k);
+      break;
+    }
+  }
+  while( jcolRunning == jcol)
+    pthread_cond_wait( &job_finished, &scheduler_mutex);
+  pthread_mutex_unlock( &scheduler_mutex);
+
+  collect();
+
+  // If the job was taken back, the column is no longer being ranked
+  Column_Info &info = Data_File_Manager::column_info[ jcol];
+  if( info.rank_state() == Column_Info::RANKING)
+    info.rank_state( Column_Info::UNRANKED);
+}
+
+//***************************************************************************
+// Rank_Scheduler::collect() -- Adopt the ranks computed by finished jobs.  
+// Results for columns that have been ranked in the meantime are discarded.
+void Rank_Scheduler::collect()
+{
+  if( !isThreadStarted) return;
+
+  pthread_mutex_lock( &scheduler_mutex);
+  std::vector<Rank_Job> jobs;
+  jobs.swap( finished_jobs);
+  pthread_mutex_unlock( &scheduler_mutex);
+
+  for( unsigned int k=0; k<jobs.size(); k++) {
+    Column_Info &info = Data_File_Manager::column_info[ jobs[ k].jcol];
+    if( jobs[ k].pRanks != NULL && info.rank_state() == Column_Info::RANKING)
+      info.adopt_ranks( 
+        jobs[ k].pRanks, jobs[ k].n, jobs[ k].minValue, jobs[ k].maxValue);
+    else {
+      delete[] jobs[ k].pRanks;
+      if( info.rank_state() == Column_Info::RANKING)
+        info.rank_state( Column_Info::UNRANKED);
+    }
+  }
+}
+
+//***************************************************************************
+// Rank_Scheduler::cb_collect( pUser) -- Static FLTK timeout callback to 
+// collect results until no jobs remain, then call the done callback, if 
+// any.
+void Rank_Scheduler::cb_collect( void* pUser)
+{
+  pthread_mutex_lock( &scheduler_mutex);
+  int isBusy = !queued_jobs.empty() || jcolRunning >= 0;
+  pthread_mutex_unlock( &scheduler_mutex);
+  collect();
+  if( isBusy) {
+    Fl::repeat_timeout( COLLECT_INTERVAL, cb_collect, NULL);
+    return;
+  }
+
+  Done_Function done = pDoneFunction;
+  void* pDoneData = pDoneUser;
+  pDoneFunction = NULL;
+  pDoneUser = NULL;
+  if( done != NULL) done( pDoneData);
+}
+
+//***************************************************************************
+// Rank_Scheduler::start_thread() -- Start the background thread if it isn't
+// already running.  Returns 0 if the thread is running.
+int Rank_Scheduler::start_thread()
+{
+  if( isThreadStarted) return 0;
+  pthread_t thread;
+  if( pthread_create( &thread, NULL, thread_main, NULL) != 0) {
+    cerr << "Rank_Scheduler::start_thread: couldn't start thread, "
+         << "columns will be ranked as needed" << endl;
+    return -1;
+  }
+  pthread_detach( thread);
+  isThreadStarted = 1;
+  return 0;
+}
+
+//***************************************************************************
+// Rank_Scheduler::thread_main( pUser) -- Body of the background thread: 
+// take queued jobs one at a time and rank them.  The thread never calls 
+// FLTK or touches Column_Info objects.
+void* Rank_Scheduler::thread_main( void* pUser)
+{
+  pthread_mutex_lock( &scheduler_mutex);
+  while( 1) {
+    while( queued_jobs.empty())
+      pthread_cond_wait( &work_available, &scheduler_mutex);
+    Rank_Job job = queued_jobs.front();
+    queued_jobs.erase( queued_jobs.begin());
+    jcolRunning = job.jcol;
+    pthread_mutex_unlock( &scheduler_mutex);
+
+    // Rank the column.  If memory runs out, give up on this column; it 
+    // will be ranked on the main thread if it is needed.
+    try {
+      job.pRanks = new int[ job.n];
+      Rank_Engine::rank( job.pData, job.stride, job.n, job.pRanks);
+      job.minValue = job.pData[ (size_t) job.pRanks[ 0] * job.stride];
+      job.maxValue = job.pData[ (size_t) job.pRanks[ job.n-1] * job.stride];
+    }
+    catch( std::bad_alloc &) {
+      delete[] job.pRanks;
+      job.pRanks = NULL;
+    }
+
+    pthread_mutex_lock( &scheduler_mutex);
+    finished_jobs.push_back( job);
+    jcolRunning = -1;
+    pthread_cond_broadcast( &job_finished);
+  }
+  return NULL;
+}
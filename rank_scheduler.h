@@ -0,0 +1,84 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: rank_scheduler.h
+//
+// Class definitions:
+//   Rank_Scheduler -- Background ranking of columns
+//
+// Classes referenced:
+//   Column_Info -- Column information
+//   Rank_Engine -- Radix sort ranking engine
+//
+// Required packages
+//    FLTK 1.1.6 -- Fast Light Toolkit graphics package
+//    POSIX threads (pthreads-win32 under Windows)
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Rank columns on a background thread after data are loaded, so 
+//   the first plot of each column doesn't have to wait for a sort.
+//
+// General design philosophy:
+//   1) Only the main (FLTK) thread touches Column_Info objects.  The 
+//      background thread reads the data through raw pointers captured when 
+//      a job is queued and writes ranks to a private buffer, which the main
+//      thread later adopts.  So the rank state of a column can be read on 
+//      the main thread without locks.
+//   2) Any method that changes or moves column data MUST call stop() 
+//      first.  stop() waits for the job in progress and discards the rest.
+//   3) Plot_Window::compute_rank() calls claim() for the column it needs: 
+//      a queued job is taken back and run on the main thread, and a job in
+//      progress is waited for, so no column is ranked twice.
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef RANK_SCHEDULER_H
+#define RANK_SCHEDULER_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+//***************************************************************************
+// Class: Rank_Scheduler
+//
+// Class definitions:
+//   Rank_Scheduler -- Background ranking of columns
+//
+// Classes referenced: none
+//
+// Purpose: Static methods to queue, claim, and collect background ranking
+//   jobs.  All public methods must be called from the main (FLTK) thread.
+//
+// Functions:
+//   start( done, pUser) -- Queue every unranked column
+//   stop() -- Cancel queued jobs and wait for the job in progress
+//   claim( jcol) -- Make sure no background job is working on a column
+//   collect() -- Adopt the results of finished jobs
+//
+//   cb_collect( pUser) -- Static FLTK timeout callback to collect results
+//   thread_main( pUser) -- Body of the background thread
+//***************************************************************************
+class Rank_Scheduler
+{
+  public:
+    // Signature of the function called when every queued column has been 
+    // ranked
+    typedef void (*Done_Function)( void* pUser);
+
+    static void start( Done_Function done = NULL, void* pUser = NULL);
+    static void stop();
+    static void claim( int jcol);
+    static void collect();
+
+  protected:
+    static void cb_collect( void* pUser);
+    static void* thread_main( void* pUser);
+    static int start_thread();
+};
+
+#endif   // RANK_SCHEDULER_H
@@ -182,6 +182,7 @@ Fl_Help_View *help_view_widget;
 Fl_Check_Button* expertButton;
 Fl_Check_Button* trivialColumnsButton;
 Fl_Check_Button* preserveOldDataButton;
+Fl_Check_Button* cacheButton;
 Fl_Check_Button* laptopModeButton;
 Fl_Input* maxpoints_input;
 Fl_Input* maxvars_input;
@@ -260,6 +261,10 @@ void usage()
        << "Read input data from FILENAME." << endl;
   cerr << "  -I, --stdin                 "
        << "Read input data from stdin." << endl;
+  cerr << "  -k, --cache=(T,F)           "
+       << "Read and write .vpc cache files next to input" << endl
+       << "                              "
+       << "files, default=FALSE." << endl;
   cerr << "  -l, --laptop_mode      "
        << "Shrink control panel to fit in a laptop screen" << endl;
   cerr << "  -L, --commented_labels      "
@@ -274,6 +279,10 @@ void usage()
        << "Set the value of unreadable, nonnumeric, empty," << endl
        << "                              "
        << "or missing data to NUMBER, default=0.0." << endl;
+  cerr << "  -N, --no_mmap               "
+       << "Don't memory-map binary input files, read and" << endl
+       << "                              "
+       << "copy them instead." << endl;
   cerr << "  -n, --npoints=NPOINTS       "
        << "Read at most NPOINTS from input file, default is" << endl
        << "                              "
@@ -289,6 +298,10 @@ void usage()
        << "default=2." << endl;
   cerr << "  -s, --skip_lines=NLINES     "
        << "Skip NLINES at start of input file, default=0." << endl;
+  cerr << "  -T, --threads=NTHREADS      "
+       << "Use NTHREADS threads to read and process data," << endl
+       << "                              "
+       << "default is one per processor." << endl;
   cerr << "  -t, --trivial_columns=(T,F) "
        << "Remove columns with a single value, default=TRUE." << endl;
   cerr << "  -v, --nvars=NVARS           "
@@ -493,6 +506,7 @@ void create_broadcast_group ()
   cp->no_transform->deactivate();
   cp->cond_prop->deactivate();
   cp->fluctuation->deactivate();
+  cp->xy_density->deactivate();
 
   // Initially, this group has no axes (XXX or anything else, for that matter)
   cp->varindex1->value(nvars);  // initially == "-nothing-"
@@ -868,17 +882,13 @@ void manage_plot_window_array( Fl_Widget *o, void* user_data)
     }
 
     // If this is an INITIALIZE, REFRESH_WINDOWS, or NEW_DATA operation, 
-    // test for missing data, extract data, reset panels, and make them 
-    // resizable.  Otherwise it must be a RELOAD operation (which is no
-    // longer supported!), and we must invoke the relevant Plot_Window 
-    // member functions to initialize and draw panels.
+    // make panels resizable.  Data are extracted for all panels at once 
+    // below.  Otherwise it must be a RELOAD operation (which is no longer 
+    // supported!), and we must invoke the relevant Plot_Window member 
+    // functions to initialize and draw panels.
     if( thisOperation == INITIALIZE || 
         thisOperation == REFRESH_WINDOWS || 
         thisOperation == NEW_DATA) {
-      if( npoints > 1) {
-        pws[i]->extract_data_points();
-        pws[i]->reset_view();
-      }
       pws[i]->size_range( 10, 10);
       pws[i]->resizable( pws[i]);
     }
@@ -929,6 +939,15 @@ void manage_plot_window_array( Fl_Widget *o, void* user_data)
     pws[i]->do_reset_view_with_show = 1;
   }
 
+  // If this was an INITIALIZE, REFRESH_WINDOWS, or NEW_DATA operation, test
+  // for missing data, then extract data and reset the views of all panels.
+  // The CPU-bound work is done in parallel.
+  if( ( thisOperation == INITIALIZE || 
+        thisOperation == REFRESH_WINDOWS || 
+        thisOperation == NEW_DATA) && npoints > 1) {
+    Plot_Window::extract_all_data_points();
+  }
+
   // Set the color arrays to make sure points get drawn.
   pws[0]->color_array_from_selection();
   
@@ -1223,7 +1242,7 @@ void make_options_window( Fl_Widget *o)
    
   // Create Tools|Options window
   Fl::scheme( "plastic");  // optional
-  options_window = new Fl_Window( 300, 250, "Options");
+  options_window = new Fl_Window( 300, 275, "Options");
   options_window->begin();
   options_window->selection_color( FL_BLUE);
   options_window->labelsize( 10);
@@ -1318,10 +1337,19 @@ void make_options_window( Fl_Widget *o)
     o->tooltip( "Tiny control panel and fonts for small laptop screens");
   }
   
+  // Cache files checkbox
+  {
+    Fl_Check_Button* o = cacheButton = 
+      new Fl_Check_Button( 10, 210, 250, 20, " Use Cache Files (.vpc)");
+    o->down_box( FL_DOWN_BOX);
+    o->value( cache_mode == true);
+    o->tooltip( "Save data and ranks in a cache file next to each input file to speed up later reads");
+  }
+  
   // Invoke a multi-purpose callback function to process window
-  Fl_Button* ok_button = new Fl_Button( 150, 220, 40, 25, "&OK");
+  Fl_Button* ok_button = new Fl_Button( 150, 245, 40, 25, "&OK");
   ok_button->callback( (Fl_Callback*) cb_options_window, ok_button);
-  Fl_Button* cancel = new Fl_Button( 200, 220, 60, 25, "&Cancel");
+  Fl_Button* cancel = new Fl_Button( 200, 245, 60, 25, "&Cancel");
   cancel->callback( (Fl_Callback*) cb_options_window, cancel);
 
   // Done creating the 'Help|Options' window
@@ -1355,6 +1383,10 @@ void cb_options_window( Fl_Widget *o, void* user_data)
     prefs_.set( "preserve_old_data_mode", i_preserve_old_data_mode);
     preserve_old_data_mode = ( i_preserve_old_data_mode != 0);
 
+    int i_cache_mode = cacheButton->value();
+    prefs_.set( "cache_mode", i_cache_mode);
+    cache_mode = ( i_cache_mode != 0);
+
     int i_use_VBOs_mode = use_VBOs_Button->value();
     // prefs_.set( "use_VBOs_mode", i_use_VBOs_mode);
     use_VBOs = ( i_use_VBOs_mode != 0);
@@ -1547,12 +1579,13 @@ void make_global_widgets()
 void change_all_axes( Fl_Widget *o)
 {
   // Loop: Examine successive plots and change the axes of those for which 
-  // the x or y axis is unlocked.
+  // the x or y axis is unlocked, then extract the data for all plots at once.
   for( int i=0; i<nplots; i++) {
     if( !( cps[i]->lock_axis1_button->value() && 
            cps[i]->lock_axis2_button->value()))
-      pws[i]->change_axes( 0);
+      pws[i]->change_axes( 0, 0);
   }
+  Plot_Window::extract_all_data_points();
   Plot_Window::redraw_all_plots(0);
 }
 
@@ -2187,17 +2220,21 @@ void redraw_if_changing( void *dummy)
 // reset_selection_arrays() -- Reset selection arrays to 'unselected'.
 void reset_selection_arrays()
 {
-  inside_footprint = 0;
-  newly_selected = 0;
+  inside_footprint.clear();
+  newly_selected.clear();
   selected = 0;
   previously_selected = 0;
   saved_selection = 0;
   nselected = 0;
   selection_is_inverted = false;
-  Plot_Window::indices_selected = 0;
   for( int i=0; i<npoints; i++) {
-    Plot_Window::indices_selected(0,i) = i;
+    Plot_Window::indices_selected(i) = i;
+  }
+  Plot_Window::indices_start[0] = 0;
+  for( int i=1; i<NBRUSHES; i++) {
+    Plot_Window::indices_start[i] = npoints;
   }
+  Plot_Window::selection_generation++;
 }
 
 //***************************************************************************
@@ -2249,8 +2286,10 @@ int main( int argc, char **argv)
     { "nvars", required_argument, 0, 'v'},
     { "skip_lines", required_argument, 0, 's'},
     { "trivial_columns", required_argument, 0, 't'},
+    { "threads", required_argument, 0, 'T'},
     { "ordering", required_argument, 0, 'o'},
     { "preserve_data", required_argument, 0, 'P'},
+    { "cache", required_argument, 0, 'k'},
     { "rows", required_argument, 0, 'r'},
     { "cols", required_argument, 0, 'c'},
     { "monitors", required_argument, 0, 'm'},
@@ -2260,6 +2299,7 @@ int main( int argc, char **argv)
     { "delimiter", required_argument, 0, 'd'},
     { "borderless", no_argument, 0, 'b'},
     { "no_vbo", no_argument, 0, 'B'},
+    { "no_mmap", no_argument, 0, 'N'},
     { "help", no_argument, 0, 'h'},
     { "laptop_mode", no_argument, 0, 'l'},
     { "commented_labels", no_argument, 0, 'L'},
@@ -2285,6 +2325,9 @@ int main( int argc, char **argv)
   int i_preserve_old_data_mode;
   prefs_.get( "preserve_old_data_mode", i_preserve_old_data_mode, 0);
   preserve_old_data_mode = ( i_preserve_old_data_mode != 0);
+  int i_cache_mode;
+  prefs_.get( "cache_mode", i_cache_mode, 0);
+  cache_mode = ( i_cache_mode != 0);
   int i_laptop_mode;
   prefs_.get( "laptop_mode", i_laptop_mode, 0);
   laptop_mode = ( i_laptop_mode != 0);
@@ -2306,7 +2349,7 @@ int main( int argc, char **argv)
   while( 
     ( c = getopt_long_only( 
         argc, argv, 
-        "f:n:v:s:t:o:P:r:c:m:i:C:M:d:bBhlLxOVIp", long_options, NULL)) != -1) {
+        "f:n:v:s:t:T:o:P:k:r:c:m:i:C:M:d:bBNhlLxOVIp", long_options, NULL)) != -1) {
   
     // Examine command-line options and extract any optional arguments
     switch( c) {
@@ -2368,6 +2411,15 @@ int main( int argc, char **argv)
         }
         break;
       
+      // threads: Extract the number of worker threads
+      case 'T':
+        nworker_threads = atoi( optarg);
+        if( nworker_threads < 1)  {
+          usage();
+          exit( -1);
+        }
+        break;
+
       // ordering: Extract the ordering of ("columnmajor or rowmajor") of a 
       // binary input file
       case 'o':
@@ -2393,6 +2445,18 @@ int main( int argc, char **argv)
         }
         break;
       
+      // cache_mode: Set flag to read and write cache files
+      case 'k':
+        if( !strncmp( optarg, "true", 1)) cache_mode = true;
+        else if( !strncmp( optarg, "TRUE", 1)) cache_mode = true;
+        else if( !strncmp( optarg, "false", 1)) cache_mode = false;
+        else if( !strncmp( optarg, "FALSE", 1)) cache_mode = false;
+        else {
+          usage();
+          exit( -1);
+        }
+        break;
+      
       // rows: Extract the number of rows of plot windows
       case 'r':
         nrows = atoi( optarg);
@@ -2464,6 +2528,11 @@ int main( int argc, char **argv)
         use_VBOs = false;
         break;
 
+      // don't memory-map binary input files
+      case 'N':
+        memory_map_mode = false;
+        break;
+
       // Laptop mode
       case 'l':
         laptop_mode = 1;
@@ -2526,6 +2595,9 @@ int main( int argc, char **argv)
   if( preserve_old_data_mode) i_preserve_old_data_mode = 1;
   else i_preserve_old_data_mode = 0;
   prefs_.set( "preserve_old_data_mode", i_preserve_old_data_mode);
+  if( cache_mode) i_cache_mode = 1;
+  else i_cache_mode = 0;
+  prefs_.set( "cache_mode", i_cache_mode);
   if( laptop_mode) i_laptop_mode = 1;
   else i_laptop_mode = 0;
   prefs_.set( "laptop_mode", i_laptop_mode);
@@ -0,0 +1,202 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: worker_pool.cpp
+//
+// Class definitions:
+//   Worker_Pool -- Pool of worker threads
+//
+// Classes referenced: none
+//
+// Required packages
+//    POSIX threads (pthreads-win32 under Windows)
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Source code for <worker_pool.h>
+//***************************************************************************
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Include associated headers and source code
+#include "worker_pool.h"
+
+// Bookkeeping for one call to run_tasks().  Threads take the next unclaimed
+// task under pool_mutex until none remain, and the caller waits until all
+// of them are done.
+struct Worker_Pool_Run {
+  Worker_Pool::Task_Function task;
+  void* pUser;
+  int nTasks;
+  int iNext;
+  int nDone;
+};
+
+// State of the pool.  Runs that still have unclaimed tasks wait in 
+// pending_runs, oldest first.  Everything is guarded by pool_mutex.
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_available = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t run_finished = PTHREAD_COND_INITIALIZER;
+static std::deque<Worker_Pool_Run*> pending_runs;
+static int nPoolThreads = 0;
+
+//***************************************************************************
+// Worker_Pool::n_threads() -- Number of threads to use: the value of
+// nworker_threads if this was set (e.g., by --threads), otherwise the
+// number of processors that are online.
+int Worker_Pool::n_threads()
+{
+  if( nworker_threads > 0) return nworker_threads;
+  int nProcessors = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+  nProcessors = (int) sysconf( _SC_NPROCESSORS_ONLN);
+#endif // _SC_NPROCESSORS_ONLN
+  if( nProcessors < 1) nProcessors = 1;
+  return nProcessors;
+}
+
+//***************************************************************************
+// Worker_Pool::n_tasks_for( n) -- Number of tasks to use for N items: one 
+// per MIN_ITEMS_PER_TASK items, but at least one and no more than there 
+// are threads, since threads aren't worth it for small data sets.
+int Worker_Pool::n_tasks_for( int n)
+{
+  int nTasks = n / MIN_ITEMS_PER_TASK;
+  if( nTasks > n_threads()) nTasks = n_threads();
+  if( nTasks < 1) nTasks = 1;
+  return nTasks;
+}
+
+//***************************************************************************
+// Worker_Pool::run_tasks( task, pUser, nTasks) -- Call task( pUser, i) for
+// i = 0...nTasks-1 on the threads of the pool and the calling thread, and
+// return when all calls have finished.  The calling thread does its share 
+// of the work.  If only one thread is available or thread creation fails, 
+// everything is done on the calling thread.
+void Worker_Pool::run_tasks( Task_Function task, void* pUser, int nTasks)
+{
+  if( nTasks <= 0) return;
+
+  // A single task or a single thread needs no bookkeeping
+  int nThreads = n_threads();
+  if( nTasks == 1 || nThreads == 1) {
+    for( int i=0; i<nTasks; i++) task( pUser, i);
+    return;
+  }
+  start_threads( nThreads-1);
+
+  Worker_Pool_Run run;
+  run.task = task;
+  run.pUser = pUser;
+  run.nTasks = nTasks;
+  run.iNext = 0;
+  run.nDone = 0;
+
+  // Queue the run and wake the pool, then work on the calling thread until
+  // there is nothing left to claim, then wait for the tasks that the pool 
+  // is still running.
+  pthread_mutex_lock( &pool_mutex);
+  pending_runs.push_back( &run);
+  pthread_cond_broadcast( &work_available);
+  pthread_mutex_unlock( &pool_mutex);
+
+  while( 1) {
+    pthread_mutex_lock( &pool_mutex);
+    int iTask = claim_task( &run);
+    pthread_mutex_unlock( &pool_mutex);
+    if( iTask < 0) break;
+    task( pUser, iTask);
+    pthread_mutex_lock( &pool_mutex);
+    finish_task( &run);
+    pthread_mutex_unlock( &pool_mutex);
+  }
+
+  pthread_mutex_lock( &pool_mutex);
+  while( run.nDone < run.nTasks) 
+    pthread_cond_wait( &run_finished, &pool_mutex);
+  pthread_mutex_unlock( &pool_mutex);
+}
+
+//***************************************************************************
+// Worker_Pool::task_range( iTask, nTasks, n, iBegin, iEnd) -- Divide N items
+// into NTASKS nearly equal contiguous slices and return the slice for task
+// ITASK as the half-open range [iBegin, iEnd).
+void Worker_Pool::task_range(
+  int iTask, int nTasks, int n, int &iBegin, int &iEnd)
+{
+  iBegin = (int) ( ( (double) n * iTask) / nTasks);
+  iEnd = (int) ( ( (double) n * (iTask+1)) / nTasks);
+  if( iTask == nTasks-1) iEnd = n;
+}
+
+//***************************************************************************
+// Worker_Pool::start_threads( nThreads) -- Start threads until the pool has
+// NTHREADS of them.  The threads are detached and run until the program 
+// exits.  If a thread can't be created, the pool makes do with fewer.
+void Worker_Pool::start_threads( int nThreads)
+{
+  pthread_mutex_lock( &pool_mutex);
+  while( nPoolThreads < nThreads) {
+    pthread_t thread;
+    if( pthread_create( &thread, NULL, worker_main, NULL) != 0) {
+      cerr << "Worker_Pool::start_threads: WARNING" << endl
+           << " -Couldn't create thread " << nPoolThreads+1 << endl;
+      break;
+    }
+    pthread_detach( thread);
+    nPoolThreads++;
+  }
+  pthread_mutex_unlock( &pool_mutex);
+}
+
+//***************************************************************************
+// Worker_Pool::claim_task( pRun) -- Return the index of the next unclaimed
+// task of run PRUN, or -1 if there is none.  Removes the run from the 
+// queue when its last task is claimed.  Must be called with pool_mutex 
+// held.
+int Worker_Pool::claim_task( Worker_Pool_Run* pRun)
+{
+  if( pRun->iNext >= pRun->nTasks) return -1;
+  int iTask = pRun->iNext++;
+  if( pRun->iNext >= pRun->nTasks) {
+    std::deque<Worker_Pool_Run*>::iterator iter = 
+      std::find( pending_runs.begin(), pending_runs.end(), pRun);
+    if( iter != pending_runs.end()) pending_runs.erase( iter);
+  }
+  return iTask;
+}
+
+//***************************************************************************
+// Worker_Pool::finish_task( pRun) -- Record that a task of run PRUN has
+// finished, and wake the caller if it was the last one.  Must be called
+// with pool_mutex held.
+void Worker_Pool::finish_task( Worker_Pool_Run* pRun)
+{
+  pRun->nDone++;
+  if( pRun->nDone >= pRun->nTasks) pthread_cond_broadcast( &run_finished);
+}
+
+//***************************************************************************
+// Worker_Pool::worker_main( pArg) -- Body of each thread of the pool: wait
+// for a run with unclaimed tasks, then claim and run its tasks, oldest run
+// first.  Never returns.
+void* Worker_Pool::worker_main( void* pArg)
+{
+  pthread_mutex_lock( &pool_mutex);
+  while( 1) {
+    while( pending_runs.empty()) 
+      pthread_cond_wait( &work_available, &pool_mutex);
+    Worker_Pool_Run* run = pending_runs.front();
+    int iTask = claim_task( run);
+    pthread_mutex_unlock( &pool_mutex);
+    (run->task)( run->pUser, iTask);
+    pthread_mutex_lock( &pool_mutex);
+    finish_task( run);
+  }
+  return NULL;
+}
@@ -0,0 +1,94 @@
+// viewpoints - interactive linked scatterplots and more.
+// copyright 2005 Creon Levit and Paul Gazis, all rights reserved.
+//***************************************************************************
+// File name: worker_pool.h
+//
+// Class definitions:
+//   Worker_Pool -- Pool of worker threads
+//
+// Classes referenced: none
+//
+// Required packages
+//    POSIX threads (pthreads-win32 under Windows)
+//
+// Compiler directives:
+//   May require D__WIN32__ for the C++ compiler
+//
+// Purpose: Run CPU-bound work (parsing, sorting, histogramming) on several
+//   threads at once.
+//
+// General design philosophy:
+//   1) Worker threads must NEVER call FLTK or openGL.  Only the main
+//      (FLTK) thread may do that.
+//   2) Work is described by a plain function pointer and a void* to its
+//      data, in the manner of the FLTK callbacks used everywhere else.
+//   3) A task number is handed to each call so the same function can work
+//      on different slices of the same data.
+//   4) The threads are started the first time they are needed and then
+//      wait for work, so a run costs a few lock operations rather than a
+//      thread creation per task.  Runs may be submitted by several threads
+//      at once (e.g., ranking in the background while a histogram is
+//      drawn), and each submitter works on its own run while it waits, so
+//      a task may itself call run_tasks().
+//***************************************************************************
+
+// Protection to make sure this header is not included twice
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H 1
+
+// Include the necessary include libraries
+#include "include_libraries_vp.h"
+
+// Include globals
+#include "global_definitions_vp.h"
+
+// Bookkeeping for one call to run_tasks(), defined in worker_pool.cpp
+struct Worker_Pool_Run;
+
+//***************************************************************************
+// Class: Worker_Pool
+//
+// Class definitions:
+//   Worker_Pool -- Pool of worker threads
+//
+// Classes referenced: none
+//
+// Purpose: Static methods to run a set of independent tasks on a set of
+//   persistent threads and wait for them to finish.
+//
+// Functions:
+//   n_threads() -- Number of threads to use
+//   n_tasks_for( n) -- Number of tasks worth using for n items
+//   run_tasks( task, pUser, nTasks) -- Run nTasks tasks and wait for them
+//   task_range( iTask, nTasks, n, iBegin, iEnd) -- Slice of n items for a
+//     task
+//   start_threads( nThreads) -- Make sure the pool has nThreads threads
+//   claim_task( pRun) -- Claim the next task of a run
+//   finish_task( pRun) -- Record that a task of a run has finished
+//   worker_main( pArg) -- Body of each thread of the pool
+//***************************************************************************
+class Worker_Pool
+{
+  public:
+    // Signature of a task.  PUSER points to data shared by all tasks of a
+    // run, ITASK is the index of this task, 0 <= iTask < nTasks.
+    typedef void (*Task_Function)( void* pUser, int iTask);
+
+    static int n_threads();
+    static int n_tasks_for( int n);
+    static void run_tasks( Task_Function task, void* pUser, int nTasks);
+    static void task_range(
+      int iTask, int nTasks, int n, int &iBegin, int &iEnd);
+
+    // Define static to hold the smallest number of items worth giving to a
+    // task of their own
+    static const int MIN_ITEMS_PER_TASK = 65536;
+
+  protected:
+    static void start_threads( int nThreads);
+    static int claim_task( Worker_Pool_Run* pRun);
+    static void finish_task( Worker_Pool_Run* pRun);
+    static void* worker_main( void* pArg);
+};
+
+#endif   // WORKER_POOL_H